@@ -153,6 +153,8 @@ int main()
 
     // compute positions
     placement::PlacementPipeline pipeline;
+    // density maps are edited interactively, so keep the candidates around and only re-evaluate them.
+    pipeline.setIncrementalMode(true);
     placement::WorldData world_data{/*scale=*/ {100.0f, 100.0f, 10.0f},
                                                /*heightmap=*/ textures.at(heightmap_filename)};
 
@@ -1,9 +1,9 @@
 #ifndef CPU_PLACEMENT
 #include "placement/placement.hpp"
 #else
-#include "cpu-placement.hpp"
-#include "stb_image.h"
+#include "placement/cpu/placement_pipeline.hpp"
 #include "placement/kernel/compute_kernel.hpp"
+#include "stb_image.h"
 #endif
 
 #include "example-common.hpp"
@@ -29,6 +29,28 @@
 using Clock = std::chrono::steady_clock;
 using nlohmann::json;
 
+// the CPU pipeline has the same interface as the GPU one, with images in place of the textures.
+#ifndef CPU_PLACEMENT
+namespace backend = placement;
+#else
+namespace backend = placement::cpu;
+
+/// Load a grayscale image as the CPU counterpart of a texture, which repeats by default.
+backend::Image loadImage(const std::string &filename)
+{
+    glm::ivec2 size;
+    const std::unique_ptr<stbi_uc[], void (*)(void *)> data
+            {stbi_load(filename.c_str(), &size.x, &size.y, nullptr, 1), stbi_image_free};
+
+    if (!data)
+        throw std::runtime_error(stbi_failure_reason());
+
+    backend::Image image = backend::Image::fromUnorm8(glm::uvec2(size), data.get());
+    image.setWrap(backend::Image::Wrap::repeat);
+    return image;
+}
+#endif
+
 static void logEvent(json& log_struct, const char* tag)
 {
     static const auto time_zero = Clock::now();
@@ -263,7 +285,7 @@ public:
     static const simple::VertexAttributeSequence attribute_sequence;
     static constexpr std::array attribute_locations{4, 5};
 
-    ResultMesh(const MeshData &mesh_data, const placement::Result &result, uint layer)
+    ResultMesh(const MeshData &mesh_data, const backend::Result &result, uint layer)
             : m_mesh(mesh_data.positions, mesh_data.normals, mesh_data.tex_coords, mesh_data.indices),
 #ifdef CPU_PLACEMENT
               m_handle(m_mesh.addInstanceData(attribute_locations, attribute_sequence, 1,
@@ -277,7 +299,7 @@ public:
         m_mesh.setInstanceCount(result.getClassElementCount(layer));
     }
 
-    void updateResult(const placement::Result &result, uint layer)
+    void updateResult(const backend::Result &result, uint layer)
     {
 #ifdef  CPU_PLACEMENT
         m_mesh.updateInstanceData(m_handle, result.getClassElementCount(layer), result.getClassElementData(layer));
@@ -305,7 +327,7 @@ class PlacementGroup
 {
 public:
 #ifdef CPU_PLACEMENT
-    using TextureIter = std::map<std::string, placement::GrayscaleImage>::const_iterator;
+    using TextureIter = std::map<std::string, backend::Image>::const_iterator;
 #else
     using TextureIter = std::map<std::string, simple::Texture2D>::const_iterator;
 #endif
@@ -318,7 +340,7 @@ public:
     void setFootprint(float diameter)
     { m_layer_data.footprint = diameter; }
 
-    void computePlacement(placement::PlacementPipeline &pipeline, placement::WorldData &world_data,
+    void computePlacement(backend::PlacementPipeline &pipeline, backend::WorldData &world_data,
                           glm::vec2 lower_bound, glm::vec2 upper_bound)
     {
         m_future_result = pipeline.computePlacement(world_data, m_layer_data, lower_bound, upper_bound);
@@ -360,9 +382,9 @@ public:
     void addLayer(TextureIter texture, MeshDataIter mesh)
     {
 #ifdef CPU_PLACEMENT
-        m_layer_data.densitymaps.emplace_back(placement::DensityMap{&texture->second});
+        m_layer_data.densitymaps.emplace_back(backend::DensityMap{&texture->second});
 #else
-        m_layer_data.densitymaps.emplace_back(placement::DensityMap{texture->second.getGLObject().getName()});
+        m_layer_data.densitymaps.emplace_back(backend::DensityMap{texture->second.getGLObject().getName()});
 #endif
         m_meshes.emplace_back();
         m_iters.emplace_back(texture, mesh);
@@ -381,7 +403,7 @@ public:
     void setLayerTexture(uint layer_index, TextureIter texture_iter)
     {
 #ifdef CPU_PLACEMENT
-        m_layer_data.densitymaps.at(layer_index).texture = &texture_iter->second;
+        m_layer_data.densitymaps.at(layer_index).image = &texture_iter->second;
 #else
         m_layer_data.densitymaps.at(layer_index).texture = texture_iter->second.getGLObject().getName();
 #endif
@@ -430,16 +452,16 @@ public:
 
 private:
     std::chrono::steady_clock::time_point m_start_time {};
-    placement::LayerData m_layer_data;
-    std::optional<placement::Result> m_result;
-    std::optional<placement::FutureResult> m_future_result;
+    backend::LayerData m_layer_data;
+    std::optional<backend::Result> m_result;
+    std::optional<backend::FutureResult> m_future_result;
     std::vector<std::optional<ResultMesh>> m_meshes;
     std::vector<std::pair<TextureIter, MeshDataIter>> m_iters;
 };
 
 void placementGroupGUI(PlacementGroup &placement_group,
 #ifdef CPU_PLACEMENT
-                       const std::map<std::string, placement::GrayscaleImage> &textures,
+                       const std::map<std::string, backend::Image> &textures,
 #else
                        const std::map<std::string, simple::Texture2D> &textures,
 #endif
@@ -744,7 +766,7 @@ int main(int argc, char* argv[])
 #ifndef CPU_PLACEMENT
     { return simple::Texture2D(simple::ImageData::fromFile(path)); }
 #else
-                                                   { return placement::GrayscaleImage(path.c_str()); }
+                                                   { return loadImage(path); }
 #endif
     );
 
@@ -758,7 +780,7 @@ int main(int argc, char* argv[])
 
     GL::Texture::bindTextureUnit(color_texture_unit, color_texture.getGLObject());
 
-    placement::PlacementPipeline pipeline;
+    backend::PlacementPipeline pipeline;
 #ifndef CPU_PLACEMENT
     pipeline.setBaseTextureUnit(glm::max(heightmap_texture_unit, color_texture_unit) + 1);
 #endif
@@ -771,7 +793,7 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    placement::WorldData world_data{/*scale=*/{1, 1, 1},
+    backend::WorldData world_data{/*scale=*/{1, 1, 1},
 #ifndef CPU_PLACEMENT
             /*heightmap=*/current_heightmap_iter->second.getGLObject().getName()
 #else
@@ -0,0 +1,78 @@
+#ifndef PROCEDURALPLACEMENTLIB_CLASS_TILE_GRID_HPP
+#define PROCEDURALPLACEMENTLIB_CLASS_TILE_GRID_HPP
+
+#include "density_map.hpp"
+#include "density_pyramid.hpp"
+
+#include "glm/vec2.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace placement {
+
+/**
+ * @brief Coarse grid over the texture coordinates of the density maps of a layer, listing the classes present in each
+ * of its tiles.
+ * A class is present in a tile if its density may be nonzero anywhere in it, as bounded by the pyramid of its density
+ * map. With many classes, most of which only cover small parts of the world, this lets the pipeline evaluate each
+ * class only over the work groups where it is present, so the cost of a candidate depends on the number of classes
+ * around it rather than on the number of classes of the layer. See LayerData::class_tiles.
+ */
+class ClassTileGrid
+{
+public:
+    /**
+     * @brief Build the grid from the pyramids of the density maps of a layer.
+     * @param size number of tiles along each axis, which evenly divide the unit square of texture coordinates.
+     * @param pyramids the pyramid of the texture, and channel, of each density map.
+     * Throws std::logic_error if the size is zero or if a pyramid is missing.
+     */
+    ClassTileGrid(glm::uvec2 size, const std::vector<DensityMap> &density_maps,
+                  const std::vector<const DensityPyramid*> &pyramids);
+
+    [[nodiscard]] glm::uvec2 getSize() const { return m_size; }
+
+    [[nodiscard]] uint getClassCount() const { return m_class_count; }
+
+    /// Classes present in a tile, in increasing order.
+    [[nodiscard]] std::vector<uint> getTileClasses(glm::uvec2 tile) const;
+
+    /**
+     * @brief Whether a class is present in a tile, which may lie outside of the grid. Texture coordinates outside of
+     * the unit square sample the edge texels, so such a tile has the classes of the edge tile it clamps to, and also
+     * those of the tile it wraps around to along the axes where the texture of a density map repeats.
+     */
+    [[nodiscard]] bool isClassPresent(glm::ivec2 tile, uint class_index) const;
+
+    /**
+     * @brief Tiles that overlap a rectangle, which may extend past the grid, see isClassPresent().
+     * @return The first tile, and the one past the last along each axis.
+     */
+    [[nodiscard]] std::pair<glm::ivec2, glm::ivec2> getTileRange(glm::vec2 lower_uv, glm::vec2 upper_uv) const;
+
+    /// Texture coordinates of the lower corner of a tile. Those of the upper corner are the lower ones of tile + 1.
+    [[nodiscard]] glm::vec2 getTileLowerBound(glm::ivec2 tile) const;
+
+    /// One flag per class, set if the class is present in any of the tiles that overlap a rectangle.
+    [[nodiscard]] std::vector<bool> getPresentClasses(glm::vec2 lower_uv, glm::vec2 upper_uv) const;
+
+private:
+    [[nodiscard]] uint m_getTileIndex(glm::uvec2 tile) const { return tile.y * m_size.x + tile.x; }
+
+    /// Tiles of the grid sampled by the candidates of a tile along an axis: the clamped one, then the wrapped one.
+    [[nodiscard]] std::pair<uint, uint> m_getSampledTiles(int tile, int axis) const;
+
+    glm::uvec2 m_size;
+    uint m_class_count;
+    /// Whether the texture of any density map repeats along each axis.
+    glm::bvec2 m_repeat {false};
+
+    /// The classes of tile i are m_classes[m_tile_offsets[i]] to m_classes[m_tile_offsets[i + 1] - 1].
+    std::vector<uint> m_tile_offsets;
+    std::vector<uint> m_classes;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_CLASS_TILE_GRID_HPP
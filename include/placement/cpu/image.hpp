@@ -0,0 +1,69 @@
+#ifndef PROCEDURALPLACEMENTLIB_CPU_IMAGE_HPP
+#define PROCEDURALPLACEMENTLIB_CPU_IMAGE_HPP
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace placement::cpu {
+
+/**
+ * @brief Single channel image in host memory, which takes the place of a texture for the CPU pipeline.
+ * Sampling follows the OpenGL rules for the base level of a texture with the same filter and wrap modes, so an image
+ * holding the same values as a texture returns the same samples, up to the precision of the texture units of the GPU.
+ */
+class Image
+{
+public:
+    enum class Filter
+    {
+        nearest, linear
+    };
+
+    enum class Wrap
+    {
+        clamp_to_edge, repeat
+    };
+
+    /**
+     * @param size width and height of the image, in texels.
+     * @param values size.x * size.y values, stored row by row starting from the texel at uv (0, 0).
+     * Throws std::logic_error if the size is zero or does not match the number of values.
+     */
+    Image(glm::uvec2 size, std::vector<float> values);
+
+    /// Image of 8-bit unsigned normalized values, as those of a GL_R8 texture, stored row by row.
+    [[nodiscard]] static Image fromUnorm8(glm::uvec2 size, const std::uint8_t *values);
+
+    [[nodiscard]] glm::uvec2 getSize() const { return m_size; }
+
+    /// The values of the texels, stored row by row.
+    [[nodiscard]] const std::vector<float> &getValues() const { return m_values; }
+
+    /// Linear by default, as GL_LINEAR.
+    void setFilter(Filter filter) { m_filter = filter; }
+
+    [[nodiscard]] Filter getFilter() const { return m_filter; }
+
+    /// Clamp to edge by default, as GL_CLAMP_TO_EDGE. The same mode applies to both axes.
+    void setWrap(Wrap wrap) { m_wrap = wrap; }
+
+    [[nodiscard]] Wrap getWrap() const { return m_wrap; }
+
+    /// Value of a texel, with the wrap mode applied to its index.
+    [[nodiscard]] float fetch(glm::ivec2 texel) const;
+
+    /// Filtered value at texture coordinates @p uv.
+    [[nodiscard]] float sample(glm::vec2 uv) const;
+
+private:
+    glm::uvec2 m_size;
+    std::vector<float> m_values;
+    Filter m_filter {Filter::linear};
+    Wrap m_wrap {Wrap::clamp_to_edge};
+};
+
+} // placement::cpu
+
+#endif //PROCEDURALPLACEMENTLIB_CPU_IMAGE_HPP
@@ -0,0 +1,158 @@
+#ifndef PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_PIPELINE_HPP
+#define PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_PIPELINE_HPP
+
+#include "image.hpp"
+#include "placement_result.hpp"
+#include "../kernel/kernel_configuration.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace placement::cpu {
+
+/// Same as placement::DensityMap, with an image in place of the texture.
+struct DensityMap
+{
+    const Image *image{nullptr};
+
+    /// Values in the image will be multiplied by this factor.
+    float scale{1};
+
+    /// Values in the image will be offset by this amount, after scaling.
+    float offset{0};
+
+    /// Values in the image will be clamped to the range [min_value, max_value], after scaling and offset.
+    float min_value{0};
+    float max_value{1};
+};
+
+/// Same as placement::LayerData.
+struct LayerData
+{
+    /// Minimum separation between any two placed object, i.e. a collision diameter.
+    float footprint;
+
+    /// An array of density maps, each one representing a different "object class".
+    std::vector<DensityMap> densitymaps;
+};
+
+/// Same as placement::WorldData, with an image in place of the heightmap texture.
+struct WorldData
+{
+    /// Dimensions of the world
+    glm::vec3 scale;
+
+    const Image *heightmap{nullptr};
+};
+
+/// Instruction sets the CPU pipeline can evaluate candidates with, from the slowest to the fastest.
+enum class InstructionSet
+{
+    /// One candidate at a time.
+    scalar,
+    /// Four candidates at a time.
+    sse4_1,
+    /// Eight candidates at a time, sampling density maps with gather instructions.
+    avx2
+};
+
+/**
+ * @brief The fastest instruction set supported by both the processor, according to CPUID, and the build of the
+ * library. Only x86 builds with a compiler that supports the instruction set flags have SIMD kernels.
+ */
+[[nodiscard]] InstructionSet getSupportedInstructionSet();
+
+/**
+ * @brief Placement on the CPU, for applications without an OpenGL context, such as servers.
+ * The candidates, thresholds and class selection are those of placement::PlacementPipeline with the same seed, pattern
+ * size, pattern tile count and blue noise size, so both pipelines place the same elements, in the same classes, given
+ * images that hold the values of the textures and are sampled with the same filter and wrap modes. Positions are
+ * computed with the same single precision expressions, which the kernels keep from being fused, so they are identical.
+ * GPUs filter textures with reduced precision weights, however, so densities sampled between texels, and heights, can
+ * differ in the last bits.
+ * Candidates whose accumulated density is within that error of their threshold may then be classified differently.
+ *
+ * Placement runs on a thread of its own for each call, so the images must outlive the returned FutureResult.
+ * Footprint filtering, culling and incremental placement are not supported, and elements are always sorted in the
+ * order of the candidate grid within each class.
+ */
+class PlacementPipeline
+{
+public:
+    using uint = std::uint32_t;
+
+    /// Throws std::logic_error if @p pattern_size is not one of KernelConfiguration::supported_sizes.
+    explicit PlacementPipeline(glm::uvec2 pattern_size = KernelConfiguration::default_pattern_size);
+
+    ~PlacementPipeline();
+
+    PlacementPipeline(PlacementPipeline&&) noexcept;
+    PlacementPipeline& operator=(PlacementPipeline&&) noexcept;
+
+    /**
+     * @brief Multiclass placement, see placement::PlacementPipeline::computePlacement().
+     * Throws std::logic_error if the heightmap or the image of a density map is null.
+     */
+    [[nodiscard]]
+    FutureResult computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                  glm::vec2 lower_bound, glm::vec2 upper_bound);
+
+    /// Same as computePlacement(), but using @p seed instead of the random seed of the pipeline for this call.
+    [[nodiscard]]
+    FutureResult computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                  glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed);
+
+    /// @see placement::PlacementPipeline::setRandomSeed()
+    void setRandomSeed(uint seed) { m_random_seed = seed; }
+
+    [[nodiscard]] uint getRandomSeed() const { return m_random_seed; }
+
+    /// Number of seeds whose patterns are kept before the pattern cache is cleared.
+    static constexpr std::size_t max_cached_patterns = 64;
+
+    [[nodiscard]] glm::uvec2 getPatternSize() const { return m_pattern_size; }
+
+    /// @see placement::PlacementPipeline::setBlueNoiseThresholds()
+    void setBlueNoiseThresholds(uint size);
+
+    /// Size of the blue noise threshold matrix, or zero if the dithering matrix is used.
+    [[nodiscard]] uint getBlueNoiseSize() const { return m_blue_noise_size; }
+
+    /// @see placement::PlacementPipeline::setPatternTileCount(). Throws std::logic_error if @p count is zero.
+    void setPatternTileCount(uint count);
+
+    [[nodiscard]] uint getPatternTileCount() const { return m_pattern_tile_count; }
+
+    /**
+     * @brief Select the instruction set of the kernel that evaluates the candidates, getSupportedInstructionSet() by
+     * default. All of them produce the same results, bit for bit, so this only matters for benchmarking. Throws
+     * std::logic_error if the instruction set is faster than the supported one.
+     */
+    void setInstructionSet(InstructionSet instruction_set);
+
+    [[nodiscard]] InstructionSet getInstructionSet() const { return m_instruction_set; }
+
+private:
+    struct SeedPattern;
+
+    /// Generate the pattern of a seed with the current settings, or fetch it from the cache.
+    [[nodiscard]] std::shared_ptr<const SeedPattern> m_getPattern(uint seed);
+
+    glm::uvec2 m_pattern_size;
+    uint m_random_seed {0};
+    uint m_blue_noise_size {0};
+    uint m_pattern_tile_count {1};
+    InstructionSet m_instruction_set;
+
+    /// Shared with the placement operations that use them, which may outlive the pipeline or its cache.
+    std::map<uint, std::shared_ptr<const SeedPattern>> m_seed_patterns;
+};
+
+} // placement::cpu
+
+#endif //PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_PIPELINE_HPP
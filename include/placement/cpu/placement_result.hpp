@@ -0,0 +1,133 @@
+#ifndef PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_RESULT_HPP
+#define PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_RESULT_HPP
+
+#include "../placement_result.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace placement::cpu {
+
+/**
+ * @brief Results of a placement operation of the CPU pipeline, in host memory.
+ * Same as placement::Result, without the GL buffer: the elements are sorted by class, and the index offsets give the
+ * range of each class within the element array.
+ */
+class Result
+{
+public:
+    using uint = std::uint32_t;
+
+    using Element = ResultElement;
+
+    /// @param index_offsets the index offset of each class, followed by the number of elements.
+    Result(std::vector<Element> elements, std::vector<uint> index_offsets);
+
+    /// Get the number of placement classes in the result.
+    [[nodiscard]]
+    uint getNumClasses() const noexcept
+    { return static_cast<uint>(m_index_offset.size() - 1); }
+
+    /// Total number of elements in the element array.
+    [[nodiscard]]
+    uint getElementArrayLength() const noexcept
+    { return m_index_offset.back(); }
+
+    /// @see placement::Result::getIndexOffsets()
+    [[nodiscard]]
+    const std::vector<uint> &getIndexOffsets() const noexcept
+    { return m_index_offset; }
+
+    /// Same as `getIndexOffsets()[class_index]`.
+    [[nodiscard]]
+    uint getClassIndexOffset(uint class_index) const noexcept
+    { return m_index_offset[class_index]; }
+
+    /// Get the number of elements in a given placement class.
+    [[nodiscard]]
+    uint getClassElementCount(uint class_index) const noexcept
+    { return getClassRangeElementCount(class_index, class_index + 1); }
+
+    /// @see placement::Result::getClassRangeElementCount()
+    [[nodiscard]]
+    uint getClassRangeElementCount(uint begin_class, uint end_class) const noexcept
+    { return m_index_offset[end_class] - m_index_offset[begin_class]; }
+
+    /// All the elements, sorted by class.
+    [[nodiscard]]
+    const std::vector<Element> &getElements() const noexcept
+    { return m_elements; }
+
+    /// Pointer to the first element of a class, for uploading it directly.
+    [[nodiscard]]
+    const Element *getClassElementData(uint class_index) const noexcept
+    { return m_elements.data() + getClassIndexOffset(class_index); }
+
+    /// @see placement::Result::copyClassRangeToHost()
+    template<typename Iter>
+    uint copyClassRangeToHost(uint begin_class, uint end_class, Iter out_iter) const
+    {
+        const auto begin = m_elements.begin() + getClassIndexOffset(begin_class);
+        const auto end = m_elements.begin() + getClassIndexOffset(end_class);
+
+        for (auto in_iter = begin; in_iter != end;)
+            *out_iter++ = *in_iter++;
+
+        return getClassRangeElementCount(begin_class, end_class);
+    }
+
+    /// Copy all elements to host.
+    template<typename Iter>
+    uint copyAllToHost(Iter out_iter) const
+    { return copyClassRangeToHost(0, getNumClasses(), out_iter); }
+
+    /// Copy all elements to a std::vector
+    [[nodiscard]] std::vector<Element> copyAllToHost() const { return m_elements; }
+
+    /// copy all elements of a specific class to host.
+    template<typename Iter>
+    uint copyClassToHost(uint class_index, Iter out_iter) const
+    { return copyClassRangeToHost(class_index, class_index + 1, out_iter); }
+
+    [[nodiscard]] std::vector<Element> copyClassToHost(uint class_index) const;
+
+    /// cede ownership of the elements, invalidating this structure.
+    [[nodiscard]] std::vector<Element> moveElements() { return std::move(m_elements); }
+
+private:
+    std::vector<Element> m_elements;
+    std::vector<uint> m_index_offset;
+};
+
+/// Contains the results of a placement operation which may not have finished execution yet.
+class FutureResult final
+{
+public:
+    explicit FutureResult(std::future<Result> &&future);
+
+    /// Check if results are available.
+    [[nodiscard]]
+    bool isReady() const
+    { return wait(std::chrono::nanoseconds::zero()); }
+
+    /// Wait until results are ready or until the timeout expires, returning true in the former case and false in the
+    /// latter.
+    [[nodiscard]]
+    bool wait(std::chrono::nanoseconds timeout) const;
+
+    /**
+     * @brief Read results, if available, or block execution until they are.
+     * This operation moves out the results, leaving this object in an empty state. Exceptions thrown while placing
+     * are rethrown here.
+     */
+    [[nodiscard]] Result readResult();
+
+private:
+    std::future<Result> m_future;
+};
+
+} // placement::cpu
+
+#endif //PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_RESULT_HPP
@@ -8,6 +8,11 @@ namespace placement {
 /// A density map specifies the probability distribution of a single class of object over the landscape.
 struct DensityMap
 {
+    enum class Channel : GLuint
+    {
+        red, green, blue, alpha
+    };
+
     /// name of an OpenGL texture object.
     GLuint texture{0};
 
@@ -20,6 +25,13 @@ struct DensityMap
     /// Values in texture will be clamped to the range [min_value, max_value], after scaling and offset.
     float min_value{0};
     float max_value{1};
+
+    /**
+     * Channel of the texture that holds the values of this density map. Up to four density maps can share an RGBA
+     * texture, in which case the pipeline fetches a single texel per candidate for all of them, provided their classes
+     * are consecutive among the classes of the layer.
+     */
+    Channel channel{Channel::red};
 };
 
 } // placement
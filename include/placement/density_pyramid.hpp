@@ -0,0 +1,73 @@
+#ifndef PROCEDURALPLACEMENTLIB_DENSITY_PYRAMID_HPP
+#define PROCEDURALPLACEMENTLIB_DENSITY_PYRAMID_HPP
+
+#include "density_map.hpp"
+
+#include "glm/vec2.hpp"
+
+#include <vector>
+
+namespace placement {
+
+/**
+ * @brief Host-side min/max mip pyramid of a density map texture.
+ * Each level halves the resolution of the previous one, and each of its cells holds the minimum and maximum of the
+ * four cells it covers. This allows conservatively bounding the values of the texture over any rectangle with a
+ * constant number of lookups, which the pipeline uses to skip classes and work groups where a density map is zero.
+ */
+class DensityPyramid
+{
+public:
+    /**
+     * @brief Build a pyramid from the values of the base level.
+     * @param size width and height of the base level, in texels.
+     * @param values size.x * size.y values, stored row by row starting from the texel at uv (0, 0).
+     * @param repeat whether texture coordinates wrap around along each axis, as with GL_REPEAT. Otherwise, they are
+     * clamped to the edge, as with GL_CLAMP_TO_EDGE.
+     */
+    DensityPyramid(glm::uvec2 size, const float *values, glm::bvec2 repeat = glm::bvec2(false));
+
+    /**
+     * @brief Build a pyramid from a channel of the base level of an OpenGL texture.
+     * This reads the texture back to host memory, so it stalls the pipeline and should not be done every frame.
+     * The wrap modes of the texture must be GL_REPEAT or GL_CLAMP_TO_EDGE, otherwise std::runtime_error is thrown.
+     */
+    [[nodiscard]] static DensityPyramid fromTexture(GLuint texture,
+                                                    DensityMap::Channel channel = DensityMap::Channel::red);
+
+    /**
+     * @brief Bound the values sampled from the texture over a rectangle.
+     * The bounds account for linear filtering and for the wrap mode of each axis.
+     * @param lower_uv, upper_uv the rectangle, in texture coordinates.
+     * @return The minimum (x) and maximum (y) values that may be sampled within the rectangle.
+     */
+    [[nodiscard]] glm::vec2 getRange(glm::vec2 lower_uv, glm::vec2 upper_uv) const;
+
+    /// Same as getRange(), but with the scale, offset and clamping of a density map applied to the values.
+    [[nodiscard]] glm::vec2 getRange(const DensityMap &density_map, glm::vec2 lower_uv, glm::vec2 upper_uv) const;
+
+    [[nodiscard]] glm::uvec2 getSize() const { return m_levels.front().size; }
+
+    [[nodiscard]] std::size_t getLevelCount() const { return m_levels.size(); }
+
+    [[nodiscard]] glm::bvec2 getRepeat() const { return m_repeat; }
+
+private:
+    struct Level
+    {
+        glm::uvec2 size;
+        std::vector<glm::vec2> values;
+
+        [[nodiscard]] glm::vec2 get(glm::uvec2 index) const { return values[index.y * size.x + index.x]; }
+    };
+
+    /// Range of the texels from begin to end, inclusive, which must be within the base level.
+    [[nodiscard]] glm::vec2 m_getTexelRange(glm::uvec2 begin, glm::uvec2 end) const;
+
+    std::vector<Level> m_levels;
+    glm::bvec2 m_repeat;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_DENSITY_PYRAMID_HPP
@@ -0,0 +1,130 @@
+#ifndef PROCEDURALPLACEMENTLIB_INSTANCE_RING_BUFFER_HPP
+#define PROCEDURALPLACEMENTLIB_INSTANCE_RING_BUFFER_HPP
+
+#include "placement_result.hpp"
+
+#include "glutils/buffer.hpp"
+
+#include "glm/vec2.hpp"
+
+#include <vector>
+#include <optional>
+
+namespace placement {
+
+/// Arguments of an indexed indirect draw, with the layout expected by glMultiDrawElementsIndirect().
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+/**
+ * @brief Fixed-capacity instance storage for a window of cells that slides over the world.
+ *
+ * The window is a grid of window_size cells, and each cell owns a slot of slot_capacity elements in a single GL buffer.
+ * Cells are mapped onto slots toroidally: cell (x, y) always uses slot (x mod window_size.x, y mod window_size.y). When
+ * the window moves, only the slots of the cells that wrapped around have to be rewritten; the buffer is never
+ * reallocated and its contents are never compacted.
+ *
+ * Elements within a slot have the same layout as in a Result, and are sorted by class. The command buffer contains one
+ * DrawElementsIndirectCommand per (slot, class) pair, stored slot-major. The base_instance of each command points to
+ * the first element of the class within the slot, so all the instances of a class can be drawn with a single call:
+ * @code
+ * gl.MultiDrawElementsIndirect(mode, type, (void*) ring.getClassCommandOffset(c), ring.getSlotCount(),
+ *                              ring.getCommandStride());
+ * @endcode
+ * For this to work, the element buffer must be bound as a per-instance (divisor 1) vertex attribute source.
+ */
+class InstanceRingBuffer
+{
+public:
+    using Element = ResultElement;
+
+    /**
+     * @brief Allocate storage for a window.
+     * @param window_size number of cells in the window along each axis.
+     * @param slot_capacity maximum number of elements stored for a single cell.
+     * @param num_classes number of placement classes, which determines the number of draw commands per slot.
+     */
+    InstanceRingBuffer(glm::uvec2 window_size, GLuint slot_capacity, GLuint num_classes);
+
+    /**
+     * @brief Move the window so that its lowest cell is @p origin.
+     * @return The cells that entered the window. Their slots are cleared and should be filled with writeSlot().
+     */
+    std::vector<glm::ivec2> moveWindow(glm::ivec2 origin);
+
+    /**
+     * @brief Copy the elements of a placement result into the slot of a cell.
+     * Elements in excess of the slot capacity are dropped, starting from the last class.
+     * @return The number of elements written.
+     */
+    GLuint writeSlot(glm::ivec2 cell, const Result &result);
+
+    /// Set the instance count of all the commands of a cell's slot to zero. Throws std::logic_error if the cell is
+    /// outside of the window, whose slot may belong to another cell.
+    void clearSlot(glm::ivec2 cell);
+
+    /// Check if a cell lies inside the current window.
+    [[nodiscard]] bool contains(glm::ivec2 cell) const;
+
+    /// Check if the slot of a cell currently holds the elements of that cell.
+    [[nodiscard]] bool isWritten(glm::ivec2 cell) const;
+
+    /// Index of the slot used by a cell. Does not check if the cell is inside the window.
+    [[nodiscard]] GLuint getSlotIndex(glm::ivec2 cell) const;
+
+    /// Set the index count of every draw command of a class, i.e. the number of indices of the mesh drawn for it.
+    void setClassIndexCount(GLuint class_index, GLuint index_count);
+
+    [[nodiscard]] glm::ivec2 getWindowOrigin() const { return m_origin; }
+
+    [[nodiscard]] glm::uvec2 getWindowSize() const { return m_window_size; }
+
+    [[nodiscard]] GLuint getSlotCount() const { return m_window_size.x * m_window_size.y; }
+
+    [[nodiscard]] GLuint getSlotCapacity() const { return m_slot_capacity; }
+
+    [[nodiscard]] GLuint getNumClasses() const { return m_num_classes; }
+
+    /// Buffer containing the elements of every slot.
+    [[nodiscard]] GL::BufferHandle getElementBuffer() const { return m_element_buffer; }
+
+    /// Buffer containing the draw commands of every slot.
+    [[nodiscard]] GL::BufferHandle getCommandBuffer() const { return m_command_buffer; }
+
+    /// Byte offset into the command buffer of the command of the first slot for a given class.
+    [[nodiscard]] GLintptr getClassCommandOffset(GLuint class_index) const
+    { return class_index * static_cast<GLintptr>(sizeof(DrawElementsIndirectCommand)); }
+
+    /// Distance in bytes between the commands of the same class for consecutive slots.
+    [[nodiscard]] GLsizei getCommandStride() const
+    { return static_cast<GLsizei>(m_num_classes * sizeof(DrawElementsIndirectCommand)); }
+
+    /// Byte offset into the element buffer at which the slot of a cell begins.
+    [[nodiscard]] GLintptr getSlotBufferOffset(glm::ivec2 cell) const
+    { return getSlotIndex(cell) * static_cast<GLintptr>(m_slot_capacity) * Element::ssize; }
+
+private:
+    glm::uvec2 m_window_size;
+    GLuint m_slot_capacity;
+    GLuint m_num_classes;
+    glm::ivec2 m_origin {0, 0};
+
+    GL::Buffer m_element_buffer;
+    GL::Buffer m_command_buffer;
+
+    std::vector<DrawElementsIndirectCommand> m_commands;
+    std::vector<std::optional<glm::ivec2>> m_slot_cells;
+
+    void m_checkCell(glm::ivec2 cell) const;
+    void m_uploadSlotCommands(GLuint slot_index);
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_INSTANCE_RING_BUFFER_HPP
@@ -7,6 +7,9 @@
 
 #include <vector>
 #include <array>
+#include <string>
+#include <filesystem>
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
 
@@ -39,6 +42,41 @@ public:
 
     ComputeShaderProgram(unsigned int count, const char **source_strings);
 
+    /**
+     * @brief Start compiling and linking a compute shader, without waiting for the result.
+     * Where GL_KHR_parallel_shader_compile is supported, the driver may compile the program in the background, and
+     * isReady() tells when it is done. Compilation errors are thrown by waitReady(), which every other member function
+     * calls implicitly.
+     */
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const std::string &source_string);
+
+    ~ComputeShaderProgram();
+    ComputeShaderProgram(ComputeShaderProgram&&) noexcept;
+    ComputeShaderProgram& operator=(ComputeShaderProgram&&) noexcept;
+
+    /**
+     * @brief Whether the program has been compiled and linked, so that waitReady() will not block.
+     * Always true without GL_KHR_parallel_shader_compile, where the status of the program is only known by blocking.
+     */
+    [[nodiscard]] bool isReady() const;
+
+    /// Block until the program is linked. Throws GL::GLError, on every call, if it failed to compile or link.
+    void waitReady() const;
+
+    /**
+     * @brief Make programs constructed from now on load their binary from @p directory instead of compiling their
+     * source, and store it there after compiling it.
+     * Binaries are looked up by a hash of the source strings, the vendor, renderer and version of the GL, so a change
+     * of source or driver causes a cache miss. Binaries that the driver rejects are compiled again and overwritten.
+     * An empty path, the default, disables the cache. The directory is created if it does not exist.
+     */
+    static void setBinaryCacheDirectory(std::filesystem::path directory);
+
+    [[nodiscard]] static const std::filesystem::path &getBinaryCacheDirectory() { return s_binary_cache_directory; }
+
+    /// Whether the program was loaded from the binary cache, rather than compiled from source.
+    [[nodiscard]] bool isLoadedFromBinary() const { return m_loaded_from_binary; }
+
     // Various utility classes
 
     using Interface = GL::Program::Interface;
@@ -308,6 +346,20 @@ public:
     struct UniformAccessor;
 
 private:
+    /// Compilation started by the constructor and not yet checked.
+    struct PendingLink;
+
+    static std::filesystem::path s_binary_cache_directory;
+
+    ComputeShaderProgram(unsigned int count, const char **source_strings, bool wait);
+
+    void m_compile(unsigned int count, const char **source_strings, bool wait);
+
+    /// Link the program from the binary in @p file. Returns false if the file is missing, stale or rejected.
+    [[nodiscard]] bool m_loadBinary(const std::filesystem::path &file, const std::string &driver_string);
+
+    void m_saveBinary(const std::filesystem::path &file, const std::string &driver_string) const;
+
     [[nodiscard]] GLuint m_queryInterFaceBlockBindingIndex(InterfaceBlockType block_type, GLuint resource_index) const;
 
     template<typename ArrayLike>
@@ -334,6 +386,8 @@ private:
     }
 
     GL::Program m_program;
+    bool m_loaded_from_binary {false};
+    mutable std::unique_ptr<PendingLink> m_pending;
 };
 
 template<typename T>
@@ -2,28 +2,84 @@
 #define PROCEDURALPLACEMENTLIB_COPY_KERNEL_HPP
 
 #include "compute_kernel.hpp"
+#include "kernel_configuration.hpp"
+#include "uniform_ring_buffer.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
 
 namespace placement {
 
 class CopyKernel final
 {
 public:
-    static constexpr glm::uvec3 work_group_size{64, 1, 1};
     static constexpr uint glsl_version{430};
 
-    CopyKernel();
+    CopyKernel() : CopyKernel(KernelConfiguration{})
+    {}
+
+    /// Compile the kernel with the copy local size of @p configuration.
+    explicit CopyKernel(const KernelConfiguration &configuration);
+
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    CopyKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program);
+
+    /// Start compiling the program of the kernel for @p configuration, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const KernelConfiguration &configuration);
+
+    [[nodiscard]] uint getLocalSize() const { return m_local_size; }
 
-    void operator() (uint num_work_groups, GLuint candidate_buffer_binding_index, GLuint count_buffer_binding_index,
+    /**
+     * @brief Copy accepted candidates to the output buffer, sorted by class.
+     * The candidate buffer holds the candidates of a grid of work groups @p grid_width wide, whose first work group is
+     * at @p work_group_offset in the grid of the world. The position of each copied element is generated again from
+     * the pattern tiles and @p footprint, as by the GenerationKernel, and its height is sampled from the heightmap
+     * bound to @p heightmap_texture_unit.
+     */
+    void operator() (uint num_work_groups, glm::uvec2 work_group_offset, uint grid_width, float footprint,
+            glm::vec3 world_scale, GLuint heightmap_texture_unit,
+            GLuint candidate_buffer_binding_index, GLuint count_buffer_binding_index,
             GLuint index_buffer_binding_index, GLuint output_buffer_binding_index);
 
+    /// The pattern tiles the candidates were generated from. @see GenerationKernel::setPatternTiles()
+    void setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count);
+
+    /// @see GenerationKernel::setWorkGroupPatternBoundaries()
+    void setWorkGroupPatternBoundaries(glm::vec2 boundaries)
+    {
+        m_parameters.work_group_scale = boundaries;
+    }
+
+    /// Uniform buffer binding point to which the parameters of each dispatch are bound. Zero by default.
+    void setParameterBindingIndex(GLuint binding_index);
+
     [[nodiscard]]
-    static constexpr uint calculateNumWorkGroups(uint candidate_count)
-    { return 1u + candidate_count / work_group_size.x; }
+    uint calculateNumWorkGroups(uint candidate_count) const
+    { return 1u + candidate_count / m_local_size; }
 
 private:
+    /// Same layout as the std140 Parameters block of the shader.
+    struct alignas(16) Parameters
+    {
+        glm::vec3 world_scale {0.0f};
+        float footprint {0.0f};
+        glm::vec2 work_group_scale {0.0f};
+        glm::uvec2 work_group_offset {0u};
+        GLuint grid_width {0};
+        GLuint pattern_tile_count {0};
+    };
+    static_assert(sizeof(Parameters) == 48);
+
+    uint m_local_size;
     ComputeShaderProgram m_program;
     using CS = ComputeShaderProgram;
+    /// Parameters of the next dispatch, except those passed to operator().
+    Parameters m_parameters;
+    UniformRingBuffer m_parameter_buffer;
+    CS::UniformBlock m_parameter_block;
+    CS::CachedUniform<int> m_heightmap_tex;
     CS::ShaderStorageBlock m_candidate_buffer;
+    CS::ShaderStorageBlock m_pattern_tile_buffer;
     CS::ShaderStorageBlock m_count_buffer;
     CS::ShaderStorageBlock m_index_buffer;
     CS::ShaderStorageBlock m_output_buffer;
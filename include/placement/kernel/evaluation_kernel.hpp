@@ -2,8 +2,13 @@
 #define PROCEDURALPLACEMENTLIB_EVALUATION_KERNEL_HPP
 
 #include "compute_kernel.hpp"
+#include "kernel_configuration.hpp"
+#include "uniform_ring_buffer.hpp"
+
+#include "glm/vec4.hpp"
 
 #include <array>
+#include <vector>
 
 namespace placement {
 
@@ -12,52 +17,168 @@ class DensityMap;
 class EvaluationKernel final
 {
 public:
-    static constexpr glm::uvec3 work_group_size{8, 8, 1};
-    static const std::array<std::array<float, work_group_size.y>, work_group_size.x> default_dithering_matrix;
+    static constexpr glm::uvec2 default_pattern_size = KernelConfiguration::default_pattern_size;
+
+    /// Largest number of classes evaluated by a single dispatch, one per channel of an RGBA texture.
+    static constexpr uint max_packed_classes {4};
+
+    /// Dithering matrix for the default pattern size. Equal to the result of makeDitheringMatrix(default_pattern_size).
+    static const std::array<std::array<float, default_pattern_size.y>, default_pattern_size.x> default_dithering_matrix;
+
+    /**
+     * @brief Ordered dithering matrix of the given size, stored column by column.
+     * Square sizes give the Bayer matrix. Other sizes take the values of the square Bayer matrix over the larger
+     * dimension, and rank them, so every value in {0, 1/n, ..., (n-1)/n}, where n = size.x * size.y, appears once.
+     * Sizes must be powers of two.
+     */
+    [[nodiscard]] static std::vector<float> makeDitheringMatrix(glm::uvec2 size);
+
+    EvaluationKernel() : EvaluationKernel(KernelConfiguration{})
+    {}
+
+    /**
+     * @brief Compile the kernel for the given pattern and local sizes, and set the dithering matrix for the pattern
+     * size. Throws std::logic_error if the sizes are not supported.
+     */
+    explicit EvaluationKernel(const KernelConfiguration &configuration);
 
-    EvaluationKernel();
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    EvaluationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program);
 
-    void operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, uint class_index,
-                    glm::vec2 lower_bound, glm::vec2 upper_bound,
+    /// Start compiling the program of the kernel for @p configuration, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const KernelConfiguration &configuration);
+
+    [[nodiscard]] const KernelConfiguration &getConfiguration() const { return m_configuration; }
+
+    /**
+     * @brief Dispatch the compute kernel with the specified arguments.
+     * The density accumulated by each candidate is kept in the candidate buffer. Its position is generated again from
+     * the pattern tiles and @p footprint, as by the GenerationKernel, and density maps are sampled at the texture
+     * coordinates position / world_scale. Candidates with the class index GenerationKernel::culled_class_index were
+     * culled by the GenerationKernel, and are left untouched.
+     * @param reset if true, the densities and class indices already present in the buffer are ignored, as if the
+     *  candidates had just been generated. This allows evaluating the same set of candidates more than once.
+     */
+    void operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, float footprint,
+                    uint class_index, glm::vec2 lower_bound, glm::vec2 upper_bound, glm::vec2 world_scale,
                     GLuint density_map_texture_unit, const DensityMap& density_map,
-                    GLuint candidate_buffer_binding_index, GLuint world_uv_buffer_binding_index,
-                    GLuint density_buffer_binding_index);
+                    GLuint candidate_buffer_binding_index, bool reset = false);
+
+    /**
+     * @brief Evaluate several classes in a single dispatch, as if each of them had been evaluated in turn.
+     * The density maps, one per class, must share their texture, and each of them is read from its own channel of a
+     * single texel per candidate. Without any class, the dispatch only resets the candidates, if @p reset is true.
+     * Throws std::logic_error if there are more than max_packed_classes classes, or if the density maps do not share
+     * their texture.
+     */
+    void operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, float footprint,
+                    const std::vector<uint> &class_indices, glm::vec2 lower_bound, glm::vec2 upper_bound,
+                    glm::vec2 world_scale, GLuint density_map_texture_unit,
+                    const std::vector<DensityMap> &density_maps, GLuint candidate_buffer_binding_index,
+                    bool reset = false);
+
+    /**
+     * @brief Make subsequent dispatches operate on a part of a larger work group grid.
+     * The buffers are indexed as if the full grid, which is @p grid_width work groups wide, had been dispatched, and
+     * the work group with ID (0, 0) is the one at @p sub_grid_offset in the full grid. A grid width of zero restores
+     * the default behaviour, where the dispatched work groups are the full grid.
+     */
+    void setSubGrid(glm::uvec2 sub_grid_offset, uint grid_width);
+
+    /// The pattern tiles the candidates were generated from. @see GenerationKernel::setPatternTiles()
+    void setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count);
 
+    /// @see GenerationKernel::setWorkGroupPatternBoundaries()
+    void setWorkGroupPatternBoundaries(glm::vec2 boundaries)
+    {
+        m_parameters.work_group_scale = boundaries;
+    }
+
+    /**
+     * @brief Take acceptance thresholds from a texture instead of the dithering matrix.
+     * The texture must be bound to @p texture_unit during dispatches. Its texel (x, y) is the threshold of the
+     * candidates whose index within the whole candidate grid is congruent to (x, y) modulo @p size. A size of zero
+     * restores the dithering matrix. See ThresholdTexture.
+     */
+    void setThresholdTexture(GLuint texture_unit, uint size);
+
+    /**
+     * @brief Sample density maps at the mip level whose texels are about @p footprint world units wide.
+     * Density maps must have prefiltered mip levels for this to have any effect. A footprint of zero, the default,
+     * samples the base level.
+     */
+    void setSampleFootprint(float footprint);
+
+    /// Uniform buffer binding point to which the parameters of each dispatch are bound. Zero by default.
+    void setParameterBindingIndex(GLuint binding_index);
+
+    /// Set the dithering matrix from pattern_size.x * pattern_size.y thresholds, stored column by column.
     template<typename ArrayLike>
     void setDitheringMatrix(const ArrayLike &values)
     {
-        for (uint i = 0; i < work_group_size.x; i++)
-            setWorkGroupPatternColumn(i, values[i * work_group_size.y]);
+        if (std::size(values) != m_configuration.getPatternCandidateCount())
+            throw std::logic_error("incorrect number of values for setting the dithering matrix");
+
+        for (uint i = 0; i < m_configuration.pattern_size.x; i++)
+            m_setDitheringMatrixColumn(i, std::data(values) + i * m_configuration.pattern_size.y);
     }
 
     template<typename NestedArrayLike>
     void setDitheringMatrixColumns(const NestedArrayLike &columns)
     {
-        for (uint i = 0; i < work_group_size.x; i++)
+        for (uint i = 0; i < m_configuration.pattern_size.x; i++)
             setDitheringMatrixColumn(i, columns[i]);
     }
 
     template<typename ArrayLike>
     void setDitheringMatrixColumn(uint column_index, const ArrayLike &column_values)
     {
-        m_program.setUniform(m_dithering_matrix[column_index], column_values);
+        if (std::size(column_values) != m_configuration.pattern_size.y)
+            throw std::logic_error("incorrect number of values for setting a dithering matrix column");
+
+        m_setDitheringMatrixColumn(column_index, std::data(column_values));
     }
 
 private:
+    /// Same layout as the std140 Parameters block of the shader.
+    struct alignas(16) Parameters
+    {
+        std::array<glm::vec4, max_packed_classes> density_map_params {};
+        glm::uvec4 class_indices {0u};
+        glm::uvec4 density_map_channels {0u};
+        glm::vec2 lower_bound {0.0f};
+        glm::vec2 upper_bound {0.0f};
+        glm::vec2 world_scale {0.0f};
+        glm::uvec2 work_group_index_offset {0u};
+        glm::uvec2 num_work_groups {0u};
+        glm::uvec2 sub_grid_offset {0u};
+        glm::vec2 work_group_scale {0.0f};
+        float sample_footprint {0.0f};
+        GLuint class_count {0};
+        GLuint reset {0};
+        GLuint grid_width {0};
+        GLuint threshold_texture_size {0};
+        float footprint {0.0f};
+        GLuint pattern_tile_count {0};
+    };
+    static_assert(sizeof(Parameters) == 192);
+
+    void m_setDitheringMatrixColumn(uint column_index, const float *column_values);
+
+    KernelConfiguration m_configuration;
     ComputeShaderProgram m_program;
 
     using CS = ComputeShaderProgram;
 
-    CS::TypedUniform<uint> m_class_index;
-    CS::TypedUniform<glm::vec2> m_lower_bound;
-    CS::TypedUniform<glm::vec2> m_upper_bound;
-    CS::TypedUniform<glm::uvec2> m_work_group_index_offset;
-    CS::TypedUniform<float[work_group_size.x][work_group_size.y]> m_dithering_matrix;
-    CS::TypedUniform<glm::vec4> m_density_map_params;
+    /// Parameters of the next dispatch, except those passed to operator().
+    Parameters m_parameters;
+    UniformRingBuffer m_parameter_buffer;
+    CS::UniformBlock m_parameter_block;
+    CS::UniformLocation m_dithering_matrix;
+    CS::CachedUniform<int> m_threshold_texture;
     CS::CachedUniform<int> m_density_map;
     CS::ShaderStorageBlock m_candidate_buffer;
-    CS::ShaderStorageBlock m_world_uv_buffer;
-    CS::ShaderStorageBlock m_density_buffer;
+    CS::ShaderStorageBlock m_pattern_tile_buffer;
 };
 
 } // placement
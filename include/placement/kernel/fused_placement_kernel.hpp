@@ -0,0 +1,140 @@
+#ifndef PROCEDURALPLACEMENTLIB_FUSED_PLACEMENT_KERNEL_HPP
+#define PROCEDURALPLACEMENTLIB_FUSED_PLACEMENT_KERNEL_HPP
+
+#include "compute_kernel.hpp"
+#include "kernel_configuration.hpp"
+#include "uniform_ring_buffer.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+#include <array>
+#include <vector>
+
+namespace placement {
+
+class DensityMap;
+
+/**
+ * @brief Generation, evaluation and compaction of a small region in a single dispatch of a single compute work group.
+ * The classes of the candidates are kept in shared memory between the phases, so no candidate buffer is needed, and
+ * the offset of each class is known as soon as all the candidates are evaluated. The elements of each class are
+ * written to the output buffer in no particular order. The pattern is always taken from pattern tiles, and the
+ * dithering matrix is the default one for the pattern size.
+ *
+ * Results are otherwise identical to those of the separate kernels, but a single work group only pays off for a few
+ * thousand candidates at most.
+ */
+class FusedPlacementKernel final
+{
+public:
+    static constexpr uint local_size {256};
+
+    /// Largest number of candidates, including culled ones, that a single dispatch can place.
+    static constexpr uint max_candidate_count {16384};
+
+    /// Largest number of classes that a single dispatch can place, and of textures their density maps can come from.
+    static constexpr uint max_class_count {8};
+
+    FusedPlacementKernel() : FusedPlacementKernel(KernelConfiguration{})
+    {}
+
+    /// Compile the kernel for the pattern size of @p configuration.
+    explicit FusedPlacementKernel(const KernelConfiguration &configuration);
+
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    FusedPlacementKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program);
+
+    /// Start compiling the program of the kernel for @p configuration, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const KernelConfiguration &configuration);
+
+    [[nodiscard]] const KernelConfiguration &getConfiguration() const { return m_configuration; }
+
+    /**
+     * @brief Place the candidates of @p num_work_groups work groups, starting at @p work_group_offset.
+     * The textures returned by getDensityMapTextures() must be bound to consecutive texture units, starting at
+     * @p density_map_base_texture_unit, and only the classes for which @p active_classes is true are evaluated. The
+     * count buffer receives the element count of each class, and the element buffer the elements, sorted by class,
+     * with their height sampled from the heightmap.
+     * Throws std::logic_error if there are more candidates or classes than a single dispatch can place.
+     */
+    void operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_offset, float footprint,
+                    glm::vec2 lower_bound, glm::vec2 upper_bound, glm::vec3 world_scale,
+                    GLuint heightmap_texture_unit, GLuint density_map_base_texture_unit,
+                    const std::vector<DensityMap> &density_maps, const std::vector<bool> &active_classes,
+                    GLuint count_buffer_binding_index, GLuint element_buffer_binding_index);
+
+    /**
+     * @brief The distinct textures of the density maps of the active classes, in the order of their texture units.
+     * Density maps that share a texture, in different channels, share its texture unit, and a single texel is fetched
+     * for all of them.
+     */
+    [[nodiscard]] static std::vector<GLuint> getDensityMapTextures(const std::vector<DensityMap> &density_maps,
+                                                                   const std::vector<bool> &active_classes);
+
+    /// @see GenerationKernel::setPatternTiles(). The tile count must not be zero.
+    void setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count);
+
+    /// @see GenerationKernel::setWorkGroupPatternBoundaries()
+    void setWorkGroupPatternBoundaries(glm::vec2 boundaries)
+    {
+        m_parameters.work_group_scale = boundaries;
+    }
+
+    /// @see EvaluationKernel::setThresholdTexture()
+    void setThresholdTexture(GLuint texture_unit, uint size);
+
+    /// @see EvaluationKernel::setSampleFootprint()
+    void setSampleFootprint(float footprint);
+
+    /// Uniform buffer binding point to which the parameters of each dispatch are bound. Zero by default.
+    void setParameterBindingIndex(GLuint binding_index);
+
+private:
+    /// Same layout as the std140 Parameters block of the shader.
+    struct alignas(16) Parameters
+    {
+        std::array<glm::vec4, max_class_count> density_map_params {};
+        glm::vec3 world_scale {0.0f};
+        float footprint {0.0f};
+        glm::vec2 work_group_scale {0.0f};
+        glm::vec2 lower_bound {0.0f};
+        glm::vec2 upper_bound {0.0f};
+        glm::uvec2 work_group_offset {0u};
+        glm::uvec2 num_work_groups {0u};
+        float sample_footprint {0.0f};
+        GLuint class_count {0};
+        /// One bit per class.
+        GLuint active_classes {0};
+        GLuint pattern_tile_count {0};
+        GLuint threshold_texture_size {0};
+        /// Four bits per class.
+        GLuint texture_slots {0};
+        /// Two bits per class.
+        GLuint density_map_channels {0};
+    };
+    static_assert(sizeof(Parameters) == 224);
+
+    KernelConfiguration m_configuration;
+    ComputeShaderProgram m_program;
+
+    using CS = ComputeShaderProgram;
+
+    /// Parameters of the next dispatch, except those passed to operator().
+    Parameters m_parameters;
+    UniformRingBuffer m_parameter_buffer;
+    CS::UniformBlock m_parameter_block;
+    CS::UniformLocation m_dithering_matrix;
+    CS::CachedUniform<int> m_threshold_texture;
+    CS::CachedUniform<int> m_heightmap;
+    CS::UniformLocation m_density_maps;
+    GLuint m_density_map_base_texture_unit {0};
+    CS::ShaderStorageBlock m_pattern_tile_buffer;
+    CS::ShaderStorageBlock m_count_buffer;
+    CS::ShaderStorageBlock m_element_buffer;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_FUSED_PLACEMENT_KERNEL_HPP
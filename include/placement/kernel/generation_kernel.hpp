@@ -2,6 +2,8 @@
 #define PROCEDURALPLACEMENTLIB_GENERATION_KERNEL_HPP
 
 #include "compute_kernel.hpp"
+#include "kernel_configuration.hpp"
+#include "uniform_ring_buffer.hpp"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -11,86 +13,108 @@ namespace placement {
 class GenerationKernel final
 {
 public:
-    static constexpr glm::uvec3 work_group_size{8, 8, 1};
+    /// Class index of the candidates that lie outside of the placement region.
+    static constexpr uint culled_class_index = 0xFFFFFFFEu;
+
+    /// Size of a candidate in the candidate buffer: its accumulated density and its class index.
+    static constexpr GLsizeiptr candidate_size = sizeof(float) + sizeof(uint);
+
+    GenerationKernel() : GenerationKernel(KernelConfiguration{})
+    {}
+
+    /// Compile the kernel for the given pattern and local sizes. Throws std::logic_error if they are not supported.
+    explicit GenerationKernel(const KernelConfiguration &configuration);
+
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    GenerationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program);
+
+    /// Start compiling the program of the kernel for @p configuration, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const KernelConfiguration &configuration);
+
+    [[nodiscard]] const KernelConfiguration &getConfiguration() const { return m_configuration; }
+
+    /**
+     * @brief Dispatch the compute kernel with the specified arguments.
+     * Candidates are generated with a density of zero, which the EvaluationKernel accumulates the densities of the
+     * classes into. Their positions are not stored: the EvaluationKernel and the CopyKernel generate them again from
+     * the same pattern tiles, and the heightmap is only sampled by the CopyKernel, for the accepted candidates.
+     *
+     * Candidates outside of [lower_bound, upper_bound) are culled: they are generated with a reserved class index
+     * (see culled_class_index), which makes the EvaluationKernel skip them and the CopyKernel ignore them.
+     */
+    void operator()(glm::uvec2 num_work_groups, glm::uvec2 group_offset, float footprint,
+                    glm::vec2 lower_bound, glm::vec2 upper_bound, GLuint candidate_buffer_binding_index);
+
+    /**
+     * @brief Make subsequent dispatches operate on a part of a larger work group grid.
+     * @see EvaluationKernel::setSubGrid()
+     */
+    void setSubGrid(glm::uvec2 sub_grid_offset, uint grid_width);
+
+    /// Uniform buffer binding point to which the parameters of each dispatch are bound. Zero by default.
+    void setParameterBindingIndex(GLuint binding_index);
+
+    /**
+     * @brief Make each work group take its pattern from a buffer of alternative patterns.
+     * The tile used by a work group is chosen by hashing its grid index. The buffer, bound to
+     * @p pattern_tile_buffer_binding_index during dispatches, contains @p tile_count arrays of
+     * pattern_size.x * pattern_size.y positions, stored column by column, one after another. A single tile gives every
+     * work group the same pattern. Throws std::logic_error if @p tile_count is zero.
+     */
+    void setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count);
 
-    GenerationKernel();
-
-    /// Dispatch the compute kernel with the specified arguments.
-    void operator()(glm::uvec2 num_work_groups, glm::uvec2 group_offset, float footprint, glm::vec3 world_scale,
-                    GLuint heightmap_texture_unit, GLuint candidate_buffer_binding_index,
-                    GLuint world_uv_buffer_binding_index, GLuint density_buffer_binding_index);
-
-    template<typename ArrayLike>
-    void setWorkGroupPattern(const ArrayLike &values)
-    {
-        for (uint i = 0; i < work_group_size.x; i++)
-            setWorkGroupPatternColumn(i, values[i * work_group_size.y]);
-    }
-
-    template<typename NestedArrayLike>
-    void setWorkGroupPatternColumns(const NestedArrayLike &columns)
-    {
-        for (uint i = 0; i < work_group_size.x; i++)
-            setWorkGroupPatternColumn(i, columns[i]);
-    }
-
-    template<typename ArrayLike>
-    void setWorkGroupPatternColumn(uint column_index, const ArrayLike &column_values)
+    [[nodiscard]]
+    GLsizeiptr getPatternTileSize() const
     {
-        m_program.setUniform(m_work_group_pattern[column_index], column_values);
+        return m_configuration.getPatternCandidateCount() * static_cast<GLsizeiptr>(sizeof(glm::vec2));
     }
 
-    /// How much space does the pattern specified with setWorkGroupPattern() occupies.
+    /// How much space the pattern tiles set with setPatternTiles() occupy.
     void setWorkGroupPatternBoundaries(glm::vec2 boundaries)
     {
-        m_program.setUniform(m_work_group_scale, boundaries);
+        m_parameters.work_group_scale = boundaries;
     }
 
     [[nodiscard]]
     glm::vec2 getWorkGroupPatternBoundaries() const
     {
-        return m_work_group_scale.getValue();
-    }
-
-    [[nodiscard]]
-    static constexpr GLsizeiptr getCandidateBufferSizeRequirement(glm::uvec3 num_work_groups)
-    {
-        return s_calculateBufferSize(num_work_groups, sizeof(glm::vec4));
-    }
-
-    [[nodiscard]]
-    static constexpr GLsizeiptr getWorldUVBufferSizeRequirement(glm::uvec3 num_work_groups)
-    {
-        return s_calculateBufferSize(num_work_groups, sizeof(glm::vec2));
+        return m_parameters.work_group_scale;
     }
 
     [[nodiscard]]
-    static constexpr GLsizeiptr getDensityBufferMemoryRequirement(glm::uvec3 num_work_groups)
+    GLsizeiptr getCandidateBufferSizeRequirement(glm::uvec3 num_work_groups) const
     {
-        return s_calculateBufferSize(num_work_groups, sizeof(float));
+        return static_cast<GLsizeiptr>(num_work_groups.x) * num_work_groups.y
+               * m_configuration.getPatternCandidateCount() * candidate_size;
     }
 
 private:
-    [[nodiscard]]
-    static constexpr GLsizeiptr s_calculateBufferSize(glm::uvec3 num_work_groups, GLsizeiptr element_size)
+    /// Same layout as the std140 Parameters block of the shader.
+    struct alignas(16) Parameters
     {
-        const auto num_invocations = num_work_groups * work_group_size;
-        return num_invocations.x * num_invocations.y * element_size;
-    }
-
+        glm::vec2 work_group_scale {0.0f};
+        glm::vec2 lower_bound {0.0f};
+        glm::vec2 upper_bound {0.0f};
+        glm::uvec2 work_group_offset {0u};
+        glm::uvec2 num_work_groups {0u};
+        glm::uvec2 sub_grid_offset {0u};
+        float footprint {0.0f};
+        GLuint grid_width {0};
+        GLuint pattern_tile_count {0};
+    };
+    static_assert(sizeof(Parameters) == 64);
+
+    KernelConfiguration m_configuration;
     ComputeShaderProgram m_program;
 
     using CS = ComputeShaderProgram;
 
-    CS::TypedUniform<float> m_footprint;
-    CS::TypedUniform<glm::vec3> m_world_scale;
-    CS::TypedUniform<glm::vec2[work_group_size.x][work_group_size.y]> m_work_group_pattern;
-    CS::TypedUniform<glm::uvec2> m_work_group_offset;
-    CS::CachedUniform<glm::vec2> m_work_group_scale;
-    CS::CachedUniform<int> m_heightmap_tex;
+    /// Parameters of the next dispatch, except those passed to operator().
+    Parameters m_parameters;
+    UniformRingBuffer m_parameter_buffer;
+    CS::UniformBlock m_parameter_block;
     CS::ShaderStorageBlock m_candidate_buf;
-    CS::ShaderStorageBlock m_world_uv_buf;
-    CS::ShaderStorageBlock m_density_buf;
+    CS::ShaderStorageBlock m_pattern_tile_buf;
 };
 
 } // placement
@@ -2,16 +2,42 @@
 #define PROCEDURALPLACEMENTLIB_INDEXATION_KERNEL_HPP
 
 #include "compute_kernel.hpp"
+#include "kernel_configuration.hpp"
 
 namespace placement {
 
 class IndexationKernel final
 {
 public:
-    static constexpr glm::uvec3 work_group_size{32, 1, 1};
     static constexpr uint glsl_version{450};
 
-    IndexationKernel();
+    IndexationKernel() : IndexationKernel(KernelConfiguration{})
+    {}
+
+    /**
+     * @brief Compile the kernel with the indexation local size of @p configuration.
+     * The subgroup variant is compiled if configuration.subgroup_indexation is true and isSubgroupIndexationSupported()
+     * returns true. Both variants give the same counts, and the same indices wherever subgroups are made of consecutive
+     * invocations, as on current hardware.
+     */
+    explicit IndexationKernel(const KernelConfiguration &configuration);
+
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    IndexationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program);
+
+    /// Start compiling the program of the kernel for @p configuration, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync(const KernelConfiguration &configuration);
+
+    [[nodiscard]] uint getLocalSize() const { return m_local_size; }
+
+    /// Whether this kernel computes local offsets with subgroup operations rather than a scan in shared memory.
+    [[nodiscard]] bool usesSubgroups() const { return m_uses_subgroups; }
+
+    /**
+     * @brief Whether the current context supports the subgroup variant of the kernel, which requires
+     * GL_KHR_shader_subgroup with the basic, ballot and arithmetic features in compute shaders.
+     */
+    [[nodiscard]] static bool isSubgroupIndexationSupported();
 
     void operator()(uint num_work_groups, uint candidate_buffer_binding_index, uint count_buffer_binding_index,
                     uint index_buffer_binding_index);
@@ -28,13 +54,18 @@ public:
         return candidate_count * static_cast<GLsizeiptr>(sizeof(uint));
     }
 
+    /// Each invocation indexes two candidates.
     [[nodiscard]]
-    static constexpr uint calculateNumWorkGroups(uint candidate_count)
+    uint calculateNumWorkGroups(uint candidate_count) const
     {
-        return 1 + candidate_count / (2 * work_group_size.x);
+        return 1 + candidate_count / (2 * m_local_size);
     }
 
 private:
+    [[nodiscard]] static bool s_usesSubgroups(const KernelConfiguration &configuration);
+
+    uint m_local_size;
+    bool m_uses_subgroups;
     ComputeShaderProgram m_program;
 
     using CS = ComputeShaderProgram;
@@ -0,0 +1,80 @@
+#ifndef PROCEDURALPLACEMENTLIB_KERNEL_CONFIGURATION_HPP
+#define PROCEDURALPLACEMENTLIB_KERNEL_CONFIGURATION_HPP
+
+#include "glutils/gl_types.hpp"
+
+#include "glm/vec2.hpp"
+
+#include <array>
+#include <string>
+
+namespace placement {
+
+/**
+ * @brief Compile-time parameters of the placement kernels.
+ * The candidate grid is made of work groups of pattern_size candidates, which share a single disk pattern and dithering
+ * matrix. The compute work groups that process them are local_size invocations large, one invocation per candidate, so
+ * a compute work group may cover several work groups of the grid, or only part of one. The pattern size determines the
+ * placement results, while the local size only affects performance, and can be tuned per device.
+ *
+ * The IndexationKernel and the CopyKernel work on the candidate array as a one-dimensional grid, with their own local
+ * sizes, which also only affect performance. Where the device supports GL_KHR_shader_subgroup, the IndexationKernel
+ * computes the offsets of candidates with subgroup operations instead of a scan in shared memory, unless
+ * subgroup_indexation is false.
+ *
+ * All sizes are injected into the shader source as #defines, so each configuration is a separately compiled program.
+ */
+struct KernelConfiguration
+{
+    static constexpr glm::uvec2 default_pattern_size {8, 8};
+    static constexpr glm::uvec2 default_local_size {8, 8};
+
+    static constexpr GLuint default_indexation_local_size {32};
+    static constexpr GLuint default_copy_local_size {64};
+
+    /// The sizes, for either parameter, that all configurations are restricted to.
+    static constexpr std::array<glm::uvec2, 4> supported_sizes {{{4, 4}, {8, 8}, {16, 16}, {32, 8}}};
+
+    /// The local sizes supported by the IndexationKernel and the CopyKernel.
+    static constexpr std::array<GLuint, 4> supported_linear_sizes {32, 64, 128, 256};
+
+    glm::uvec2 pattern_size {default_pattern_size};
+    glm::uvec2 local_size {default_local_size};
+    GLuint indexation_local_size {default_indexation_local_size};
+    GLuint copy_local_size {default_copy_local_size};
+    bool subgroup_indexation {true};
+
+    [[nodiscard]] bool isSupported() const;
+
+    [[nodiscard]] GLuint getPatternCandidateCount() const { return pattern_size.x * pattern_size.y; }
+
+    /// Number of compute work groups needed to cover a grid of @p num_work_groups work groups of candidates.
+    [[nodiscard]] glm::uvec2 getDispatchSize(glm::uvec2 num_work_groups) const
+    {
+        return (num_work_groups * pattern_size + local_size - 1u) / local_size;
+    }
+
+    /**
+     * @brief Prepend the version directive and the #defines of this configuration to a kernel's source.
+     * Defines PATTERN_SIZE_X, PATTERN_SIZE_Y, LOCAL_SIZE_X, LOCAL_SIZE_Y, INDEXATION_LOCAL_SIZE and COPY_LOCAL_SIZE.
+     * Throws std::logic_error if the configuration is not supported.
+     * @param source GLSL source without a #version directive.
+     */
+    [[nodiscard]] std::string makeSource(const char *source, GLuint glsl_version = 450) const;
+
+    [[nodiscard]] bool operator==(const KernelConfiguration &other) const
+    {
+        return pattern_size == other.pattern_size && local_size == other.local_size
+               && indexation_local_size == other.indexation_local_size && copy_local_size == other.copy_local_size
+               && subgroup_indexation == other.subgroup_indexation;
+    }
+
+    [[nodiscard]] bool operator!=(const KernelConfiguration &other) const { return !(*this == other); }
+
+    /// Arbitrary strict ordering, for use as a map key.
+    [[nodiscard]] bool operator<(const KernelConfiguration &other) const;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_KERNEL_CONFIGURATION_HPP
@@ -0,0 +1,63 @@
+#ifndef PROCEDURALPLACEMENTLIB_REPROJECTION_KERNEL_HPP
+#define PROCEDURALPLACEMENTLIB_REPROJECTION_KERNEL_HPP
+
+#include "compute_kernel.hpp"
+#include "uniform_ring_buffer.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+namespace placement {
+
+/// Samples the heightmap again for elements that have already been placed, updating their z coordinate.
+class ReprojectionKernel final
+{
+public:
+    static constexpr glm::uvec3 work_group_size{64, 1, 1};
+
+    ReprojectionKernel();
+
+    /// Construct the kernel from a program returned by compileAsync(), waiting for it to be linked.
+    explicit ReprojectionKernel(ComputeShaderProgram &&program);
+
+    /// Start compiling the program of the kernel, see ComputeShaderProgram::compileAsync().
+    [[nodiscard]] static ComputeShaderProgram compileAsync();
+
+    /**
+     * @brief Dispatch the compute kernel with the specified arguments.
+     * Only the first @p element_count elements with lower_bound <= position.xy < upper_bound are modified.
+     */
+    void operator()(uint element_count, glm::vec3 world_scale, GLuint heightmap_texture_unit,
+                    glm::vec2 lower_bound, glm::vec2 upper_bound, GLuint element_buffer_binding_index);
+
+    /// Uniform buffer binding point to which the parameters of each dispatch are bound. Zero by default.
+    void setParameterBindingIndex(GLuint binding_index);
+
+    [[nodiscard]]
+    static constexpr uint calculateNumWorkGroups(uint element_count)
+    { return 1u + element_count / work_group_size.x; }
+
+private:
+    /// Same layout as the std140 Parameters block of the shader, where a uint following a vec3 fills its last 4 bytes.
+    struct alignas(16) Parameters
+    {
+        glm::vec3 world_scale {0.0f};
+        uint element_count {0};
+        glm::vec2 lower_bound {0.0f};
+        glm::vec2 upper_bound {0.0f};
+    };
+    static_assert(sizeof(Parameters) == 32);
+
+    ComputeShaderProgram m_program;
+
+    using CS = ComputeShaderProgram;
+
+    UniformRingBuffer m_parameter_buffer;
+    CS::UniformBlock m_parameter_block;
+    CS::CachedUniform<int> m_heightmap_tex;
+    CS::ShaderStorageBlock m_element_buffer;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_REPROJECTION_KERNEL_HPP
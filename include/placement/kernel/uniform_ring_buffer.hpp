@@ -0,0 +1,57 @@
+#ifndef PROCEDURALPLACEMENTLIB_UNIFORM_RING_BUFFER_HPP
+#define PROCEDURALPLACEMENTLIB_UNIFORM_RING_BUFFER_HPP
+
+#include "glutils/buffer.hpp"
+#include "glutils/sync.hpp"
+#include "glutils/gl_types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+namespace placement {
+
+/**
+ * @brief Persistently mapped uniform buffer from which every dispatch takes a new range for its parameter block.
+ * Since ranges are never reused while a dispatch may still read them, the parameters of several dispatches can be in
+ * flight at once. The buffer is split into segments, and a fence inserted when writing moves past a segment is waited
+ * on before writing to that segment again, once the buffer wraps around.
+ */
+class UniformRingBuffer
+{
+public:
+    static constexpr GLsizeiptr default_size = 64 << 10;
+    static constexpr std::size_t segment_count = 4;
+
+    explicit UniformRingBuffer(GLsizeiptr size = default_size);
+
+    /**
+     * @brief Copy @p size bytes to the next free range of the buffer, and bind that range to the uniform buffer binding
+     * point @p binding_index. Blocks if the range is still in use by dispatches issued a whole buffer ago.
+     * Throws std::logic_error if @p size is larger than a segment.
+     */
+    void bindData(GLuint binding_index, const void *data, GLsizeiptr size);
+
+    /// Copy a std140 parameter block to the next free range, and bind it. See bindData().
+    template<typename Block>
+    void bind(GLuint binding_index, const Block &block)
+    {
+        bindData(binding_index, &block, static_cast<GLsizeiptr>(sizeof(Block)));
+    }
+
+private:
+    void m_enterSegment(std::size_t segment);
+
+    GLsizeiptr m_size;
+    GLsizeiptr m_alignment {1};
+    GL::Buffer m_buffer;
+    std::byte *m_mapping {nullptr};
+    GLintptr m_offset {0};
+    std::size_t m_segment {0};
+    /// Signaled once the GPU is done with the commands that read each segment.
+    std::array<std::optional<GL::Sync>, segment_count> m_fences;
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_UNIFORM_RING_BUFFER_HPP
@@ -0,0 +1,54 @@
+#ifndef PROCEDURALPLACEMENTLIB_KERNEL_TUNING_HPP
+#define PROCEDURALPLACEMENTLIB_KERNEL_TUNING_HPP
+
+#include "kernel/kernel_configuration.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace placement {
+
+/**
+ * @brief Benchmark the supported local sizes of every placement kernel, and pick the fastest one for each of them.
+ * The kernels are dispatched over a synthetic region of about 250k candidates, a few times per local size, and timed
+ * on the host around glFinish(). This takes from a fraction of a second to a few seconds, mostly compiling the kernel
+ * variants, so the result should be cached, see getTunedKernelConfiguration().
+ *
+ * Uses shader storage binding points 0 to 3, uniform buffer binding point 0 and texture unit 0.
+ * @param pattern_size the pattern size of the returned configuration. It is not tuned, since it changes placement
+ *  results, but the fastest local sizes depend on it.
+ */
+[[nodiscard]]
+KernelConfiguration tuneKernelConfiguration(glm::uvec2 pattern_size = KernelConfiguration::default_pattern_size);
+
+/// The GL_RENDERER and GL_VERSION strings of the current context, which identify the device and its driver.
+[[nodiscard]] std::string getKernelTuningKey();
+
+/**
+ * @brief Read a tuned configuration from a tuning cache file.
+ * @return The configuration stored for the current device and @p pattern_size, or nothing if the file does not exist
+ *  or has no valid entry for them.
+ */
+[[nodiscard]]
+std::optional<KernelConfiguration> loadKernelTuning(const std::filesystem::path &cache_file, glm::uvec2 pattern_size);
+
+/**
+ * @brief Store a tuned configuration in a tuning cache file, replacing the entry of the current device for the same
+ * pattern size, if any. Entries of other devices and pattern sizes are kept.
+ * @return false if the file could not be written.
+ */
+bool saveKernelTuning(const std::filesystem::path &cache_file, const KernelConfiguration &configuration);
+
+/**
+ * @brief Load the configuration tuned for the current device from a tuning cache file, tuning the kernels and adding
+ * the result to the file on a cache miss.
+ * A cache file that cannot be written does not prevent tuning, but the kernels will be tuned again next time.
+ */
+[[nodiscard]]
+KernelConfiguration getTunedKernelConfiguration(const std::filesystem::path &cache_file,
+                                                glm::uvec2 pattern_size = KernelConfiguration::default_pattern_size);
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_KERNEL_TUNING_HPP
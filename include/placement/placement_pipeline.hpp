@@ -6,16 +6,27 @@
 #include "kernel/evaluation_kernel.hpp"
 #include "kernel/indexation_kernel.hpp"
 #include "kernel/copy_kernel.hpp"
+#include "kernel/fused_placement_kernel.hpp"
+#include "kernel/reprojection_kernel.hpp"
 
 #include "glutils/sync.hpp"
 #include "glutils/buffer.hpp"
 
 #include "glm/glm.hpp"
 #include "density_map.hpp"
+#include "density_pyramid.hpp"
+#include "class_tile_grid.hpp"
+#include "threshold_texture.hpp"
+#include "kernel_tuning.hpp"
 
 #include <vector>
 #include <chrono>
+#include <filesystem>
 #include <optional>
+#include <memory>
+#include <map>
+#include <exception>
+#include <unordered_map>
 
 namespace placement {
 
@@ -27,6 +38,12 @@ struct LayerData
 
     /// An array of density maps, each one representing a different "object class".
     std::vector<DensityMap> densitymaps;
+
+    /**
+     * Optional grid of the classes present in each part of the world, for layers with many classes. It must have been
+     * built from the current contents of the density maps, see PlacementPipeline::buildClassTileGrid().
+     */
+    std::shared_ptr<const ClassTileGrid> class_tiles;
 };
 
 /// World data contains information about the landscape objects are placed on.
@@ -44,29 +61,267 @@ class PlacementPipeline
 public:
     PlacementPipeline();
 
+    /// Construct the pipeline with the kernels of @p configuration, see setKernelConfiguration().
+    explicit PlacementPipeline(const KernelConfiguration &configuration);
+
+    /**
+     * @brief Construct the pipeline with the configuration tuned for the current device, with the default pattern size.
+     * The configuration is read from @p tuning_cache_file, or tuned and added to it if the file has none for the
+     * device, see getTunedKernelConfiguration().
+     */
+    explicit PlacementPipeline(const std::filesystem::path &tuning_cache_file);
+
+    /**
+     * @brief Start constructing a pipeline without waiting for its kernels to compile.
+     * The kernels are compiled in the background where GL_KHR_parallel_shader_compile is supported, so the
+     * application can keep rendering while isReady() is false. Construction is completed by waitReady(), which every
+     * operation that dispatches kernels calls implicitly, and which throws if a kernel failed to compile.
+     */
+    [[nodiscard]]
+    static PlacementPipeline createAsync(const KernelConfiguration &configuration = KernelConfiguration{});
+
+    ~PlacementPipeline();
+
+    PlacementPipeline(PlacementPipeline&&);
+    PlacementPipeline& operator=(PlacementPipeline&&);
+
+    /// Whether the kernels have been compiled, so that waitReady() will not block. See createAsync().
+    [[nodiscard]] bool isReady() const;
+
+    /**
+     * @brief Block until the kernels have been compiled, and finish constructing the pipeline. See createAsync().
+     * If a kernel failed to compile, the pipeline cannot be used, and this throws the same error on every call.
+     */
+    void waitReady();
+
     /// Multiclass placement.
     [[nodiscard]]
     FutureResult computePlacement(const WorldData &world_data, const LayerData &layer_data,
                                   glm::vec2 lower_bound, glm::vec2 upper_bound);
 
+    /**
+     * @brief Same as computePlacement(), but using @p seed instead of the random seed of the pipeline for this call.
+     * Patterns are cached per seed (see setRandomSeed()), so switching between a few seeds, for example one per layer,
+     * is as cheap as placing with a single one.
+     */
+    [[nodiscard]]
+    FutureResult computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                  glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed);
+
+    /**
+     * @brief Recompute placement for a region after a part of its density maps was modified.
+     * If the candidates of the region are cached (see setIncrementalMode()), only the work groups overlapping the dirty
+     * rectangle are evaluated again, so the cost of evaluation is proportional to the size of the modified area rather
+     * than to the size of the region. Elements outside of the dirty rectangle are kept as they were. Compaction still
+     * covers the whole region, and a new result is returned, since the element count of each class may change. When
+     * the candidates of the region are not cached, this is equivalent to computePlacement().
+     *
+     * @param dirty_lower_bound, dirty_upper_bound the modified area, in world space. Texture space rectangles can be
+     *  converted by multiplying them by the xy components of the world scale. If density maps are sampled with linear
+     *  filtering, the rectangle should be extended by one texel on each side.
+     *
+     * Heights are sampled from the heightmap during compaction, so modifications of the heightmap are reflected in the
+     * whole result, whatever the dirty rectangle.
+     */
+    [[nodiscard]]
+    FutureResult updatePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                 glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                 glm::vec2 dirty_lower_bound, glm::vec2 dirty_upper_bound);
+
+    /**
+     * @brief Update the heights of placed elements after the heightmap was modified.
+     * The xy positions of elements do not depend on the heightmap, so when the contents of the heightmap texture
+     * change, resampling it for each element is enough to bring a result up to date. This is a single dispatch over
+     * the elements of the result, without generation, evaluation or compaction.
+     *
+     * @param result the result to update. Its buffer is modified in place and moved into the returned FutureResult.
+     * @param world_data world data with the modified heightmap. The world scale must be the one used for placement.
+     * @return A FutureResult that will contain the updated elements.
+     */
+    [[nodiscard]]
+    FutureResult reprojectHeights(Result &&result, const WorldData &world_data);
+
+    /// Same as reprojectHeights(), but only elements inside the given rectangle, in world space, are updated.
+    [[nodiscard]]
+    FutureResult reprojectHeights(Result &&result, const WorldData &world_data,
+                                  glm::vec2 dirty_lower_bound, glm::vec2 dirty_upper_bound);
+
     /**
      * @brief set the seed for the random number generator.
      * For a given set of heightmap, densitymap and world scale, the random seed completely determines placement.
+     *
+     * The work group pattern and the blue noise thresholds generated from a seed are cached, so setting a seed that was
+     * used before only uploads them again. Up to max_cached_patterns seeds are kept.
      */
     void setRandomSeed(uint seed);
 
+    [[nodiscard]] uint getRandomSeed() const { return m_random_seed; }
+
+    /// Number of seeds whose patterns are kept before the pattern cache is cleared.
+    static constexpr std::size_t max_cached_patterns = 64;
+
+    /**
+     * @brief Select the pattern size and the local sizes of the placement kernels.
+     * Each configuration is compiled the first time a pipeline selects it, and shared by all the pipelines that select
+     * it. This pipeline keeps it for as long as it lives, so switching back to it is cheap. Local sizes only affect
+     * performance, and the best ones depend on the device, see tuneKernelConfiguration(). The pattern size is the
+     * number of candidates in each work group of the candidate grid, which share a disk pattern and a dithering matrix:
+     * larger patterns repeat less visibly, but change the results. Changing it discards the cached patterns and
+     * candidates. Throws std::logic_error if the configuration is not supported.
+     */
+    void setKernelConfiguration(const KernelConfiguration &configuration);
+
+    [[nodiscard]] const KernelConfiguration &getKernelConfiguration() const;
+
+    /**
+     * @brief Accept candidates using a tileable blue noise threshold texture instead of the dithering matrix.
+     * The period of the dithering matrix is only the pattern size, 8 candidates by default, which shows up as regular
+     * patterns unless candidates are much denser than the placed objects. A blue noise texture of size x size
+     * thresholds, shifted by the random seed, pushes the period to size candidates and spreads rejected candidates
+     * evenly, giving acceptable results at lower candidate densities. Sizes of 64 or 128 are a good compromise, as
+     * generation time grows with the square of the number of texels, although each size is only generated once, see
+     * generateBlueNoise(). Sizes need not be powers of two. A size of zero restores the dithering matrix.
+     */
+    void setBlueNoiseThresholds(uint size);
+
+    /// Size of the blue noise threshold texture, or zero if the dithering matrix is used.
+    [[nodiscard]] uint getBlueNoiseSize() const { return m_blue_noise_size; }
+
+    /**
+     * @brief Vary the pattern of candidates between work groups.
+     * By default every work group of the candidate grid uses the same pattern, so its repetition becomes visible
+     * unless the footprint is small compared to the spacing of placed objects. With a count greater than one, the
+     * pipeline generates that many alternative patterns for each seed, which share the points near their borders but
+     * differ in their interior, and each work group picks one of them by hashing its grid index. Since only the
+     * interiors differ, the minimum separation between candidates still holds across work group boundaries.
+     */
+    void setPatternTileCount(uint count);
+
+    [[nodiscard]] uint getPatternTileCount() const { return m_pattern_tile_count; }
+
+    /**
+     * @brief Enable or disable the reuse of generated candidates between calls to computePlacement().
+     * Candidate positions only depend on the random seed, the world scale, the footprint and the placement bounds. In
+     * incremental mode the pipeline keeps the candidates of the last @p max_cached_regions regions it placed, and
+     * when computePlacement() is called again with the same arguments except for the density maps or the heightmap,
+     * generation is skipped and only the density maps are evaluated again. Cached candidates are also keyed by the
+     * random seed. This makes interactive editing of density maps much cheaper, at the cost of keeping the candidate
+     * buffers of the cached regions alive.
+     */
+    void setIncrementalMode(bool enabled, uint max_cached_regions = 1);
+
+    [[nodiscard]] bool isIncrementalModeEnabled() const { return m_max_cached_regions > 0; }
+
+    /// Discard all the candidates kept in incremental mode, forcing the next placement to generate them again.
+    void invalidateCandidates();
+
+    /**
+     * @brief Provide a min/max pyramid for a density map texture, enabling culling for the density maps that use it.
+     * During placement, classes whose density is zero over the whole region are skipped, and if no class can place
+     * any element the result is empty and nothing is dispatched. Unless incremental mode is enabled, the dispatched
+     * work groups are also reduced to the bounding box of the populated area. Culling is conservative, so results are
+     * identical to those obtained without it, provided the pyramid matches the contents and the wrap modes of the
+     * texture.
+     *
+     * The pyramid must be updated or removed when the texture, or its wrap modes, are modified. Each channel of a
+     * texture holding packed density maps has a pyramid of its own.
+     */
+    void setDensityPyramid(GLuint texture, DensityPyramid pyramid,
+                           DensityMap::Channel channel = DensityMap::Channel::red);
+
+    /// Read back a channel of a density map texture and build its pyramid. See setDensityPyramid().
+    void buildDensityPyramid(GLuint texture, DensityMap::Channel channel = DensityMap::Channel::red);
+
+    /// Stop using the pyramids of all the channels of a texture for culling.
+    void removeDensityPyramid(GLuint texture);
+
+    /**
+     * @brief Build the class tile grid of a layer from the pyramids of its density maps, see LayerData::class_tiles.
+     * With a class tile grid, the classes of a layer are only evaluated over the work groups that overlap the tiles
+     * where they are present, and the classes of a region are found without querying the pyramid of every class.
+     * Results are identical to those obtained without it. Throws std::logic_error if a density map has no pyramid.
+     * @param size number of tiles along each axis, over the whole world.
+     */
+    [[nodiscard]] ClassTileGrid buildClassTileGrid(const std::vector<DensityMap> &density_maps,
+                                                   glm::uvec2 size) const;
+
+    /**
+     * @brief Sample density maps at a mip level matched to the footprint instead of the base level.
+     * When the footprint spans several texels of a density map, sampling the base level reads texels far apart from
+     * each other, which thrashes the texture cache and aliases the density. With footprint filtering, each candidate
+     * reads the density averaged over an area about the size of its footprint, from the mip level whose texels are as
+     * large as the footprint. Density maps must have prefiltered mip levels and a mipmapped minification filter, see
+     * generateDensityMipmaps(). Results differ from unfiltered ones wherever density varies within a footprint.
+     */
+    void setFootprintFiltering(bool enabled) { m_footprint_filtering = enabled; }
+
+    [[nodiscard]] bool isFootprintFilteringEnabled() const { return m_footprint_filtering; }
+
+    /**
+     * @brief Generate the mip levels of a density map texture, and select trilinear minification for it.
+     * Must be called again after modifying the texture. Throws std::logic_error if the texture has immutable storage
+     * without mip levels.
+     */
+    static void generateDensityMipmaps(GLuint texture);
+
+    /**
+     * @brief Limit the GPU memory used by a single placement operation.
+     * Regions whose candidates do not fit in the budget, or in the device limits on dispatch size and shader storage
+     * block size, are split into tiles that are placed one after another. The elements of every tile are stitched
+     * into a single result, identical to the one a single dispatch would produce except for the order of the elements
+     * within each class. Splitting waits for each tile to finish, so computePlacement() blocks until the whole region
+     * is placed, and incremental mode does not cache the candidates of split regions.
+     *
+     * The budget covers the candidates of a tile and their worst-case results, not the final result, whose size
+     * depends on the number of elements placed: 28 bytes per candidate, 12 for its density, class and index, and 16
+     * for its slot in the results of the tile. The elements of each tile are staged in host memory until the final
+     * result is created, so the GPU memory in use is at most the budget plus the final result.
+     * @param bytes the budget in bytes, or zero to only split regions that exceed the device limits.
+     */
+    void setMemoryBudget(GLsizeiptr bytes);
+
+    [[nodiscard]] GLsizeiptr getMemoryBudget() const { return m_memory_budget; }
+
+    /**
+     * @brief Place small regions with a single dispatch.
+     * Below a few thousand candidates, the fixed costs of placement dominate: four dispatches or more, the barriers
+     * between them and the allocation of a candidate buffer. Regions of at most @p candidate_count candidates, with at
+     * most FusedPlacementKernel::max_class_count classes, are instead placed by a single compute work group that
+     * generates, evaluates and compacts the candidates on its own (see FusedPlacementKernel). Results are the same,
+     * except for the order of the elements within each class. Incremental mode always uses the separate kernels, since
+     * it keeps the candidates.
+     *
+     * Single dispatch placement is disabled by default, as it uses single_dispatch_texture_units texture units rather
+     * than required_texture_units. Its kernel is only compiled once it is enabled, and if it fails to compile, for
+     * instance because the device has too few texture units or too little shared memory, the separate kernels are used
+     * instead.
+     * @param candidate_count the threshold, at most FusedPlacementKernel::max_candidate_count. Zero, the default,
+     *  disables single dispatch placement.
+     */
+    void setSingleDispatchThreshold(uint candidate_count);
+
+    [[nodiscard]] uint getSingleDispatchThreshold() const { return m_single_dispatch_threshold; }
+
     /// The number of different texture units used by the placement compute shaders
     static constexpr auto required_texture_units = 2u;
 
+    /**
+     * The number of different texture units used once single dispatch placement is enabled, which binds the density map
+     * of each class to its own texture unit. See setSingleDispatchThreshold().
+     */
+    static constexpr auto single_dispatch_texture_units =
+            required_texture_units + FusedPlacementKernel::max_class_count;
+
     /**
      * @brief Configures the texture units the pipeline will use
      * @param index the index of a texture unit such that indices in the range [index, index + required_texture_units)
-     *      are all valid texture unit indices.
+     *      are all valid texture unit indices, or [index, index + single_dispatch_texture_units) if single dispatch
+     *      placement is enabled.
      */
     void setBaseTextureUnit(GLuint index);
 
     /// The number of different shader storage buffer binding points used by the placement compute shaders.
-    static constexpr auto required_shader_storage_binding_points = 6u;
+    static constexpr auto required_shader_storage_binding_points = 5u;
 
     /**
      * @brief Configures the shader storage buffer binding points the pipeline will use.
@@ -75,17 +330,135 @@ public:
      */
     void setBaseShaderStorageBindingPoint(GLuint index);
 
+    /**
+     * @brief Configures the uniform buffer binding point the pipeline will use.
+     * The parameters of every kernel dispatch are written to a persistently mapped uniform buffer, and the range
+     * holding them is bound to this binding point just before the dispatch. Zero by default.
+     */
+    void setUniformBufferBindingPoint(GLuint index);
+
 private:
-    [[nodiscard]] static ResultBuffer s_makeResultBuffer(uint candidate_count, uint class_count);
+    struct CandidateCache;
+    struct SeedPattern;
+    struct KernelVariant;
+    struct KernelPrograms;
+    struct PendingKernels;
+
+    PlacementPipeline(const KernelConfiguration &configuration, bool wait);
+
+    struct DirtyRect
+    {
+        glm::vec2 lower_bound;
+        glm::vec2 upper_bound;
+    };
+
+    [[nodiscard]]
+    FutureResult m_computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                    glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed,
+                                    const DirtyRect *dirty_rect);
+
+    /// Generate the pattern of a seed or fetch it from the cache, and make the kernels use it.
+    void m_usePattern(uint seed);
+
+    /// Place a small region with a single dispatch of the FusedPlacementKernel, see setSingleDispatchThreshold().
+    [[nodiscard]]
+    FutureResult m_computeSingleDispatchPlacement(FusedPlacementKernel &kernel,
+                                                  const WorldData &world_data, const LayerData &layer_data,
+                                                  glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                                  const std::vector<bool> &active_classes,
+                                                  glm::uvec2 work_group_offset, glm::uvec2 num_work_groups);
+
+    /// Dispatch all the placement kernels over a grid of work groups, using the buffers currently bound.
+    void m_dispatchKernels(const WorldData &world_data, const LayerData &layer_data,
+                           glm::vec2 lower_bound, glm::vec2 upper_bound, const std::vector<bool> &active_classes,
+                           glm::uvec2 work_group_offset, glm::uvec2 num_work_groups, glm::uvec2 sub_grid_offset,
+                           glm::uvec2 sub_grid_size, bool generate);
+
+    /// Place a region one tile at a time, and merge the elements of all the tiles, staged in host memory, into a
+    /// single result.
+    [[nodiscard]]
+    FutureResult m_computeTiledPlacement(const WorldData &world_data, const LayerData &layer_data,
+                                         glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                         const std::vector<bool> &active_classes, glm::uvec2 work_group_offset,
+                                         glm::uvec2 num_work_groups, glm::uvec2 tile_size);
+
+    /// Largest tile of a work group grid that can be placed within the device limits and the memory budget.
+    [[nodiscard]] glm::uvec2 m_getTileSize(glm::uvec2 num_work_groups) const;
+
+    /**
+     * @brief Work groups of [@p begin, @p end) in a grid in which some of the classes of a layer may have a nonzero
+     * density, according to its class tile grid, as disjoint ranges. There are none if no class is present.
+     */
+    [[nodiscard]] std::vector<std::pair<glm::uvec2, glm::uvec2>>
+    m_getClassWorkGroups(const WorldData &world_data, const LayerData &layer_data,
+                         const std::vector<uint> &class_indices, glm::uvec2 work_group_offset,
+                         glm::uvec2 begin, glm::uvec2 end) const;
+
+    /// Transformed range of a density map over a region, or nothing if it has no pyramid.
+    [[nodiscard]] std::optional<glm::vec2> m_getDensityRange(const DensityMap &density_map, const WorldData &world_data,
+                                                             float footprint, glm::vec2 lower_bound,
+                                                             glm::vec2 upper_bound) const;
+
+    /**
+     * @brief Kernels of @p configuration from the registry, compiled and registered first if no pipeline has them.
+     * @param programs programs to construct the kernels from, if they have to be compiled.
+     */
+    [[nodiscard]] static std::shared_ptr<KernelVariant> s_getKernelVariant(const KernelConfiguration &configuration,
+                                                                           KernelPrograms *programs = nullptr);
+
+    /// Same as s_getKernelVariant(), for the reprojection kernel.
+    [[nodiscard]] static std::shared_ptr<ReprojectionKernel> s_getReprojectionKernel(ComputeShaderProgram *program
+                                                                                      = nullptr);
+
+    /**
+     * @brief Mapped result buffer with room for @p candidate_count elements.
+     * @param data the counts followed by the elements to initialize the buffer with, or null to zero the counts.
+     */
+    [[nodiscard]] static ResultBuffer s_makeResultBuffer(uint candidate_count, uint class_count,
+                                                         const void *data = nullptr);
     [[nodiscard]] uint m_getBindingIndex(uint buffer_index) const;
 
     uint m_base_tex_unit {0};
     uint m_base_binding_index {0};
+    uint m_uniform_binding_index {0};
     glm::vec2 m_work_group_scale;
-    GenerationKernel m_generation_kernel;
-    EvaluationKernel m_evaluation_kernel;
-    IndexationKernel m_indexation_kernel;
-    CopyKernel m_copy_kernel;
+    /**
+     * Kernels shared by all the pipelines, which only use the GL context that the library was loaded with. The
+     * registry does not own them, so that they are deleted along with the last pipeline using them, while the context
+     * is still current. Pipelines set all the state of a kernel before dispatching it.
+     */
+    static std::map<KernelConfiguration, std::weak_ptr<KernelVariant>> s_kernel_registry;
+    static std::weak_ptr<ReprojectionKernel> s_reprojection_kernel;
+
+    /// Placement kernels of every configuration selected by this pipeline.
+    std::map<KernelConfiguration, std::shared_ptr<KernelVariant>> m_kernel_variants;
+    /// Variant selected with setKernelConfiguration().
+    KernelVariant *m_kernels {nullptr};
+    std::shared_ptr<ReprojectionKernel> m_reprojection_kernel;
+    /// Kernels of an asynchronous construction that have not been waited for yet, or that failed to compile.
+    std::unique_ptr<PendingKernels> m_pending_kernels;
+    /// Error thrown while completing an asynchronous construction, rethrown by every later waitReady().
+    std::exception_ptr m_kernel_error;
+
+    uint m_max_cached_regions {0};
+    /// Cached candidates, from least to most recently used.
+    std::vector<std::unique_ptr<CandidateCache>> m_candidate_cache;
+
+    std::map<std::pair<GLuint, DensityMap::Channel>, DensityPyramid> m_density_pyramids;
+
+    bool m_footprint_filtering {false};
+
+    uint m_random_seed {0};
+    uint m_blue_noise_size {0};
+    uint m_pattern_tile_count {1};
+    std::unordered_map<uint, std::unique_ptr<SeedPattern>> m_seed_patterns;
+    /// Seed of the pattern used by the next dispatch.
+    std::optional<uint> m_pattern_seed;
+
+    GLsizeiptr m_memory_budget {0};
+    uint m_single_dispatch_threshold {0};
+    glm::uvec2 m_max_work_group_count {0u};
+    GLsizeiptr m_max_storage_block_size {0};
 };
 
 } // placement
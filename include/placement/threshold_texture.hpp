@@ -0,0 +1,57 @@
+#ifndef PROCEDURALPLACEMENTLIB_THRESHOLD_TEXTURE_HPP
+#define PROCEDURALPLACEMENTLIB_THRESHOLD_TEXTURE_HPP
+
+#include "glutils/gl_types.hpp"
+
+#include <vector>
+
+namespace placement {
+
+/**
+ * @brief Generate a tileable blue noise threshold matrix with the void-and-cluster method.
+ * Every value in {0, 1/n, ..., (n-1)/n}, where n = size * size, appears exactly once, and values close to each other
+ * are spread evenly over the matrix, also across its edges. The matrix of each size is only generated once, and
+ * cached; @p seed selects a toroidal shift of it, so the result only depends on @p size and @p seed. Thread safe.
+ * @return size * size values, stored row by row.
+ */
+[[nodiscard]] std::vector<float> generateBlueNoise(GLuint size, GLuint seed);
+
+/**
+ * @brief Square texture of acceptance thresholds, used by the EvaluationKernel in place of the dithering matrix.
+ * The texture is tiled over the world at a rate of one texel per candidate, so its size is the period of the threshold
+ * pattern: larger sizes hide repetition at lower candidate densities.
+ */
+class ThresholdTexture
+{
+public:
+    /**
+     * @brief Upload a threshold matrix.
+     * @param size width and height of the texture, in texels.
+     * @param values size * size values in [0, 1), stored row by row.
+     */
+    ThresholdTexture(GLuint size, const float *values);
+
+    /// Generate and upload a blue noise threshold matrix. See generateBlueNoise().
+    [[nodiscard]] static ThresholdTexture fromSeed(GLuint size, GLuint seed);
+
+    ~ThresholdTexture();
+
+    ThresholdTexture(const ThresholdTexture&) = delete;
+    ThresholdTexture& operator=(const ThresholdTexture&) = delete;
+
+    ThresholdTexture(ThresholdTexture &&other) noexcept;
+    ThresholdTexture& operator=(ThresholdTexture &&other) noexcept;
+
+    /// Name of the GL texture object.
+    [[nodiscard]] GLuint getTexture() const { return m_texture; }
+
+    [[nodiscard]] GLuint getSize() const { return m_size; }
+
+private:
+    GLuint m_texture {0};
+    GLuint m_size {0};
+};
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_THRESHOLD_TEXTURE_HPP
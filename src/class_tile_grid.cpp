@@ -0,0 +1,126 @@
+#include "placement/class_tile_grid.hpp"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace placement {
+
+ClassTileGrid::ClassTileGrid(glm::uvec2 size, const std::vector<DensityMap> &density_maps,
+                             const std::vector<const DensityPyramid*> &pyramids)
+        : m_size(size),
+          m_class_count(static_cast<uint>(density_maps.size()))
+{
+    if (size.x == 0 || size.y == 0)
+        throw std::logic_error("class tile grid size must be non-zero");
+
+    if (pyramids.size() != density_maps.size()
+        || std::find(pyramids.begin(), pyramids.end(), nullptr) != pyramids.end())
+        throw std::logic_error("class tile grids require the pyramid of every density map");
+
+    for (const DensityPyramid *pyramid : pyramids)
+        m_repeat = glm::bvec2(m_repeat.x || pyramid->getRepeat().x, m_repeat.y || pyramid->getRepeat().y);
+
+    m_tile_offsets.reserve(size.x * size.y + 1);
+    m_tile_offsets.push_back(0);
+
+    for (uint y = 0; y < size.y; y++)
+        for (uint x = 0; x < size.x; x++)
+        {
+            const glm::vec2 lower = getTileLowerBound(glm::ivec2(x, y));
+            const glm::vec2 upper = getTileLowerBound(glm::ivec2(x + 1, y + 1));
+
+            // same criterion as for the classes of a placement region: any nonzero density, even a negative one.
+            for (uint i = 0; i < m_class_count; i++)
+            {
+                const glm::vec2 range = pyramids[i]->getRange(density_maps[i], lower, upper);
+                if (range.x != 0.0f || range.y != 0.0f)
+                    m_classes.push_back(i);
+            }
+
+            m_tile_offsets.push_back(static_cast<uint>(m_classes.size()));
+        }
+}
+
+std::vector<uint> ClassTileGrid::getTileClasses(glm::uvec2 tile) const
+{
+    const uint index = m_getTileIndex(tile);
+    return {m_classes.begin() + m_tile_offsets[index], m_classes.begin() + m_tile_offsets[index + 1]};
+}
+
+bool ClassTileGrid::isClassPresent(glm::ivec2 tile, uint class_index) const
+{
+    const auto [clamped_x, wrapped_x] = m_getSampledTiles(tile.x, 0);
+    const auto [clamped_y, wrapped_y] = m_getSampledTiles(tile.y, 1);
+
+    for (const glm::uvec2 sampled_tile : {glm::uvec2(clamped_x, clamped_y), glm::uvec2(wrapped_x, clamped_y),
+                                          glm::uvec2(clamped_x, wrapped_y), glm::uvec2(wrapped_x, wrapped_y)})
+    {
+        const uint index = m_getTileIndex(sampled_tile);
+        const auto begin = m_classes.begin() + m_tile_offsets[index];
+        const auto end = m_classes.begin() + m_tile_offsets[index + 1];
+
+        if (std::binary_search(begin, end, class_index))
+            return true;
+    }
+
+    return false;
+}
+
+std::pair<glm::ivec2, glm::ivec2> ClassTileGrid::getTileRange(glm::vec2 lower_uv, glm::vec2 upper_uv) const
+{
+    const glm::vec2 size {m_size};
+    return {glm::ivec2(glm::floor(lower_uv * size)), glm::ivec2(glm::floor(upper_uv * size)) + 1};
+}
+
+glm::vec2 ClassTileGrid::getTileLowerBound(glm::ivec2 tile) const
+{
+    return glm::vec2(tile) / glm::vec2(m_size);
+}
+
+std::vector<bool> ClassTileGrid::getPresentClasses(glm::vec2 lower_uv, glm::vec2 upper_uv) const
+{
+    // the tiles of the grid sampled along each axis, which the rectangle may cover several times over.
+    const auto [begin, end] = getTileRange(lower_uv, upper_uv);
+    std::vector<bool> sampled[2];
+    for (int i = 0; i < 2; i++)
+    {
+        sampled[i].resize(m_size[i], false);
+
+        const uint first = m_getSampledTiles(begin[i], i).first;
+        const uint last = m_getSampledTiles(end[i] - 1, i).first;
+        for (uint tile = first; tile <= last; tile++)
+            sampled[i][tile] = true;
+
+        // wrapped tiles repeat after one period.
+        const int wrapped_end = std::min(end[i], begin[i] + static_cast<int>(m_size[i]));
+        for (int tile = begin[i]; tile < wrapped_end; tile++)
+            sampled[i][m_getSampledTiles(tile, i).second] = true;
+    }
+
+    std::vector<bool> present(m_class_count, false);
+    for (uint y = 0; y < m_size.y; y++)
+        for (uint x = 0; x < m_size.x; x++)
+        {
+            if (!sampled[0][x] || !sampled[1][y])
+                continue;
+
+            const uint index = m_getTileIndex({x, y});
+            for (uint i = m_tile_offsets[index]; i < m_tile_offsets[index + 1]; i++)
+                present[m_classes[i]] = true;
+        }
+
+    return present;
+}
+
+std::pair<uint, uint> ClassTileGrid::m_getSampledTiles(int tile, int axis) const
+{
+    const int size = static_cast<int>(m_size[axis]);
+    const int clamped = std::clamp(tile, 0, size - 1);
+    const int wrapped = m_repeat[axis] ? (tile % size + size) % size : clamped;
+
+    return {clamped, wrapped};
+}
+
+} // placement
@@ -0,0 +1,37 @@
+#include "placement/cpu/image.hpp"
+#include "placement_kernel.hpp"
+
+#include <stdexcept>
+
+namespace placement::cpu {
+
+Image::Image(glm::uvec2 size, std::vector<float> values) : m_size(size), m_values(std::move(values))
+{
+    if (size.x == 0 || size.y == 0)
+        throw std::logic_error("image size must be non-zero");
+
+    if (m_values.size() != static_cast<std::size_t>(size.x) * size.y)
+        throw std::logic_error("incorrect number of values for the image size");
+}
+
+Image Image::fromUnorm8(glm::uvec2 size, const std::uint8_t *values)
+{
+    std::vector<float> normalized(static_cast<std::size_t>(size.x) * size.y);
+    for (std::size_t i = 0; i < normalized.size(); i++)
+        normalized[i] = static_cast<float>(values[i]) / 255.0f;
+
+    return {size, std::move(normalized)};
+}
+
+float Image::fetch(glm::ivec2 texel) const
+{
+    return fetchKernelImage(makeKernelImage(*this), texel.x, texel.y);
+}
+
+float Image::sample(glm::vec2 uv) const
+{
+    // the placement kernels sample images with the same function.
+    return sampleKernelImage(makeKernelImage(*this), uv.x, uv.y);
+}
+
+} // placement::cpu
@@ -0,0 +1,170 @@
+#include "placement_kernel.hpp"
+#include "placement/cpu/image.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace placement::cpu {
+
+namespace {
+
+bool isSameImage(const KernelImage &l, const KernelImage &r)
+{
+    return l.values == r.values && l.linear == r.linear && l.repeat == r.repeat;
+}
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+/// ECX and EBX bits of CPUID leaves 1 and 7, and whether the OS saves the AVX registers.
+struct CPUFeatures
+{
+    bool sse41 {false};
+    bool avx2 {false};
+
+    CPUFeatures()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        sse41 = (info[2] & (1 << 19)) != 0;
+        const bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0
+                            && (_xgetbv(0) & 0x6) == 0x6;
+
+        if (max_leaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = os_avx && (info[1] & (1 << 5)) != 0;
+        }
+    }
+};
+#endif
+
+} // namespace
+
+bool isSSE41Supported()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    static const CPUFeatures features;
+    return features.sse41;
+#else
+    return false;
+#endif
+}
+
+bool isAVX2Supported()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    // also checks that the OS saves the AVX registers.
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    static const CPUFeatures features;
+    return features.avx2;
+#else
+    return false;
+#endif
+}
+
+KernelImage makeKernelImage(const Image &image)
+{
+    return {image.getValues().data(), static_cast<std::int32_t>(image.getSize().x),
+            static_cast<std::int32_t>(image.getSize().y), image.getFilter() == Image::Filter::linear,
+            image.getWrap() == Image::Wrap::repeat};
+}
+
+float fetchKernelImage(const KernelImage &image, std::int32_t x, std::int32_t y)
+{
+    if (image.repeat)
+    {
+        x = ((x % image.width) + image.width) % image.width;
+        y = ((y % image.height) + image.height) % image.height;
+    }
+    else
+    {
+        x = std::clamp(x, 0, image.width - 1);
+        y = std::clamp(y, 0, image.height - 1);
+    }
+
+    return image.values[y * image.width + x];
+}
+
+float sampleKernelImage(const KernelImage &image, float u, float v)
+{
+    const float width = static_cast<float>(image.width);
+    const float height = static_cast<float>(image.height);
+
+    if (!image.linear)
+        return fetchKernelImage(image, static_cast<std::int32_t>(std::floor(u * width)),
+                                static_cast<std::int32_t>(std::floor(v * height)));
+
+    // the four texels around (u, v), weighted as in section 8.14.2 of the OpenGL 4.5 specification.
+    const float x = u * width - 0.5f;
+    const float y = v * height - 0.5f;
+    const float lower_x = std::floor(x);
+    const float lower_y = std::floor(y);
+    const float weight_x = x - lower_x;
+    const float weight_y = y - lower_y;
+    const auto i = static_cast<std::int32_t>(lower_x);
+    const auto j = static_cast<std::int32_t>(lower_y);
+
+    // the SIMD kernels evaluate this expression in the same order.
+    return (1.0f - weight_x) * (1.0f - weight_y) * fetchKernelImage(image, i, j)
+           + weight_x * (1.0f - weight_y) * fetchKernelImage(image, i + 1, j)
+           + (1.0f - weight_x) * weight_y * fetchKernelImage(image, i, j + 1)
+           + weight_x * weight_y * fetchKernelImage(image, i + 1, j + 1);
+}
+
+void placeWorkGroupScalar(const KernelParameters &parameters, const KernelWorkGroup &work_group,
+                          const KernelOutput &output)
+{
+    for (std::uint32_t k = 0; k < work_group.candidate_count; k++)
+    {
+        const float x = parameters.footprint * (work_group.pattern_x[k] + work_group.offset_x);
+        const float y = parameters.footprint * (work_group.pattern_y[k] + work_group.offset_y);
+
+        output.x[k] = x;
+        output.y[k] = y;
+        output.class_indices[k] = invalid_class_index;
+
+        if (x < parameters.lower_bound[0] || y < parameters.lower_bound[1]
+            || x >= parameters.upper_bound[0] || y >= parameters.upper_bound[1])
+            continue;
+
+        const float u = x / parameters.world_scale[0];
+        const float v = y / parameters.world_scale[1];
+        const float threshold = work_group.thresholds[k];
+
+        // consecutive density maps that share an image share its sample.
+        const KernelImage *sampled_image = nullptr;
+        float sample = 0.0f;
+
+        // the first class whose accumulated density exceeds the threshold takes the candidate.
+        float density = 0.0f;
+        for (std::uint32_t class_index = 0; class_index < parameters.class_count; class_index++)
+        {
+            const KernelDensityMap &map = parameters.density_maps[class_index];
+            if (!sampled_image || !isSameImage(*sampled_image, map.image))
+            {
+                sample = sampleKernelImage(map.image, u, v);
+                sampled_image = &map.image;
+            }
+
+            density += std::min(std::max(sample * map.scale + map.offset, map.min_value), map.max_value);
+
+            if (density > threshold)
+            {
+                output.class_indices[k] = class_index;
+                output.heights[k] = sampleKernelImage(parameters.heightmap, u, v) * parameters.world_scale[2];
+                break;
+            }
+        }
+    }
+}
+
+} // placement::cpu
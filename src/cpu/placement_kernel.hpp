@@ -0,0 +1,109 @@
+#ifndef PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_HPP
+#define PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_HPP
+
+#include <cstdint>
+
+/*
+ * Interface between the CPU pipeline and its placement kernels. The SIMD kernels are compiled in translation units of
+ * their own, with the flags of their instruction set, so this header only declares plain structures and functions:
+ * an inline function or template shared with those translation units could be compiled with instructions the
+ * processor does not support, and picked by the linker for the other ones.
+ */
+
+namespace placement::cpu {
+
+class Image;
+
+/// Raw view of an Image.
+struct KernelImage
+{
+    const float *values;
+    std::int32_t width;
+    std::int32_t height;
+    bool linear;
+    bool repeat;
+};
+
+struct KernelDensityMap
+{
+    KernelImage image;
+    float scale;
+    float offset;
+    float min_value;
+    float max_value;
+};
+
+/// Parameters shared by all the work groups of a placement operation.
+struct KernelParameters
+{
+    float footprint;
+    float lower_bound[2];
+    float upper_bound[2];
+    float world_scale[3];
+    KernelImage heightmap;
+    const KernelDensityMap *density_maps;
+    std::uint32_t class_count;
+};
+
+/// A work group of the candidate grid.
+struct KernelWorkGroup
+{
+    /// Coordinates of the candidates in the pattern tile of the work group, in footprint units.
+    const float *pattern_x;
+    const float *pattern_y;
+    /// Threshold of each candidate.
+    const float *thresholds;
+    /// Grid index of the work group times the work group scale.
+    float offset_x;
+    float offset_y;
+    /// Number of candidates, a multiple of max_kernel_width.
+    std::uint32_t candidate_count;
+};
+
+/// Placement of each candidate of a work group. Heights are only meaningful for accepted candidates.
+struct KernelOutput
+{
+    std::uint32_t *class_indices;
+    float *x;
+    float *y;
+    float *heights;
+};
+
+/// Class index of the candidates that are out of bounds or rejected.
+constexpr std::uint32_t invalid_class_index = 0xFFFFFFFFu;
+
+/// Largest number of candidates processed per iteration, which divides the candidate count of every pattern size.
+constexpr std::uint32_t max_kernel_width = 8;
+
+/**
+ * Evaluate the candidates of a work group, as the GPU kernels do. All the kernels place the same elements, at the same
+ * positions and heights: SIMD kernels use the same single precision operations as the scalar one, lane by lane.
+ */
+using PlacementKernel = void (*)(const KernelParameters &parameters, const KernelWorkGroup &work_group,
+                                 const KernelOutput &output);
+
+/// Reference kernel, one candidate at a time.
+void placeWorkGroupScalar(const KernelParameters &parameters, const KernelWorkGroup &work_group,
+                          const KernelOutput &output);
+
+/// Four candidates at a time, or nullptr if the library was built without SSE4.1 support.
+[[nodiscard]] PlacementKernel getSSE41PlacementKernel();
+
+/// Eight candidates at a time, or nullptr if the library was built without AVX2 support.
+[[nodiscard]] PlacementKernel getAVX2PlacementKernel();
+
+/// Whether the processor and the operating system support the instruction sets, as reported by CPUID.
+[[nodiscard]] bool isSSE41Supported();
+[[nodiscard]] bool isAVX2Supported();
+
+[[nodiscard]] KernelImage makeKernelImage(const Image &image);
+
+/// Same as Image::fetch().
+[[nodiscard]] float fetchKernelImage(const KernelImage &image, std::int32_t x, std::int32_t y);
+
+/// Same as Image::sample().
+[[nodiscard]] float sampleKernelImage(const KernelImage &image, float u, float v);
+
+} // placement::cpu
+
+#endif //PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_HPP
@@ -0,0 +1,72 @@
+#include "placement_kernel.hpp"
+
+#ifdef __AVX2__
+
+#include "placement_kernel_simd.hpp"
+
+#include <immintrin.h>
+
+namespace placement::cpu {
+
+namespace {
+
+struct AVX2
+{
+    using Float = __m256;
+    using Int = __m256i;
+
+    static constexpr std::uint32_t width = 8;
+
+    static Float set1(float value) { return _mm256_set1_ps(value); }
+    static Int set1(std::int32_t value) { return _mm256_set1_epi32(value); }
+    static Float load(const float *values) { return _mm256_loadu_ps(values); }
+    static void store(float *values, Float v) { _mm256_storeu_ps(values, v); }
+
+    static Float add(Float l, Float r) { return _mm256_add_ps(l, r); }
+    static Float sub(Float l, Float r) { return _mm256_sub_ps(l, r); }
+    static Float mul(Float l, Float r) { return _mm256_mul_ps(l, r); }
+    static Float div(Float l, Float r) { return _mm256_div_ps(l, r); }
+    static Float min(Float l, Float r) { return _mm256_min_ps(l, r); }
+    static Float max(Float l, Float r) { return _mm256_max_ps(l, r); }
+    static Float floor(Float v) { return _mm256_floor_ps(v); }
+    static Float bitAnd(Float l, Float r) { return _mm256_and_ps(l, r); }
+    static Float less(Float l, Float r) { return _mm256_cmp_ps(l, r, _CMP_LT_OQ); }
+    static Float greater(Float l, Float r) { return _mm256_cmp_ps(l, r, _CMP_GT_OQ); }
+    static Float greaterEqual(Float l, Float r) { return _mm256_cmp_ps(l, r, _CMP_GE_OQ); }
+    static int mask(Float v) { return _mm256_movemask_ps(v); }
+
+    static Int add(Int l, Int r) { return _mm256_add_epi32(l, r); }
+    static Int sub(Int l, Int r) { return _mm256_sub_epi32(l, r); }
+    static Int mul(Int l, Int r) { return _mm256_mullo_epi32(l, r); }
+    static Int min(Int l, Int r) { return _mm256_min_epi32(l, r); }
+    static Int max(Int l, Int r) { return _mm256_max_epi32(l, r); }
+    static Int bitAnd(Int l, Int r) { return _mm256_and_si256(l, r); }
+    static Int greater(Int l, Int r) { return _mm256_cmpgt_epi32(l, r); }
+
+    static Int toInt(Float v) { return _mm256_cvttps_epi32(v); }
+    static Float toFloat(Int v) { return _mm256_cvtepi32_ps(v); }
+
+    static Float gather(const float *values, Int indices) { return _mm256_i32gather_ps(values, indices, 4); }
+};
+
+} // namespace
+
+PlacementKernel getAVX2PlacementKernel()
+{
+    return &SIMDPlacementKernel<AVX2>::place;
+}
+
+} // placement::cpu
+
+#else
+
+namespace placement::cpu {
+
+PlacementKernel getAVX2PlacementKernel()
+{
+    return nullptr;
+}
+
+} // placement::cpu
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_SIMD_HPP
+#define PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_SIMD_HPP
+
+#include "placement_kernel.hpp"
+
+/*
+ * Placement kernel written once for every SIMD instruction set, over a set of vector operations V. Only included by
+ * the translation unit of each instruction set, which is compiled with its flags. Everything is in an anonymous
+ * namespace, so the instantiations of different instruction sets cannot be merged by the linker.
+ */
+
+namespace placement::cpu {
+
+namespace {
+
+template<typename V>
+struct SIMDPlacementKernel
+{
+    using Float = typename V::Float;
+    using Int = typename V::Int;
+
+    static constexpr std::uint32_t width = V::width;
+
+    static_assert(max_kernel_width % width == 0);
+
+    /// Same as the wrap modes of fetchKernelImage().
+    static Int wrap(Int texel, std::int32_t size, bool repeat)
+    {
+        const Int last = V::set1(size - 1);
+
+        if (!repeat)
+            return V::min(V::max(texel, V::set1(0)), last);
+
+        // the quotient of the float division may be one off, which the remainder is corrected for.
+        const Int size_vector = V::set1(size);
+        const Int quotient = V::toInt(V::floor(V::div(V::toFloat(texel), V::set1(static_cast<float>(size)))));
+        Int remainder = V::sub(texel, V::mul(quotient, size_vector));
+        remainder = V::add(remainder, V::bitAnd(V::greater(V::set1(0), remainder), size_vector));
+        remainder = V::sub(remainder, V::bitAnd(V::greater(remainder, last), size_vector));
+        return remainder;
+    }
+
+    static Float fetch(const KernelImage &image, Int x, Int y)
+    {
+        x = wrap(x, image.width, image.repeat);
+        y = wrap(y, image.height, image.repeat);
+        return V::gather(image.values, V::add(V::mul(y, V::set1(image.width)), x));
+    }
+
+    /// Same as sampleKernelImage(), lane by lane.
+    static Float sample(const KernelImage &image, Float u, Float v)
+    {
+        const Float image_width = V::set1(static_cast<float>(image.width));
+        const Float image_height = V::set1(static_cast<float>(image.height));
+
+        if (!image.linear)
+            return fetch(image, V::toInt(V::floor(V::mul(u, image_width))),
+                         V::toInt(V::floor(V::mul(v, image_height))));
+
+        const Float one = V::set1(1.0f);
+        const Float x = V::sub(V::mul(u, image_width), V::set1(0.5f));
+        const Float y = V::sub(V::mul(v, image_height), V::set1(0.5f));
+        const Float lower_x = V::floor(x);
+        const Float lower_y = V::floor(y);
+        const Float weight_x = V::sub(x, lower_x);
+        const Float weight_y = V::sub(y, lower_y);
+        const Float complement_x = V::sub(one, weight_x);
+        const Float complement_y = V::sub(one, weight_y);
+        const Int i = V::toInt(lower_x);
+        const Int j = V::toInt(lower_y);
+        const Int i1 = V::add(i, V::set1(1));
+        const Int j1 = V::add(j, V::set1(1));
+
+        Float value = V::mul(V::mul(complement_x, complement_y), fetch(image, i, j));
+        value = V::add(value, V::mul(V::mul(weight_x, complement_y), fetch(image, i1, j)));
+        value = V::add(value, V::mul(V::mul(complement_x, weight_y), fetch(image, i, j1)));
+        value = V::add(value, V::mul(V::mul(weight_x, weight_y), fetch(image, i1, j1)));
+        return value;
+    }
+
+    /// Same as placeWorkGroupScalar(), width candidates at a time.
+    static void place(const KernelParameters &parameters, const KernelWorkGroup &work_group,
+                      const KernelOutput &output)
+    {
+        const Float footprint = V::set1(parameters.footprint);
+        const Float offset_x = V::set1(work_group.offset_x);
+        const Float offset_y = V::set1(work_group.offset_y);
+        const Float lower_x = V::set1(parameters.lower_bound[0]);
+        const Float lower_y = V::set1(parameters.lower_bound[1]);
+        const Float upper_x = V::set1(parameters.upper_bound[0]);
+        const Float upper_y = V::set1(parameters.upper_bound[1]);
+        const Float world_scale_x = V::set1(parameters.world_scale[0]);
+        const Float world_scale_y = V::set1(parameters.world_scale[1]);
+        const Float world_scale_z = V::set1(parameters.world_scale[2]);
+
+        for (std::uint32_t k = 0; k < work_group.candidate_count; k += width)
+        {
+            const Float x = V::mul(footprint, V::add(V::load(work_group.pattern_x + k), offset_x));
+            const Float y = V::mul(footprint, V::add(V::load(work_group.pattern_y + k), offset_y));
+
+            V::store(output.x + k, x);
+            V::store(output.y + k, y);
+            for (std::uint32_t lane = 0; lane < width; lane++)
+                output.class_indices[k + lane] = invalid_class_index;
+
+            const Float in_bounds = V::bitAnd(V::bitAnd(V::greaterEqual(x, lower_x), V::greaterEqual(y, lower_y)),
+                                              V::bitAnd(V::less(x, upper_x), V::less(y, upper_y)));
+
+            // one bit per lane whose candidate has no class yet.
+            int undecided = V::mask(in_bounds);
+            if (undecided == 0)
+                continue;
+
+            const Float u = V::div(x, world_scale_x);
+            const Float v = V::div(y, world_scale_y);
+            const Float threshold = V::load(work_group.thresholds + k);
+
+            const KernelImage *sampled_image = nullptr;
+            Float map_sample = V::set1(0.0f);
+
+            Float density = V::set1(0.0f);
+            for (std::uint32_t class_index = 0; class_index < parameters.class_count && undecided != 0; class_index++)
+            {
+                const KernelDensityMap &map = parameters.density_maps[class_index];
+                if (!sampled_image || sampled_image->values != map.image.values
+                    || sampled_image->linear != map.image.linear || sampled_image->repeat != map.image.repeat)
+                {
+                    map_sample = sample(map.image, u, v);
+                    sampled_image = &map.image;
+                }
+
+                const Float value = V::add(V::mul(map_sample, V::set1(map.scale)), V::set1(map.offset));
+                density = V::add(density, V::min(V::max(value, V::set1(map.min_value)), V::set1(map.max_value)));
+
+                const int accepted = V::mask(V::greater(density, threshold)) & undecided;
+                for (std::uint32_t lane = 0; lane < width; lane++)
+                    if (accepted & (1 << lane))
+                        output.class_indices[k + lane] = class_index;
+
+                undecided &= ~accepted;
+            }
+
+            // heights of the whole batch, unless all of its candidates were rejected.
+            if (undecided != V::mask(in_bounds))
+                V::store(output.heights + k, V::mul(sample(parameters.heightmap, u, v), world_scale_z));
+        }
+    }
+};
+
+} // namespace
+
+} // placement::cpu
+
+#endif //PROCEDURALPLACEMENTLIB_CPU_PLACEMENT_KERNEL_SIMD_HPP
@@ -0,0 +1,83 @@
+#include "placement_kernel.hpp"
+
+// MSVC has no flag, nor macro, for SSE4.1 alone, and its intrinsics are always available on x86.
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define PLACEMENT_KERNEL_SSE41
+#endif
+
+#ifdef PLACEMENT_KERNEL_SSE41
+
+#include "placement_kernel_simd.hpp"
+
+#include <smmintrin.h>
+
+namespace placement::cpu {
+
+namespace {
+
+struct SSE41
+{
+    using Float = __m128;
+    using Int = __m128i;
+
+    static constexpr std::uint32_t width = 4;
+
+    static Float set1(float value) { return _mm_set1_ps(value); }
+    static Int set1(std::int32_t value) { return _mm_set1_epi32(value); }
+    static Float load(const float *values) { return _mm_loadu_ps(values); }
+    static void store(float *values, Float v) { _mm_storeu_ps(values, v); }
+
+    static Float add(Float l, Float r) { return _mm_add_ps(l, r); }
+    static Float sub(Float l, Float r) { return _mm_sub_ps(l, r); }
+    static Float mul(Float l, Float r) { return _mm_mul_ps(l, r); }
+    static Float div(Float l, Float r) { return _mm_div_ps(l, r); }
+    static Float min(Float l, Float r) { return _mm_min_ps(l, r); }
+    static Float max(Float l, Float r) { return _mm_max_ps(l, r); }
+    static Float floor(Float v) { return _mm_floor_ps(v); }
+    static Float bitAnd(Float l, Float r) { return _mm_and_ps(l, r); }
+    static Float less(Float l, Float r) { return _mm_cmplt_ps(l, r); }
+    static Float greater(Float l, Float r) { return _mm_cmpgt_ps(l, r); }
+    static Float greaterEqual(Float l, Float r) { return _mm_cmpge_ps(l, r); }
+    static int mask(Float v) { return _mm_movemask_ps(v); }
+
+    static Int add(Int l, Int r) { return _mm_add_epi32(l, r); }
+    static Int sub(Int l, Int r) { return _mm_sub_epi32(l, r); }
+    static Int mul(Int l, Int r) { return _mm_mullo_epi32(l, r); }
+    static Int min(Int l, Int r) { return _mm_min_epi32(l, r); }
+    static Int max(Int l, Int r) { return _mm_max_epi32(l, r); }
+    static Int bitAnd(Int l, Int r) { return _mm_and_si128(l, r); }
+    static Int greater(Int l, Int r) { return _mm_cmpgt_epi32(l, r); }
+
+    static Int toInt(Float v) { return _mm_cvttps_epi32(v); }
+    static Float toFloat(Int v) { return _mm_cvtepi32_ps(v); }
+
+    /// SSE has no gather instruction.
+    static Float gather(const float *values, Int indices)
+    {
+        alignas(16) std::int32_t i[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(i), indices);
+        return _mm_setr_ps(values[i[0]], values[i[1]], values[i[2]], values[i[3]]);
+    }
+};
+
+} // namespace
+
+PlacementKernel getSSE41PlacementKernel()
+{
+    return &SIMDPlacementKernel<SSE41>::place;
+}
+
+} // placement::cpu
+
+#else
+
+namespace placement::cpu {
+
+PlacementKernel getSSE41PlacementKernel()
+{
+    return nullptr;
+}
+
+} // placement::cpu
+
+#endif
@@ -0,0 +1,241 @@
+#include "placement/cpu/placement_pipeline.hpp"
+#include "placement/kernel/evaluation_kernel.hpp"
+#include "placement/threshold_texture.hpp"
+#include "placement_kernel.hpp"
+#include "../work_group_pattern.hpp"
+
+#include "glm/glm.hpp"
+
+#include <future>
+#include <stdexcept>
+
+namespace placement::cpu {
+
+struct PlacementPipeline::SeedPattern
+{
+    glm::vec2 work_group_scale;
+    /// Coordinates of the candidates of each pattern tile, one tile after another, stored column by column.
+    std::vector<float> tile_x;
+    std::vector<float> tile_y;
+    uint tile_count;
+    /// Blue noise thresholds, stored row by row, or nothing if the dithering matrix is used.
+    std::vector<float> thresholds;
+    uint threshold_size;
+    /// Stored column by column.
+    std::vector<float> dithering_matrix;
+};
+
+namespace {
+
+PlacementKernel getPlacementKernel(InstructionSet instruction_set)
+{
+    switch (instruction_set)
+    {
+    case InstructionSet::avx2:
+        return getAVX2PlacementKernel();
+    case InstructionSet::sse4_1:
+        return getSSE41PlacementKernel();
+    case InstructionSet::scalar:
+        break;
+    }
+
+    return &placeWorkGroupScalar;
+}
+
+/**
+ * Candidates are visited in the order of the candidate buffer of the GPU pipeline: work groups row by row, and the
+ * candidates of a work group column by column. Every expression that feeds a comparison matches the one of the
+ * kernels, see GenerationKernel and EvaluationKernel.
+ */
+template<typename Pattern>
+Result placeCandidates(const Pattern &pattern, glm::uvec2 pattern_size, PlacementKernel kernel,
+                       const WorldData &world_data, const LayerData &layer_data,
+                       glm::vec2 lower_bound, glm::vec2 upper_bound)
+{
+    using uint = PlacementPipeline::uint;
+
+    const uint class_count = layer_data.densitymaps.size();
+    const uint pattern_candidates = pattern_size.x * pattern_size.y;
+    const glm::vec2 wg_bounds = pattern.work_group_scale * layer_data.footprint;
+
+    // the grid has no work groups at negative coordinates, where the GPU pipeline places nothing either.
+    const glm::uvec2 work_group_begin {glm::max(glm::floor(lower_bound / wg_bounds), 0.0f)};
+    const glm::uvec2 work_group_end {glm::max(glm::ceil(upper_bound / wg_bounds), 0.0f)};
+
+    std::vector<KernelDensityMap> density_maps;
+    for (const DensityMap &map : layer_data.densitymaps)
+        density_maps.push_back({makeKernelImage(*map.image), map.scale, map.offset, map.min_value, map.max_value});
+
+    const KernelParameters parameters {layer_data.footprint, {lower_bound.x, lower_bound.y},
+                                       {upper_bound.x, upper_bound.y},
+                                       {world_data.scale.x, world_data.scale.y, world_data.scale.z},
+                                       makeKernelImage(*world_data.heightmap), density_maps.data(), class_count};
+
+    const auto get_threshold = [&](glm::uvec2 grid_index, glm::uvec2 pattern_index)
+    {
+        if (pattern.threshold_size > 0)
+        {
+            // reduced first, as in the kernels, so that the product cannot wrap around.
+            const glm::uvec2 texel = ((grid_index % pattern.threshold_size) * pattern_size + pattern_index)
+                                     % pattern.threshold_size;
+            return pattern.thresholds[texel.y * pattern.threshold_size + texel.x];
+        }
+
+        const glm::uvec2 threshold_matrix_index = (pattern_index + grid_index) % pattern_size;
+        return pattern.dithering_matrix[threshold_matrix_index.x * pattern_size.y + threshold_matrix_index.y];
+    };
+
+    std::vector<float> thresholds(pattern_candidates);
+    std::vector<uint> class_indices(pattern_candidates);
+    std::vector<float> x(pattern_candidates);
+    std::vector<float> y(pattern_candidates);
+    std::vector<float> heights(pattern_candidates);
+    const KernelOutput output {class_indices.data(), x.data(), y.data(), heights.data()};
+
+    std::vector<std::vector<Result::Element>> class_elements(class_count);
+
+    for (uint grid_y = work_group_begin.y; grid_y < work_group_end.y; grid_y++)
+        for (uint grid_x = work_group_begin.x; grid_x < work_group_end.x; grid_x++)
+        {
+            const glm::uvec2 grid_index {grid_x, grid_y};
+            const std::size_t tile_offset = hashGridIndex(grid_index) % pattern.tile_count * pattern_candidates;
+
+            for (uint i = 0; i < pattern_size.x; i++)
+                for (uint j = 0; j < pattern_size.y; j++)
+                    thresholds[i * pattern_size.y + j] = get_threshold(grid_index, {i, j});
+
+            const glm::vec2 offset = glm::vec2(grid_index) * pattern.work_group_scale;
+            kernel(parameters, {pattern.tile_x.data() + tile_offset, pattern.tile_y.data() + tile_offset,
+                                thresholds.data(), offset.x, offset.y, pattern_candidates}, output);
+
+            for (uint k = 0; k < pattern_candidates; k++)
+                if (class_indices[k] != invalid_class_index)
+                    class_elements[class_indices[k]].push_back({{x[k], y[k], heights[k]}, class_indices[k]});
+        }
+
+    std::vector<uint> index_offsets {0};
+    std::vector<Result::Element> elements;
+    for (auto &class_array : class_elements)
+    {
+        elements.insert(elements.end(), class_array.begin(), class_array.end());
+        index_offsets.push_back(static_cast<uint>(elements.size()));
+    }
+
+    return {std::move(elements), std::move(index_offsets)};
+}
+
+} // namespace
+
+InstructionSet getSupportedInstructionSet()
+{
+    static const InstructionSet instruction_set = []
+    {
+        if (getAVX2PlacementKernel() && isAVX2Supported())
+            return InstructionSet::avx2;
+
+        if (getSSE41PlacementKernel() && isSSE41Supported())
+            return InstructionSet::sse4_1;
+
+        return InstructionSet::scalar;
+    }();
+
+    return instruction_set;
+}
+
+PlacementPipeline::PlacementPipeline(glm::uvec2 pattern_size)
+        : m_pattern_size(pattern_size),
+          m_instruction_set(getSupportedInstructionSet())
+{
+    KernelConfiguration configuration;
+    configuration.pattern_size = pattern_size;
+
+    if (!configuration.isSupported())
+        throw std::logic_error("unsupported pattern size");
+}
+
+PlacementPipeline::~PlacementPipeline() = default;
+
+PlacementPipeline::PlacementPipeline(PlacementPipeline&&) noexcept = default;
+
+PlacementPipeline& PlacementPipeline::operator=(PlacementPipeline&&) noexcept = default;
+
+FutureResult PlacementPipeline::computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                 glm::vec2 lower_bound, glm::vec2 upper_bound)
+{
+    return computePlacement(world_data, layer_data, lower_bound, upper_bound, m_random_seed);
+}
+
+FutureResult PlacementPipeline::computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                 glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed)
+{
+    if (!world_data.heightmap)
+        throw std::logic_error("world data has no heightmap");
+
+    for (const DensityMap &density_map : layer_data.densitymaps)
+        if (!density_map.image)
+            throw std::logic_error("density map has no image");
+
+    // patterns are generated on the calling thread, so that the cache needs no synchronization.
+    std::shared_ptr<const SeedPattern> pattern = m_getPattern(seed);
+
+    return FutureResult(std::async(std::launch::async,
+                                   [=, pattern_size = m_pattern_size, kernel = getPlacementKernel(m_instruction_set),
+                                    pattern = std::move(pattern)]
+    {
+        return placeCandidates(*pattern, pattern_size, kernel, world_data, layer_data, lower_bound, upper_bound);
+    }));
+}
+
+void PlacementPipeline::setBlueNoiseThresholds(uint size)
+{
+    m_blue_noise_size = size;
+    m_seed_patterns.clear();
+}
+
+void PlacementPipeline::setPatternTileCount(uint count)
+{
+    if (count == 0)
+        throw std::logic_error("pattern tile count must be non-zero");
+
+    m_pattern_tile_count = count;
+    m_seed_patterns.clear();
+}
+
+void PlacementPipeline::setInstructionSet(InstructionSet instruction_set)
+{
+    if (instruction_set > getSupportedInstructionSet())
+        throw std::logic_error("unsupported instruction set");
+
+    m_instruction_set = instruction_set;
+}
+
+std::shared_ptr<const PlacementPipeline::SeedPattern> PlacementPipeline::m_getPattern(uint seed)
+{
+    if (const auto iter = m_seed_patterns.find(seed); iter != m_seed_patterns.end())
+        return iter->second;
+
+    if (m_seed_patterns.size() >= max_cached_patterns)
+        m_seed_patterns.clear();
+
+    // the same patterns and thresholds as those the GPU pipeline uploads for the seed.
+    const WorkGroupPattern work_group_pattern = generateWorkGroupPattern(seed, m_pattern_size);
+
+    auto pattern = std::make_shared<SeedPattern>();
+    pattern->work_group_scale = work_group_pattern.scale;
+    // the kernels load the coordinates of consecutive candidates into vectors.
+    for (const glm::vec2 position : generatePatternTiles(work_group_pattern, seed, m_pattern_tile_count))
+    {
+        pattern->tile_x.push_back(position.x);
+        pattern->tile_y.push_back(position.y);
+    }
+    pattern->tile_count = m_pattern_tile_count;
+    if (m_blue_noise_size > 0)
+        pattern->thresholds = generateBlueNoise(m_blue_noise_size, seed);
+    pattern->threshold_size = m_blue_noise_size;
+    pattern->dithering_matrix = EvaluationKernel::makeDitheringMatrix(m_pattern_size);
+
+    m_seed_patterns.emplace(seed, pattern);
+    return pattern;
+}
+
+} // placement::cpu
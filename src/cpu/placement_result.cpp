@@ -0,0 +1,39 @@
+#include "placement/cpu/placement_result.hpp"
+
+#include <stdexcept>
+
+namespace placement::cpu {
+
+Result::Result(std::vector<Element> elements, std::vector<uint> index_offsets)
+        : m_elements(std::move(elements)),
+          m_index_offset(std::move(index_offsets))
+{
+    if (m_index_offset.empty() || m_index_offset.back() != m_elements.size())
+        throw std::logic_error("index offsets do not match the elements");
+}
+
+std::vector<Result::Element> Result::copyClassToHost(uint class_index) const
+{
+    const auto begin = m_elements.begin() + getClassIndexOffset(class_index);
+    const auto end = m_elements.begin() + getClassIndexOffset(class_index + 1);
+
+    return {begin, end};
+}
+
+FutureResult::FutureResult(std::future<Result> &&future) : m_future(std::move(future))
+{
+    if (!m_future.valid())
+        throw std::logic_error("future result has no shared state");
+}
+
+bool FutureResult::wait(std::chrono::nanoseconds timeout) const
+{
+    return m_future.wait_for(timeout) == std::future_status::ready;
+}
+
+Result FutureResult::readResult()
+{
+    return m_future.get();
+}
+
+} // placement::cpu
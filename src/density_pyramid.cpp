@@ -0,0 +1,174 @@
+#include "placement/density_pyramid.hpp"
+#include "gl_context.hpp"
+
+#include "glm/glm.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace placement {
+
+DensityPyramid::DensityPyramid(glm::uvec2 size, const float *values, glm::bvec2 repeat)
+        : m_repeat(repeat)
+{
+    if (size.x == 0 || size.y == 0)
+        throw std::logic_error("density pyramid size must be non-zero");
+
+    Level &base = m_levels.emplace_back(Level{size, {}});
+    base.values.reserve(size.x * size.y);
+    for (uint i = 0; i < size.x * size.y; i++)
+        base.values.emplace_back(values[i], values[i]);
+
+    while (glm::any(glm::greaterThan(m_levels.back().size, glm::uvec2(1))))
+    {
+        const Level &previous = m_levels.back();
+        Level level {(previous.size + 1u) / 2u, {}};
+        level.values.reserve(level.size.x * level.size.y);
+
+        for (uint y = 0; y < level.size.y; y++)
+            for (uint x = 0; x < level.size.x; x++)
+            {
+                // odd sizes are handled by clamping, which covers the last row or column twice.
+                const glm::uvec2 begin {2u * x, 2u * y};
+                const glm::uvec2 end = glm::min(begin + 1u, previous.size - 1u);
+
+                glm::vec2 range = previous.get(begin);
+                for (const glm::uvec2 index : {glm::uvec2(end.x, begin.y), glm::uvec2(begin.x, end.y), end})
+                {
+                    const glm::vec2 value = previous.get(index);
+                    range = {glm::min(range.x, value.x), glm::max(range.y, value.y)};
+                }
+
+                level.values.emplace_back(range);
+            }
+
+        m_levels.emplace_back(std::move(level));
+    }
+}
+
+DensityPyramid DensityPyramid::fromTexture(GLuint texture, DensityMap::Channel channel)
+{
+    GLint width = 0;
+    GLint height = 0;
+    gl.GetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+    gl.GetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+
+    if (width <= 0 || height <= 0)
+        throw std::runtime_error("density map texture has no storage");
+
+    // the pipeline samples density maps with the parameters of their texture, which decide the texels read at the
+    // edges of the world.
+    glm::bvec2 repeat;
+    const GLenum wrap_parameters[] {GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T};
+    for (int i = 0; i < 2; i++)
+    {
+        GLint wrap = 0;
+        gl.GetTextureParameteriv(texture, wrap_parameters[i], &wrap);
+
+        if (wrap != GL_REPEAT && wrap != GL_CLAMP_TO_EDGE)
+            throw std::runtime_error("density map texture wrap mode must be GL_REPEAT or GL_CLAMP_TO_EDGE");
+
+        repeat[i] = wrap == GL_REPEAT;
+    }
+
+    std::vector<float> values(static_cast<std::size_t>(width) * height);
+
+    constexpr GLenum formats[] {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+    const GLenum format = formats[static_cast<GLuint>(channel)];
+
+    gl.PixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl.GetTextureImage(texture, 0, format, GL_FLOAT, static_cast<GLsizei>(values.size() * sizeof(float)),
+                       values.data());
+
+    return {glm::uvec2(width, height), values.data(), repeat};
+}
+
+glm::vec2 DensityPyramid::getRange(glm::vec2 lower_uv, glm::vec2 upper_uv) const
+{
+    const glm::ivec2 size {getSize()};
+
+    // with linear filtering, a sample at uv reads texels floor(uv * size - 0.5) and the one after it.
+    const glm::ivec2 lower_texel = glm::ivec2(glm::floor(lower_uv * glm::vec2(size) - 0.5f));
+    const glm::ivec2 upper_texel = glm::ivec2(glm::floor(upper_uv * glm::vec2(size) - 0.5f)) + 1;
+
+    // the texels read along each axis, as up to two inclusive intervals once wrapped.
+    glm::uvec2 intervals[2][2];
+    uint interval_counts[2] {1, 1};
+    for (int i = 0; i < 2; i++)
+    {
+        if (!m_repeat[i])
+        {
+            intervals[i][0] = glm::ivec2(glm::clamp(lower_texel[i], 0, size[i] - 1),
+                                         glm::clamp(upper_texel[i], 0, size[i] - 1));
+        }
+        else if (upper_texel[i] - lower_texel[i] >= size[i] - 1)
+        {
+            intervals[i][0] = glm::ivec2(0, size[i] - 1);
+        }
+        else
+        {
+            const int begin = (lower_texel[i] % size[i] + size[i]) % size[i];
+            const int end = begin + upper_texel[i] - lower_texel[i];
+
+            if (end < size[i])
+            {
+                intervals[i][0] = glm::ivec2(begin, end);
+            }
+            else
+            {
+                intervals[i][0] = glm::ivec2(begin, size[i] - 1);
+                intervals[i][1] = glm::ivec2(0, end - size[i]);
+                interval_counts[i] = 2;
+            }
+        }
+    }
+
+    glm::vec2 range {std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+    for (uint i = 0; i < interval_counts[0]; i++)
+        for (uint j = 0; j < interval_counts[1]; j++)
+        {
+            const glm::uvec2 x = intervals[0][i];
+            const glm::uvec2 y = intervals[1][j];
+            const glm::vec2 value = m_getTexelRange({x[0], y[0]}, {x[1], y[1]});
+            range = {glm::min(range.x, value.x), glm::max(range.y, value.y)};
+        }
+
+    return range;
+}
+
+glm::vec2 DensityPyramid::getRange(const DensityMap &density_map, glm::vec2 lower_uv, glm::vec2 upper_uv) const
+{
+    const glm::vec2 range = getRange(lower_uv, upper_uv);
+
+    // the transformation is monotonic, although it may be decreasing if the scale is negative.
+    const glm::vec2 transformed = glm::clamp(range * density_map.scale + density_map.offset,
+                                             density_map.min_value, density_map.max_value);
+
+    return {glm::min(transformed.x, transformed.y), glm::max(transformed.x, transformed.y)};
+}
+
+glm::vec2 DensityPyramid::m_getTexelRange(glm::uvec2 begin, glm::uvec2 end) const
+{
+    // go up until the rectangle is covered by at most 2x2 cells.
+    std::size_t level_index = 0;
+    while (glm::any(glm::greaterThan(end - begin, glm::uvec2(1))))
+    {
+        begin /= 2u;
+        end /= 2u;
+        level_index++;
+    }
+
+    const Level &level = m_levels[level_index];
+
+    glm::vec2 range = level.get(begin);
+    for (uint y = begin.y; y <= end.y; y++)
+        for (uint x = begin.x; x <= end.x; x++)
+        {
+            const glm::vec2 value = level.get({x, y});
+            range = {glm::min(range.x, value.x), glm::max(range.y, value.y)};
+        }
+
+    return range;
+}
+
+} // placement
@@ -1,6 +1,7 @@
 #include "disk_distribution_generator.hpp"
 
 #include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
 
 #include <stdexcept>
 #include <array>
@@ -90,13 +91,60 @@ bool DiskDistributionGrid::tryInsert(glm::vec2 position)
     return true;
 }
 
+bool DiskDistributionGenerator::tryInsert(glm::vec2 position)
+{
+    if (!m_grid.tryInsert(position))
+        return false;
+
+    m_active.push_back(m_grid.getPositions().size() - 1);
+    return true;
+}
+
 glm::vec2 DiskDistributionGenerator::generate()
 {
+    const float diameter = m_grid.getDiskDiameter();
+    const glm::vec2 bounds = m_grid.getBounds();
+
+    std::uniform_real_distribution<float> angle_dist {0.0f, 2.0f * glm::pi<float>()};
+    // squared radius, so that samples are uniformly distributed over the area of the annulus.
+    std::uniform_real_distribution<float> radius_dist {1.0f, 4.0f};
+
+    while (!m_active.empty())
+    {
+        const std::size_t active_index = std::uniform_int_distribution<std::size_t>(0, m_active.size() - 1)(m_rand);
+        const glm::vec2 center = m_grid.getPositions()[m_active[active_index]];
+
+        for (std::size_t i = 0; i < m_max_attempts; i++)
+        {
+            const float angle = angle_dist(m_rand);
+            const float radius = diameter * std::sqrt(radius_dist(m_rand));
+
+            // the distribution is periodic, so samples that fall outside of the grid wrap around.
+            glm::vec2 candidate = glm::mod(center + radius * glm::vec2(std::cos(angle), std::sin(angle)), bounds);
+            for (int axis = 0; axis < 2; axis++)
+                if (candidate[axis] >= bounds[axis])
+                    candidate[axis] = 0.0f;
+
+            if (m_grid.tryInsert(candidate))
+            {
+                m_active.push_back(m_grid.getPositions().size() - 1);
+                return candidate;
+            }
+        }
+
+        // there is no room left around this point.
+        m_active[active_index] = m_active.back();
+        m_active.pop_back();
+    }
+
     for (std::size_t i = 0; i < m_max_attempts; i++)
     {
         const glm::vec2 candidate {m_dist_x(m_rand), m_dist_y(m_rand)};
         if (m_grid.tryInsert(candidate))
+        {
+            m_active.push_back(m_grid.getPositions().size() - 1);
             return candidate;
+        }
     }
 
     throw std::runtime_error("maximum insertion attempts exceeded");
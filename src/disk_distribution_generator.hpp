@@ -41,6 +41,8 @@ public:
     /// dimensions of the square region covered by the grid
     [[nodiscard]] glm::vec2 getBounds() const {return glm::vec2(m_grid_size) * m_disk_diameter / std::sqrt(2.0f);}
 
+    [[nodiscard]] float getDiskDiameter() const {return m_disk_diameter;}
+
 private:
     static constexpr std::size_t invalid_index = std::numeric_limits<std::size_t>::max();
 
@@ -53,6 +55,13 @@ private:
     [[nodiscard]] const std::size_t& m_gridCell(glm::uvec2 index) const;
 };
 
+/**
+ * @brief Generates periodic Poisson disk distributions with Bridson's algorithm.
+ * New points are sampled in the annulus between one and two diameters around a random active point, and a point stops
+ * being active once no sample around it can be inserted. This produces a maximal distribution in time proportional to
+ * the number of points, whereas throwing darts over the whole grid slows down as it fills up. Dart throwing is only
+ * used for the first point.
+ */
 class DiskDistributionGenerator
 {
 public:
@@ -67,10 +76,16 @@ public:
         m_dist_y(0.0f, m_grid.getBounds().y)
     {}
 
+    /// Insert a new point into the distribution. Throws std::runtime_error if there is no room left for it.
     glm::vec2 generate();
 
+    /// Insert a point chosen by the caller, if it doesn't collide with the existing ones. New points may be generated
+    /// around it.
+    bool tryInsert(glm::vec2 position);
+
     [[nodiscard]] const std::vector<glm::vec2>& getPositions() const { return m_grid.getPositions(); }
 
+    /// Number of samples tried around an active point before deactivating it.
     void setMaxAttempts(std::size_t n) { m_max_attempts = n; }
     [[nodiscard]] std::size_t getMaxAttempts() const { return m_max_attempts; }
 
@@ -80,6 +95,7 @@ public:
 private:
     DiskDistributionGrid m_grid;
     std::size_t m_max_attempts = 25;
+    std::vector<std::size_t> m_active;
     std::default_random_engine m_rand;
     std::uniform_real_distribution<float> m_dist_x;
     std::uniform_real_distribution<float> m_dist_y;
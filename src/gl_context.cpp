@@ -8,4 +8,19 @@ namespace placement {
         return GL::loadGLContext(loader);
     }
 
+    bool hasExtension(std::string_view name)
+    {
+        GLint extension_count = 0;
+        gl.GetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+        for (GLint i = 0; i < extension_count; i++)
+        {
+            const GLubyte *extension = gl.GetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+            if (extension && name == reinterpret_cast<const char*>(extension))
+                return true;
+        }
+
+        return false;
+    }
+
 } // placement
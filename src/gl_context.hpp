@@ -3,9 +3,14 @@
 
 #include "glutils/gl.hpp"
 
+#include <string_view>
+
 namespace placement
 {
     using GL::gl;
+
+    /// Whether the current context supports the extension @p name.
+    [[nodiscard]] bool hasExtension(std::string_view name);
 }
 
 #endif //PROCEDURALPLACEMENTLIB_GL_CONTEXT_HPP
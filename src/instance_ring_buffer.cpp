@@ -0,0 +1,153 @@
+#include "placement/instance_ring_buffer.hpp"
+
+#include "gl_context.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace placement {
+
+namespace {
+
+/// Modulo operation that returns a positive value for negative dividends.
+GLuint wrap(int value, GLuint size)
+{
+    const int remainder = value % static_cast<int>(size);
+    return remainder < 0 ? remainder + size : remainder;
+}
+
+} // namespace
+
+InstanceRingBuffer::InstanceRingBuffer(glm::uvec2 window_size, GLuint slot_capacity, GLuint num_classes)
+        : m_window_size(window_size),
+          m_slot_capacity(slot_capacity),
+          m_num_classes(num_classes)
+{
+    if (window_size.x == 0 || window_size.y == 0 || slot_capacity == 0 || num_classes == 0)
+        throw std::logic_error("window size, slot capacity and class count must be non-zero");
+
+    const GLuint slot_count = getSlotCount();
+
+    m_slot_cells.resize(slot_count);
+
+    m_commands.resize(slot_count * num_classes, DrawElementsIndirectCommand{0, 0, 0, 0, 0});
+    for (GLuint slot = 0; slot < slot_count; slot++)
+        for (GLuint class_index = 0; class_index < num_classes; class_index++)
+            m_commands[slot * num_classes + class_index].base_instance = slot * slot_capacity;
+
+    m_element_buffer.allocateImmutable(slot_count * static_cast<GLsizeiptr>(slot_capacity) * Element::ssize,
+                                       GL::Buffer::StorageFlags::none);
+
+    m_command_buffer.allocateImmutable(static_cast<GLsizeiptr>(m_commands.size() * sizeof(DrawElementsIndirectCommand)),
+                                       GL::Buffer::StorageFlags::dynamic_storage, m_commands.data());
+}
+
+std::vector<glm::ivec2> InstanceRingBuffer::moveWindow(glm::ivec2 origin)
+{
+    m_origin = origin;
+
+    std::vector<glm::ivec2> new_cells;
+
+    for (GLuint x = 0; x < m_window_size.x; x++)
+        for (GLuint y = 0; y < m_window_size.y; y++)
+        {
+            const glm::ivec2 cell = origin + glm::ivec2(x, y);
+            const GLuint slot_index = getSlotIndex(cell);
+
+            if (m_slot_cells[slot_index] == cell)
+                continue;
+
+            // the previous occupant of the slot wrapped around.
+            m_slot_cells[slot_index].reset();
+            clearSlot(cell);
+            new_cells.emplace_back(cell);
+        }
+
+    return new_cells;
+}
+
+GLuint InstanceRingBuffer::writeSlot(glm::ivec2 cell, const Result &result)
+{
+    m_checkCell(cell);
+
+    if (result.getNumClasses() != m_num_classes)
+        throw std::logic_error("result class count does not match the ring buffer class count");
+
+    const GLuint slot_index = getSlotIndex(cell);
+    const GLuint element_count = std::min(result.getElementArrayLength(), m_slot_capacity);
+
+    // elements are sorted by class, so a single copy keeps all the classes that fit.
+    GL::Buffer::copy(result.getBuffer().gl_object, m_element_buffer, result.getElementArrayBufferOffset(),
+                     getSlotBufferOffset(cell), element_count * Element::ssize);
+
+    for (GLuint class_index = 0; class_index < m_num_classes; class_index++)
+    {
+        const GLuint begin = std::min(result.getClassIndexOffset(class_index), element_count);
+        const GLuint end = std::min(result.getClassIndexOffset(class_index + 1), element_count);
+
+        auto &command = m_commands[slot_index * m_num_classes + class_index];
+        command.instance_count = end - begin;
+        command.base_instance = slot_index * m_slot_capacity + begin;
+    }
+
+    m_uploadSlotCommands(slot_index);
+    m_slot_cells[slot_index] = cell;
+
+    return element_count;
+}
+
+void InstanceRingBuffer::clearSlot(glm::ivec2 cell)
+{
+    m_checkCell(cell);
+
+    const GLuint slot_index = getSlotIndex(cell);
+
+    for (GLuint class_index = 0; class_index < m_num_classes; class_index++)
+        m_commands[slot_index * m_num_classes + class_index].instance_count = 0;
+
+    m_uploadSlotCommands(slot_index);
+}
+
+bool InstanceRingBuffer::contains(glm::ivec2 cell) const
+{
+    const glm::ivec2 window_end = m_origin + glm::ivec2(m_window_size);
+    return glm::all(glm::greaterThanEqual(cell, m_origin)) && glm::all(glm::lessThan(cell, window_end));
+}
+
+bool InstanceRingBuffer::isWritten(glm::ivec2 cell) const
+{
+    return m_slot_cells[getSlotIndex(cell)] == cell;
+}
+
+GLuint InstanceRingBuffer::getSlotIndex(glm::ivec2 cell) const
+{
+    return wrap(cell.y, m_window_size.y) * m_window_size.x + wrap(cell.x, m_window_size.x);
+}
+
+void InstanceRingBuffer::setClassIndexCount(GLuint class_index, GLuint index_count)
+{
+    if (class_index >= m_num_classes)
+        throw std::logic_error("class index out of range");
+
+    for (GLuint slot = 0; slot < getSlotCount(); slot++)
+        m_commands[slot * m_num_classes + class_index].count = index_count;
+
+    m_command_buffer.write({0, static_cast<GLsizeiptr>(m_commands.size() * sizeof(DrawElementsIndirectCommand))},
+                           m_commands.data());
+}
+
+void InstanceRingBuffer::m_checkCell(glm::ivec2 cell) const
+{
+    if (!contains(cell))
+        throw std::logic_error("cell is outside of the window");
+}
+
+void InstanceRingBuffer::m_uploadSlotCommands(GLuint slot_index)
+{
+    constexpr auto command_size = static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand));
+
+    m_command_buffer.write({slot_index * m_num_classes * command_size, m_num_classes * command_size},
+                           m_commands.data() + slot_index * m_num_classes);
+}
+
+} // placement
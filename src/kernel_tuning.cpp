@@ -0,0 +1,330 @@
+#include "placement/kernel_tuning.hpp"
+#include "placement/kernel/generation_kernel.hpp"
+#include "placement/kernel/evaluation_kernel.hpp"
+#include "placement/kernel/indexation_kernel.hpp"
+#include "placement/kernel/copy_kernel.hpp"
+#include "placement/density_map.hpp"
+#include "gl_context.hpp"
+
+#include "glutils/buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace placement {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Shortest of a few runs of a function that issues GL commands, including the time the GL takes to execute them.
+template<typename Function>
+Clock::duration measure(Function &&function)
+{
+    constexpr int runs = 5;
+
+    // the first run may include work deferred by the driver, such as the final compilation of the program.
+    function();
+    gl.Finish();
+
+    auto shortest = Clock::duration::max();
+    for (int i = 0; i < runs; i++)
+    {
+        const auto start = Clock::now();
+        function();
+        gl.Finish();
+        shortest = std::min(shortest, Clock::now() - start);
+    }
+
+    return shortest;
+}
+
+/// The value among @p values for which @p measure_value returns the shortest duration.
+template<typename Range, typename Function>
+auto fastest(const Range &values, Function &&measure_value)
+{
+    auto best_value = *std::begin(values);
+    auto best_duration = Clock::duration::max();
+
+    for (const auto &value : values)
+    {
+        const auto duration = measure_value(value);
+        if (duration < best_duration)
+        {
+            best_value = value;
+            best_duration = duration;
+        }
+    }
+
+    return best_value;
+}
+
+/// Density map for the synthetic region: a gradient from 0 to 1 along x, so that about half the candidates are placed.
+class GradientTexture
+{
+public:
+    GradientTexture()
+    {
+        constexpr GLsizei size = 64;
+
+        std::vector<float> values(size * size);
+        for (GLsizei y = 0; y < size; y++)
+            for (GLsizei x = 0; x < size; x++)
+                values[y * size + x] = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+
+        gl.CreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+        gl.TextureStorage2D(m_texture, 1, GL_R32F, size, size);
+        gl.TextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.TextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        gl.TextureSubImage2D(m_texture, 0, 0, 0, size, size, GL_RED, GL_FLOAT, values.data());
+    }
+
+    ~GradientTexture()
+    {
+        gl.DeleteTextures(1, &m_texture);
+    }
+
+    GradientTexture(const GradientTexture&) = delete;
+    GradientTexture& operator=(const GradientTexture&) = delete;
+
+    [[nodiscard]] GLuint getTexture() const { return m_texture; }
+
+private:
+    GLuint m_texture {0};
+};
+
+} // namespace
+
+KernelConfiguration tuneKernelConfiguration(glm::uvec2 pattern_size)
+{
+    KernelConfiguration configuration;
+    configuration.pattern_size = pattern_size;
+
+    if (!configuration.isSupported())
+        throw std::logic_error("unsupported pattern size");
+
+    // a square grid of 512 x 512 candidates, covering the unit square.
+    constexpr GLuint grid_candidates = 512;
+    const glm::uvec2 num_work_groups = glm::uvec2(grid_candidates) / pattern_size;
+    const GLuint candidate_count = grid_candidates * grid_candidates;
+    const float footprint = 1.0f / static_cast<float>(grid_candidates);
+    const glm::vec2 world_scale {1.0f};
+
+    constexpr GLuint candidate_binding = 0;
+    constexpr GLuint index_binding = 1;
+    constexpr GLuint count_binding = 2;
+    constexpr GLuint element_binding = 3;
+    constexpr GLuint pattern_tile_binding = 4;
+    constexpr GLuint texture_unit = 0;
+
+    constexpr GLsizeiptr candidate_size = GenerationKernel::candidate_size;
+    constexpr GLsizeiptr element_size = sizeof(glm::vec4);
+    constexpr GLsizeiptr uint_size = sizeof(GLuint);
+
+    // separate buffers, so that no range has to be aligned to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+    GL::Buffer candidate_buffer;
+    GL::Buffer index_buffer;
+    GL::Buffer count_buffer;
+    GL::Buffer element_buffer;
+    candidate_buffer.allocateImmutable(candidate_count * candidate_size, GL::Buffer::StorageFlags::none);
+    index_buffer.allocateImmutable(candidate_count * uint_size, GL::Buffer::StorageFlags::none);
+    count_buffer.allocateImmutable(uint_size, GL::Buffer::StorageFlags::none);
+    element_buffer.allocateImmutable(candidate_count * element_size, GL::Buffer::StorageFlags::none);
+
+    using Target = GL::Buffer::IndexedTarget;
+    candidate_buffer.bindRange(Target::shader_storage, candidate_binding, {0, candidate_count * candidate_size});
+    index_buffer.bindRange(Target::shader_storage, index_binding, {0, candidate_count * uint_size});
+    count_buffer.bindRange(Target::shader_storage, count_binding, {0, uint_size});
+    element_buffer.bindRange(Target::shader_storage, element_binding, {0, candidate_count * element_size});
+
+    const GradientTexture density_texture;
+    gl.BindTextureUnit(texture_unit, density_texture.getTexture());
+    const DensityMap density_map {density_texture.getTexture()};
+
+    // a regular pattern, one candidate per footprint.
+    std::vector<glm::vec2> pattern;
+    for (GLuint x = 0; x < pattern_size.x; x++)
+        for (GLuint y = 0; y < pattern_size.y; y++)
+            pattern.emplace_back(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+
+    // as a single pattern tile, which every work group uses.
+    const auto pattern_tile_size = static_cast<GLsizeiptr>(pattern.size() * sizeof(glm::vec2));
+    GL::Buffer pattern_tile_buffer;
+    pattern_tile_buffer.allocateImmutable(pattern_tile_size, GL::Buffer::StorageFlags::none, pattern.data());
+    pattern_tile_buffer.bindRange(Target::shader_storage, pattern_tile_binding, {0, pattern_tile_size});
+
+    // generation and evaluation share their local size.
+    configuration.local_size = fastest(KernelConfiguration::supported_sizes, [&](glm::uvec2 local_size)
+    {
+        KernelConfiguration variant = configuration;
+        variant.local_size = local_size;
+
+        GenerationKernel generation_kernel {variant};
+        generation_kernel.setPatternTiles(pattern_tile_binding, 1);
+        generation_kernel.setWorkGroupPatternBoundaries(glm::vec2(pattern_size));
+
+        EvaluationKernel evaluation_kernel {variant};
+        evaluation_kernel.setPatternTiles(pattern_tile_binding, 1);
+        evaluation_kernel.setWorkGroupPatternBoundaries(glm::vec2(pattern_size));
+
+        return measure([&]
+        {
+            generation_kernel(num_work_groups, {0u, 0u}, footprint, glm::vec2(0.0f), world_scale, candidate_binding);
+            gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            evaluation_kernel(num_work_groups, {0u, 0u}, footprint, 0, glm::vec2(0.0f), world_scale, world_scale,
+                              texture_unit, density_map, candidate_binding);
+            gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        });
+    });
+
+    // the evaluated candidates of the last run are the input of indexation.
+    configuration.indexation_local_size = fastest(KernelConfiguration::supported_linear_sizes, [&](GLuint local_size)
+    {
+        KernelConfiguration variant = configuration;
+        variant.indexation_local_size = local_size;
+
+        IndexationKernel indexation_kernel {variant};
+
+        return measure([&]
+        {
+            gl.ClearNamedBufferData(count_buffer.getName(), GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            indexation_kernel(indexation_kernel.calculateNumWorkGroups(candidate_count), candidate_binding,
+                              count_binding, index_binding);
+            gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        });
+    });
+
+    // the indices and counts of the last run are the input of the copy.
+    configuration.copy_local_size = fastest(KernelConfiguration::supported_linear_sizes, [&](GLuint local_size)
+    {
+        KernelConfiguration variant = configuration;
+        variant.copy_local_size = local_size;
+
+        CopyKernel copy_kernel {variant};
+        copy_kernel.setPatternTiles(pattern_tile_binding, 1);
+        copy_kernel.setWorkGroupPatternBoundaries(glm::vec2(pattern_size));
+
+        return measure([&]
+        {
+            copy_kernel(copy_kernel.calculateNumWorkGroups(candidate_count), {0u, 0u}, num_work_groups.x, footprint,
+                        glm::vec3(world_scale, 1.0f), texture_unit, candidate_binding, count_binding, index_binding,
+                        element_binding);
+            gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        });
+    });
+
+    return configuration;
+}
+
+std::string getKernelTuningKey()
+{
+    const auto get_string = [](GLenum name)
+    {
+        const GLubyte *value = gl.GetString(name);
+        return std::string(value ? reinterpret_cast<const char*>(value) : "");
+    };
+
+    return get_string(GL_RENDERER) + " / " + get_string(GL_VERSION);
+}
+
+namespace {
+
+/**
+ * A line of a tuning cache file: the pattern size, the local sizes and the tuning key, separated by spaces. The key
+ * comes last, as it may contain spaces itself.
+ */
+struct TuningEntry
+{
+    KernelConfiguration configuration;
+    std::string key;
+
+    [[nodiscard]] static std::optional<TuningEntry> parse(const std::string &line)
+    {
+        std::istringstream stream {line};
+        TuningEntry entry;
+        KernelConfiguration &c = entry.configuration;
+
+        if (!(stream >> c.pattern_size.x >> c.pattern_size.y >> c.local_size.x >> c.local_size.y
+                     >> c.indexation_local_size >> c.copy_local_size))
+            return std::nullopt;
+
+        stream >> std::ws;
+        std::getline(stream, entry.key);
+
+        if (entry.key.empty() || !c.isSupported())
+            return std::nullopt;
+
+        return entry;
+    }
+
+    [[nodiscard]] std::string format() const
+    {
+        const KernelConfiguration &c = configuration;
+        std::ostringstream stream;
+        stream << c.pattern_size.x << ' ' << c.pattern_size.y << ' ' << c.local_size.x << ' ' << c.local_size.y << ' '
+               << c.indexation_local_size << ' ' << c.copy_local_size << ' ' << key;
+        return stream.str();
+    }
+};
+
+std::vector<TuningEntry> readTuningEntries(const std::filesystem::path &cache_file)
+{
+    std::vector<TuningEntry> entries;
+
+    std::ifstream file {cache_file};
+    std::string line;
+    while (std::getline(file, line))
+        if (auto entry = TuningEntry::parse(line))
+            entries.emplace_back(std::move(*entry));
+
+    return entries;
+}
+
+} // namespace
+
+std::optional<KernelConfiguration> loadKernelTuning(const std::filesystem::path &cache_file, glm::uvec2 pattern_size)
+{
+    const std::string key = getKernelTuningKey();
+
+    for (const TuningEntry &entry : readTuningEntries(cache_file))
+        if (entry.key == key && entry.configuration.pattern_size == pattern_size)
+            return entry.configuration;
+
+    return std::nullopt;
+}
+
+bool saveKernelTuning(const std::filesystem::path &cache_file, const KernelConfiguration &configuration)
+{
+    const TuningEntry new_entry {configuration, getKernelTuningKey()};
+
+    std::vector<TuningEntry> entries = readTuningEntries(cache_file);
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const TuningEntry &entry)
+    {
+        return entry.key == new_entry.key && entry.configuration.pattern_size == configuration.pattern_size;
+    }), entries.end());
+    entries.push_back(new_entry);
+
+    std::ofstream file {cache_file, std::ios::trunc};
+    for (const TuningEntry &entry : entries)
+        file << entry.format() << '\n';
+
+    return static_cast<bool>(file.flush());
+}
+
+KernelConfiguration getTunedKernelConfiguration(const std::filesystem::path &cache_file, glm::uvec2 pattern_size)
+{
+    if (auto configuration = loadKernelTuning(cache_file, pattern_size))
+        return *configuration;
+
+    const KernelConfiguration configuration = tuneKernelConfiguration(pattern_size);
+    (void) saveKernelTuning(cache_file, configuration);
+    return configuration;
+}
+
+} // placement
@@ -6,26 +6,268 @@
 
 #include "glm/gtc/type_ptr.hpp"
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <system_error>
+
+// GL_KHR_parallel_shader_compile and GL_ARB_parallel_shader_compile share this value.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 namespace placement {
+
+std::filesystem::path ComputeShaderProgram::s_binary_cache_directory;
+
+namespace {
+
+constexpr std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+constexpr std::uint64_t fnv_prime = 1099511628211ull;
+
+/// 64-bit FNV-1a, which unlike std::hash gives the same value in every run and with every standard library.
+std::uint64_t hashBytes(std::uint64_t hash, const char *bytes, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+
+/// Identifies the driver, whose binaries cannot be loaded by other drivers, or other versions of the same one.
+std::string getDriverString()
+{
+    const auto get_string = [](GLenum name)
+    {
+        const GLubyte *value = gl.GetString(name);
+        return std::string(value ? reinterpret_cast<const char*>(value) : "");
+    };
+
+    return get_string(GL_VENDOR) + '\n' + get_string(GL_RENDERER) + '\n' + get_string(GL_VERSION);
+}
+
+/// Whether the context supports GL_KHR_parallel_shader_compile, or the equivalent ARB extension.
+bool hasParallelShaderCompile()
+{
+    return hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+}
+
+template<typename T>
+bool readValue(std::istream &stream, T &value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void writeValue(std::ostream &stream, const T &value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+struct ComputeShaderProgram::PendingLink
+{
+    GL::Shader shader;
+    /// Whether GL_COMPLETION_STATUS_KHR can be queried to know if the program is ready.
+    bool parallel_compile;
+    /// Where to store the binary once linked, if the binary cache is enabled.
+    std::filesystem::path binary_file;
+    std::string driver_string;
+};
+
 ComputeShaderProgram::ComputeShaderProgram(unsigned int count, const char **source_strings)
+        : ComputeShaderProgram(count, source_strings, true)
+{}
+
+ComputeShaderProgram ComputeShaderProgram::compileAsync(const std::string &source_string)
+{
+    const char *c_string = source_string.c_str();
+    return {1, &c_string, false};
+}
+
+ComputeShaderProgram::ComputeShaderProgram(unsigned int count, const char **source_strings, bool wait)
+{
+    if (s_binary_cache_directory.empty())
+    {
+        m_compile(count, source_strings, wait);
+        return;
+    }
+
+    const std::string driver_string = getDriverString();
+
+    std::uint64_t hash = fnv_offset_basis;
+    for (unsigned int i = 0; i < count; i++)
+        hash = hashBytes(hash, source_strings[i], std::strlen(source_strings[i]));
+    hash = hashBytes(hash, driver_string.data(), driver_string.size());
+
+    std::ostringstream file_name;
+    file_name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    const std::filesystem::path file = s_binary_cache_directory / file_name.str();
+
+    if (m_loadBinary(file, driver_string))
+    {
+        m_loaded_from_binary = true;
+        return;
+    }
+
+    // start over with a new program object, in case the driver rejected the binary.
+    m_program = GL::Program();
+    m_compile(count, source_strings, false);
+
+    // the binary can only be retrieved once the program is linked.
+    m_pending->binary_file = file;
+    m_pending->driver_string = driver_string;
+
+    if (wait)
+        waitReady();
+}
+
+ComputeShaderProgram::~ComputeShaderProgram() = default;
+
+ComputeShaderProgram::ComputeShaderProgram(ComputeShaderProgram&&) noexcept = default;
+
+ComputeShaderProgram& ComputeShaderProgram::operator=(ComputeShaderProgram&&) noexcept = default;
+
+void ComputeShaderProgram::setBinaryCacheDirectory(std::filesystem::path directory)
+{
+    s_binary_cache_directory = std::move(directory);
+}
+
+void ComputeShaderProgram::m_compile(unsigned int count, const char **source_strings, bool wait)
 {
     using namespace GL;
 
+    if (!s_binary_cache_directory.empty())
+        gl.ProgramParameteri(m_program.getName(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     Shader shader{ShaderHandle::Type::compute};
     shader.setSource(static_cast<GLsizei>(count), source_strings);
     shader.compile();
-    if (!shader.getParameter(ShaderHandle::Parameter::compile_status))
-        throw GLError(shader.getInfoLog());
 
+    // querying the compile status here would make the driver finish compiling before returning.
     m_program.attachShader(shader);
     m_program.link();
+
+    m_pending = std::make_unique<PendingLink>(PendingLink{std::move(shader), !wait && hasParallelShaderCompile(),
+                                                          {}, {}});
+    if (wait)
+        waitReady();
+}
+
+bool ComputeShaderProgram::isReady() const
+{
+    if (!m_pending || !m_pending->parallel_compile)
+        return true;
+
+    GLint completion_status = GL_FALSE;
+    gl.GetProgramiv(m_program.getName(), GL_COMPLETION_STATUS_KHR, &completion_status);
+    return completion_status == GL_TRUE;
+}
+
+void ComputeShaderProgram::waitReady() const
+{
+    if (!m_pending)
+        return;
+
+    using namespace GL;
+
+    // the pending link is kept on failure, so that every later use of the program throws the same error.
+    if (!m_pending->shader.getParameter(ShaderHandle::Parameter::compile_status))
+        throw GLError(m_pending->shader.getInfoLog());
+
     if (!m_program.getParameter(ProgramHandle::Parameter::link_status))
         throw GLError(m_program.getInfoLog());
-    m_program.detachShader(shader);
+
+    const std::unique_ptr<PendingLink> pending = std::move(m_pending);
+    m_program.detachShader(pending->shader);
+
+    if (!pending->binary_file.empty())
+        m_saveBinary(pending->binary_file, pending->driver_string);
+}
+
+bool ComputeShaderProgram::m_loadBinary(const std::filesystem::path &file, const std::string &driver_string)
+{
+    // a corrupted file should not make us allocate gigabytes.
+    constexpr std::uint32_t max_driver_string_length = 4096;
+
+    std::ifstream stream {file, std::ios::binary};
+
+    std::uint32_t driver_string_length = 0;
+    if (!readValue(stream, driver_string_length) || driver_string_length > max_driver_string_length)
+        return false;
+
+    std::string stored_driver_string(driver_string_length, '\0');
+    if (!stream.read(stored_driver_string.data(), driver_string_length) || stored_driver_string != driver_string)
+        return false;
+
+    GLenum format = 0;
+    GLint length = 0;
+    if (!readValue(stream, format) || !readValue(stream, length) || length <= 0)
+        return false;
+
+    std::vector<char> binary(length);
+    if (!stream.read(binary.data(), length))
+        return false;
+
+    gl.ProgramBinary(m_program.getName(), format, binary.data(), length);
+    return m_program.getParameter(GL::ProgramHandle::Parameter::link_status);
+}
+
+void ComputeShaderProgram::m_saveBinary(const std::filesystem::path &file, const std::string &driver_string) const
+{
+    GLint length = 0;
+    gl.GetProgramiv(m_program.getName(), GL_PROGRAM_BINARY_LENGTH, &length);
+
+    // drivers that support no binary formats report a length of zero.
+    if (length <= 0)
+        return;
+
+    GLenum format = 0;
+    std::vector<char> binary(length);
+    gl.GetProgramBinary(m_program.getName(), length, &length, &format, binary.data());
+
+    // the cache is only an optimization, so failing to write it is not an error.
+    std::error_code error;
+    std::filesystem::create_directories(file.parent_path(), error);
+    if (error)
+        return;
+
+    // write to a temporary file first, so that other processes never read a partially written binary. Its name is
+    // unique, so that processes that save the same program at the same time do not write into each other's file.
+    std::ostringstream suffix;
+    suffix << '.' << std::hex << std::random_device()() << std::random_device()() << ".tmp";
+    std::filesystem::path temporary_file = file;
+    temporary_file += suffix.str();
+    {
+        std::ofstream stream {temporary_file, std::ios::binary | std::ios::trunc};
+        writeValue(stream, static_cast<std::uint32_t>(driver_string.size()));
+        stream.write(driver_string.data(), static_cast<std::streamsize>(driver_string.size()));
+        writeValue(stream, format);
+        writeValue(stream, length);
+        stream.write(binary.data(), length);
+
+        if (!stream.flush())
+        {
+            stream.close();
+            std::filesystem::remove(temporary_file, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temporary_file, file, error);
+    if (error)
+        std::filesystem::remove(temporary_file, error);
 }
 
 void ComputeShaderProgram::useProgram() const
 {
+    waitReady();
     gl.UseProgram(m_program.getName());
 }
 
@@ -37,6 +279,7 @@ void ComputeShaderProgram::dispatch(glm::uvec3 num_work_groups) const
 
 GLuint ComputeShaderProgram::getResourceIndex(Interface interface, const char *name) const
 {
+    waitReady();
     const GLuint value = m_program.getResourceIndex(interface, name);
 
     if (value == GL_INVALID_INDEX)
@@ -47,6 +290,7 @@ GLuint ComputeShaderProgram::getResourceIndex(Interface interface, const char *n
 
 ComputeShaderProgram::UniformLocation ComputeShaderProgram::getUniformLocation(const char *name) const
 {
+    waitReady();
     const UniformLocation value {m_program.getResourceLocation(Interface::uniform, name)};
     if (!value)
         throw GL::GLError(std::string("failed to retrieve uniform location for ") + name);
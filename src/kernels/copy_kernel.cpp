@@ -1,13 +1,32 @@
 #include "placement/kernel/copy_kernel.hpp"
 
 static constexpr auto source_string = R"gl(
-#version 430 core
-
 #define NULL_CLASS_INDEX 0xFFffFFff
+#define CULLED_CLASS_INDEX 0xFFffFFfe
+
+layout(local_size_x = COPY_LOCAL_SIZE) in;
+
+const uint pattern_candidate_count = PATTERN_SIZE_X * PATTERN_SIZE_Y;
+
+layout(std140) uniform Parameters
+{
+    vec3 u_world_scale;
+    float u_footprint;
+    vec2 u_work_group_scale;
+    uvec2 u_work_group_offset;
+    uint u_grid_width;
+    uint u_pattern_tile_count;
+};
 
-layout(local_size_x = 64) in;
+uniform sampler2D u_heightmap;
 
 struct Candidate
+{
+    float density;
+    uint class_index;
+};
+
+struct Element
 {
     vec3 position;
     uint class_index;
@@ -19,6 +38,12 @@ buffer CandidateBuffer
         Candidate array[];
 } b_candidate;
 
+layout(std430) restrict readonly
+buffer PatternTileBuffer
+{
+    vec2[PATTERN_SIZE_X][PATTERN_SIZE_Y] pattern_tiles[];
+};
+
 layout(std430) restrict readonly
 buffer IndexBuffer
 {
@@ -28,7 +53,7 @@ buffer IndexBuffer
 layout(std430) restrict writeonly
 buffer OutputBuffer
 {
-        Candidate array[];
+        Element array[];
 } b_output;
 
 layout(std430) restrict readonly
@@ -37,6 +62,27 @@ buffer CountBuffer
     uint array[];
 } b_count;
 
+uint hashGridIndex(uvec2 grid_index)
+{
+    uint h = grid_index.x * 0x8da6b343u ^ grid_index.y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// same as in the GenerationKernel, bit for bit.
+vec2 generatePosition(uvec2 grid_index, uvec2 pattern_index)
+{
+    const vec2 pattern_position =
+            pattern_tiles[hashGridIndex(grid_index) % u_pattern_tile_count][pattern_index.x][pattern_index.y];
+
+    precise vec2 position = u_footprint * (pattern_position + grid_index * u_work_group_scale);
+    return position;
+}
+
 void main()
 {
     const uint candidate_index = gl_GlobalInvocationID.x;
@@ -44,33 +90,65 @@ void main()
         return;
 
     const Candidate candidate = b_candidate.array[candidate_index];
-    if (candidate.class_index == NULL_CLASS_INDEX)
+    if (candidate.class_index == NULL_CLASS_INDEX || candidate.class_index == CULLED_CLASS_INDEX)
         return;
 
+    // candidates are stored work group by work group, row by row, and column by column within a work group.
+    const uint work_group_index = candidate_index / pattern_candidate_count;
+    const uint pattern_offset = candidate_index % pattern_candidate_count;
+    const uvec2 pattern_index = uvec2(pattern_offset / PATTERN_SIZE_Y, pattern_offset % PATTERN_SIZE_Y);
+    const uvec2 grid_index = u_work_group_offset
+                             + uvec2(work_group_index % u_grid_width, work_group_index / u_grid_width);
+
+    const vec2 position = generatePosition(grid_index, pattern_index);
+    const float height = texture(u_heightmap, position / u_world_scale.xy).x * u_world_scale.z;
+
     const uint copy_index = b_index.array[candidate_index];
 
     uint index_offset = 0;
     for (uint class_index = 0; class_index < candidate.class_index; class_index++)
         index_offset += b_count.array[class_index];
 
-    b_output.array[copy_index + index_offset] = candidate;
+    b_output.array[copy_index + index_offset] = Element(vec3(position, height), candidate.class_index);
 }
 )gl";
 
 namespace placement {
-CopyKernel::CopyKernel() : m_program(source_string),
-                           m_candidate_buffer(m_program.getShaderStorageBlockIndex("CandidateBuffer")),
-                           m_count_buffer(m_program.getShaderStorageBlockIndex("CountBuffer")),
-                           m_index_buffer(m_program.getShaderStorageBlockIndex("IndexBuffer")),
-                           m_output_buffer(m_program.getShaderStorageBlockIndex("OutputBuffer"))
+ComputeShaderProgram CopyKernel::compileAsync(const KernelConfiguration &configuration)
+{
+    return ComputeShaderProgram::compileAsync(configuration.makeSource(source_string, glsl_version));
+}
+
+CopyKernel::CopyKernel(const KernelConfiguration &configuration)
+        : CopyKernel(configuration, compileAsync(configuration))
+{}
+
+CopyKernel::CopyKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program)
+        : m_local_size(configuration.copy_local_size),
+          m_program(std::move(program)),
+          m_parameter_block(m_program.getUniformBlockIndex("Parameters")),
+          m_heightmap_tex(m_program.getUniformLocation("u_heightmap")),
+          m_candidate_buffer(m_program.getShaderStorageBlockIndex("CandidateBuffer")),
+          m_pattern_tile_buffer(m_program.getShaderStorageBlockIndex("PatternTileBuffer")),
+          m_count_buffer(m_program.getShaderStorageBlockIndex("CountBuffer")),
+          m_index_buffer(m_program.getShaderStorageBlockIndex("IndexBuffer")),
+          m_output_buffer(m_program.getShaderStorageBlockIndex("OutputBuffer"))
 {}
 
-void CopyKernel::operator()(uint num_work_groups,
+void CopyKernel::operator()(uint num_work_groups, glm::uvec2 work_group_offset, uint grid_width, float footprint,
+                            glm::vec3 world_scale, GLuint heightmap_texture_unit,
                             GLuint candidate_buffer_binding_index,
                             GLuint count_buffer_binding_index,
                             GLuint index_buffer_binding_index,
                             GLuint output_buffer_binding_index)
 {
+    m_parameters.world_scale = world_scale;
+    m_parameters.footprint = footprint;
+    m_parameters.work_group_offset = work_group_offset;
+    m_parameters.grid_width = grid_width;
+    m_parameter_buffer.bind(m_parameter_block.getBindingIndex(), m_parameters);
+    m_program.setUniform(m_heightmap_tex, static_cast<GLint>(heightmap_texture_unit));
+
     m_program.setShaderStorageBlockBindingIndex(m_candidate_buffer, candidate_buffer_binding_index);
     m_program.setShaderStorageBlockBindingIndex(m_count_buffer, count_buffer_binding_index);
     m_program.setShaderStorageBlockBindingIndex(m_index_buffer, index_buffer_binding_index);
@@ -78,4 +156,19 @@ void CopyKernel::operator()(uint num_work_groups,
 
     m_program.dispatch({num_work_groups, 1, 1});
 }
-} // placement
\ No newline at end of file
+
+void CopyKernel::setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count)
+{
+    if (tile_count == 0)
+        throw std::logic_error("the copy kernel requires at least one pattern tile");
+
+    m_parameters.pattern_tile_count = tile_count;
+    m_program.setShaderStorageBlockBindingIndex(m_pattern_tile_buffer, pattern_tile_buffer_binding_index);
+}
+
+void CopyKernel::setParameterBindingIndex(GLuint binding_index)
+{
+    m_program.setUniformBlockBindingIndex(m_parameter_block, binding_index);
+}
+
+} // placement
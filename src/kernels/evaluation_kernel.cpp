@@ -1,99 +1,207 @@
 #include "placement/kernel/evaluation_kernel.hpp"
 #include "placement/density_map.hpp"
 
+#include <algorithm>
+#include <numeric>
+#include <string>
+
 static constexpr auto source_string = R"gl(
-#version 450 core
+#define INVALID_INDEX 0xFFffFFff
+#define CULLED_INDEX 0xFFffFFfe
+
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
 
-layout(local_size_x = 8, local_size_y = 8) in;
+const uvec2 pattern_size = uvec2(PATTERN_SIZE_X, PATTERN_SIZE_Y);
+
+// parameters of each dispatch, in a range of a uniform buffer of their own.
+layout(std140) uniform Parameters
+{
+    // the density maps of up to MAX_PACKED_CLASSES classes, which share a texture.
+    vec4 u_density_map_params[MAX_PACKED_CLASSES];
+    uvec4 u_class_indices;
+    uvec4 u_density_map_channels;
+    vec2 u_lower_bound;
+    vec2 u_upper_bound;
+    vec2 u_world_scale;
+    uvec2 u_work_group_index_offset;
+    uvec2 u_num_work_groups;
+    uvec2 u_sub_grid_offset;
+    vec2 u_work_group_scale;
+    float u_sample_footprint;
+    uint u_class_count;
+    bool u_reset;
+    uint u_grid_width;
+    uint u_threshold_texture_size;
+    float u_footprint;
+    uint u_pattern_tile_count;
+};
 
 uniform sampler2D u_density_map;
-uniform vec4 u_density_map_params;
-uniform uint u_class_index;
-uniform float u_dithering_matrix [gl_WorkGroupSize.x][gl_WorkGroupSize.y];
-uniform vec2 u_lower_bound;
-uniform vec2 u_upper_bound;
-uniform uvec2 u_work_group_index_offset;
+uniform float u_dithering_matrix [PATTERN_SIZE_X][PATTERN_SIZE_Y];
+uniform sampler2D u_threshold_texture;
 
+// the density accumulated by the previous classes.
 struct Candidate {
-    vec3 position;
+    float density;
     uint class_index;
 };
 
 layout(std430) restrict
 buffer CandidateBuffer
 {
-    Candidate[gl_WorkGroupSize.x][gl_WorkGroupSize.y] candidate_array[];
+    Candidate[PATTERN_SIZE_X][PATTERN_SIZE_Y] candidate_array[];
 };
 
+// the pattern tiles of the GenerationKernel, from which the positions of the candidates are generated again.
 layout(std430) restrict readonly
-buffer WorldUVBuffer
+buffer PatternTileBuffer
 {
-    vec2[gl_WorkGroupSize.x][gl_WorkGroupSize.y] world_uv_array[];
+    vec2[PATTERN_SIZE_X][PATTERN_SIZE_Y] pattern_tiles[];
 };
 
-layout(std430) restrict
-buffer DensityBuffer
+uint hashGridIndex(uvec2 grid_index)
 {
-    float[gl_WorkGroupSize.x][gl_WorkGroupSize.y] density_array[];
-};
+    uint h = grid_index.x * 0x8da6b343u ^ grid_index.y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
 
-float sampleDensityMap(vec2 world_uv)
+// same as in the GenerationKernel, bit for bit.
+vec2 generatePosition(uvec2 grid_index, uvec2 pattern_index)
 {
-    const float scale = u_density_map_params.x;
-    const float offset = u_density_map_params.y;
-    const float min_value = u_density_map_params.z;
-    const float max_value = u_density_map_params.w;
+    const vec2 pattern_position =
+            pattern_tiles[hashGridIndex(grid_index) % u_pattern_tile_count][pattern_index.x][pattern_index.y];
 
-    const float density = texture(u_density_map, world_uv).x;
+    precise vec2 position = u_footprint * (pattern_position + grid_index * u_work_group_scale);
+    return position;
+}
+
+vec4 sampleDensityMapTexel(vec2 world_uv)
+{
+    // mip level at which a texel is about as large as the footprint, so that neighbouring candidates read neighbouring
+    // texels and the density is averaged over the area each of them represents.
+    float lod = 0.0f;
+    if (u_sample_footprint > 0.0f)
+    {
+        const vec2 footprint_texels = u_sample_footprint * vec2(textureSize(u_density_map, 0)) / u_world_scale;
+        lod = clamp(log2(max(footprint_texels.x, footprint_texels.y)), 0.0f,
+                    float(textureQueryLevels(u_density_map) - 1));
+    }
+
+    return textureLod(u_density_map, world_uv, lod);
+}
+
+// density of the i-th evaluated class, from the channel of the texel that holds its density map.
+float getDensity(vec4 texel, uint i)
+{
+    const float scale = u_density_map_params[i].x;
+    const float offset = u_density_map_params[i].y;
+    const float min_value = u_density_map_params[i].z;
+    const float max_value = u_density_map_params[i].w;
 
-    return clamp(density * scale + offset, min_value, max_value);
+    return clamp(texel[u_density_map_channels[i]] * scale + offset, min_value, max_value);
 }
 
 void main()
 {
-    const uint array_index = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    // one invocation per candidate, as in the GenerationKernel.
+    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, u_num_work_groups * pattern_size)))
+        return;
 
-    const vec2 world_uv = world_uv_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y];
+    const uvec2 pattern_index = gl_GlobalInvocationID.xy % pattern_size;
 
-    const uvec2 threshold_matrix_index = (gl_LocalInvocationID.xy + u_work_group_index_offset + gl_WorkGroupID.xy)
-                                            % gl_WorkGroupSize.xy;
-    const float threshold = u_dithering_matrix[threshold_matrix_index.x][threshold_matrix_index.y];
+    // position of the work group within the full grid, which may be larger than the dispatched one.
+    const uvec2 work_group_id = gl_GlobalInvocationID.xy / pattern_size + u_sub_grid_offset;
+    const uint grid_width = u_grid_width == 0u ? u_num_work_groups.x : u_grid_width;
+    const uint array_index = work_group_id.y * grid_width + work_group_id.x;
 
-    const float density = density_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y]
-                        + sampleDensityMap(world_uv);
+    Candidate candidate = candidate_array[array_index][pattern_index.x][pattern_index.y];
 
-    density_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y] = density;
+    // candidates culled by generation lie outside of the placement region, and are never accepted.
+    const bool culled = candidate.class_index == CULLED_INDEX;
 
-    const vec2 position2d = candidate_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y].position.xy;
-    const bool above_lower_bound = all(greaterThanEqual(position2d, u_lower_bound));
-    const bool below_upper_bound = all(lessThan(position2d, u_upper_bound));
+    // when resetting, ignore the state left in the buffer by a previous evaluation of the same candidates.
+    if (u_reset && !culled)
+    {
+        candidate.density = 0.0f;
+        candidate.class_index = INVALID_INDEX;
+        candidate_array[array_index][pattern_index.x][pattern_index.y] = candidate;
+    }
 
-    const uint current_layer_index = candidate_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y].class_index;
+    if (culled)
+        return;
 
-    if (u_class_index < current_layer_index && density > threshold && above_lower_bound && below_upper_bound)
-        candidate_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y].class_index = u_class_index;
+    const uvec2 grid_index = u_work_group_index_offset + work_group_id;
+
+    // generating the position again is cheaper than reading it from a larger candidate buffer.
+    const vec2 position = generatePosition(grid_index, pattern_index);
+    const vec2 world_uv = position / u_world_scale;
+
+    float threshold;
+    if (u_threshold_texture_size > 0u)
+    {
+        // one texel per candidate, tiled over the whole world. The grid index is reduced first, since its product
+        // with the pattern size wraps around at 2^32, which sizes other than powers of two do not divide.
+        const uvec2 texel = ((grid_index % u_threshold_texture_size) * pattern_size + pattern_index)
+                            % u_threshold_texture_size;
+        threshold = texelFetch(u_threshold_texture, ivec2(texel), 0).x;
+    }
+    else
+    {
+        const uvec2 threshold_matrix_index = (pattern_index + grid_index) % pattern_size;
+        threshold = u_dithering_matrix[threshold_matrix_index.x][threshold_matrix_index.y];
+    }
+
+    const bool above_lower_bound = all(greaterThanEqual(position, u_lower_bound));
+    const bool below_upper_bound = all(lessThan(position, u_upper_bound));
+
+    // a single fetch for all the classes, which are evaluated in order, as if dispatched one by one.
+    const vec4 texel = u_class_count > 0u ? sampleDensityMapTexel(world_uv) : vec4(0.0f);
+
+    for (uint i = 0u; i < u_class_count; i++)
+    {
+        const float density = candidate.density + getDensity(texel, i);
+        candidate.density = density;
+
+        const uint class_index = u_class_indices[i];
+        if (class_index < candidate.class_index && density > threshold && above_lower_bound && below_upper_bound)
+            candidate.class_index = class_index;
+    }
+
+    candidate_array[array_index][pattern_index.x][pattern_index.y] = candidate;
 }
 )gl";
 
 namespace placement {
 
-EvaluationKernel::EvaluationKernel()
-        : m_program(source_string),
-          m_class_index(m_program.getUniformLocation("u_class_index")),
-          m_lower_bound(m_program.getUniformLocation("u_lower_bound")),
-          m_upper_bound(m_program.getUniformLocation("u_upper_bound")),
-          m_work_group_index_offset(m_program.getUniformLocation("u_work_group_index_offset")),
+ComputeShaderProgram EvaluationKernel::compileAsync(const KernelConfiguration &configuration)
+{
+    const std::string defines = "#define MAX_PACKED_CLASSES " + std::to_string(max_packed_classes) + "\n";
+    return ComputeShaderProgram::compileAsync(configuration.makeSource((defines + source_string).c_str()));
+}
+
+EvaluationKernel::EvaluationKernel(const KernelConfiguration &configuration)
+        : EvaluationKernel(configuration, compileAsync(configuration))
+{}
+
+EvaluationKernel::EvaluationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program)
+        : m_configuration(configuration),
+          m_program(std::move(program)),
+          m_parameter_block(m_program.getUniformBlockIndex("Parameters")),
           m_dithering_matrix(m_program.getUniformLocation("u_dithering_matrix[0][0]")),
-          m_density_map_params(m_program.getUniformLocation("u_density_map_params")),
+          m_threshold_texture(m_program.getUniformLocation("u_threshold_texture")),
           m_density_map(m_program.getUniformLocation("u_density_map")),
           m_candidate_buffer(m_program.getShaderStorageBlockIndex("CandidateBuffer")),
-          m_world_uv_buffer(m_program.getShaderStorageBlockIndex("WorldUVBuffer")),
-          m_density_buffer(m_program.getShaderStorageBlockIndex("DensityBuffer"))
+          m_pattern_tile_buffer(m_program.getShaderStorageBlockIndex("PatternTileBuffer"))
 {
-    setDitheringMatrixColumns(default_dithering_matrix);
+    setDitheringMatrix(makeDitheringMatrix(configuration.pattern_size));
 }
 
-constexpr auto wg_size = EvaluationKernel::work_group_size;
+constexpr auto wg_size = EvaluationKernel::default_pattern_size;
 
 using Matrix = std::array<std::array<float, wg_size.y>, wg_size.x>;
 
@@ -119,30 +227,140 @@ constexpr Matrix makeDefaultDitheringMatrix()
 
 const Matrix EvaluationKernel::default_dithering_matrix{makeDefaultDitheringMatrix()};
 
+std::vector<float> EvaluationKernel::makeDitheringMatrix(glm::uvec2 size)
+{
+    const uint side = std::max(size.x, size.y);
+
+    if (size.x == 0 || size.y == 0 || (size.x & (size.x - 1)) != 0 || (size.y & (size.y - 1)) != 0)
+        throw std::logic_error("dithering matrix sizes must be powers of two");
+
+    // Bayer matrix, grown recursively from [[0, 2], [3, 1]].
+    std::vector<uint> bayer {0};
+    for (uint n = 1; n < side; n *= 2)
+    {
+        std::vector<uint> next(4 * n * n);
+        for (uint x = 0; x < n; x++)
+            for (uint y = 0; y < n; y++)
+            {
+                const uint value = 4 * bayer[x * n + y];
+                next[x * 2 * n + y] = value;
+                next[x * 2 * n + y + n] = value + 2;
+                next[(x + n) * 2 * n + y] = value + 3;
+                next[(x + n) * 2 * n + y + n] = value + 1;
+            }
+        bayer = std::move(next);
+    }
+
+    std::vector<uint> values;
+    for (uint x = 0; x < size.x; x++)
+        for (uint y = 0; y < size.y; y++)
+            values.push_back(bayer[x * side + y]);
+
+    // rank the values, which are not contiguous when the matrix is not square.
+    std::vector<std::size_t> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t l, std::size_t r) { return values[l] < values[r]; });
+
+    std::vector<float> matrix(values.size());
+    for (std::size_t rank = 0; rank < order.size(); rank++)
+        matrix[order[rank]] = static_cast<float>(rank) / static_cast<float>(matrix.size());
+
+    return matrix;
+}
+
+void EvaluationKernel::m_setDitheringMatrixColumn(uint column_index, const float *column_values)
+{
+    // arrays of arrays take consecutive locations, one per element.
+    const CS::UniformLocation location {m_dithering_matrix.value
+                                        + static_cast<GLint>(column_index * m_configuration.pattern_size.y)};
+    m_program.setUniform(location, static_cast<GLsizei>(m_configuration.pattern_size.y), column_values);
+}
+
+void EvaluationKernel::setSubGrid(glm::uvec2 sub_grid_offset, uint grid_width)
+{
+    m_parameters.sub_grid_offset = sub_grid_offset;
+    m_parameters.grid_width = grid_width;
+}
+
+void EvaluationKernel::setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count)
+{
+    if (tile_count == 0)
+        throw std::logic_error("the evaluation kernel requires at least one pattern tile");
+
+    m_parameters.pattern_tile_count = tile_count;
+    m_program.setShaderStorageBlockBindingIndex(m_pattern_tile_buffer, pattern_tile_buffer_binding_index);
+}
+
+void EvaluationKernel::setThresholdTexture(GLuint texture_unit, uint size)
+{
+    m_program.setUniform(m_threshold_texture, static_cast<GLint>(texture_unit));
+    m_parameters.threshold_texture_size = size;
+}
+
+void EvaluationKernel::setSampleFootprint(float footprint)
+{
+    m_parameters.sample_footprint = footprint;
+}
+
+void EvaluationKernel::setParameterBindingIndex(GLuint binding_index)
+{
+    m_program.setUniformBlockBindingIndex(m_parameter_block, binding_index);
+}
+
 void
-EvaluationKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, uint class_index,
-                             glm::vec2 lower_bound, glm::vec2 upper_bound,
+EvaluationKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, float footprint,
+                             uint class_index, glm::vec2 lower_bound, glm::vec2 upper_bound, glm::vec2 world_scale,
                              GLuint density_map_texture_unit, const DensityMap& density_map,
-                             GLuint candidate_buffer_binding_index,
-                             GLuint world_uv_buffer_binding_index, GLuint density_buffer_binding_index)
+                             GLuint candidate_buffer_binding_index, bool reset)
 {
-    // uniforms
-    m_program.setUniform(m_class_index, class_index);
-    m_program.setUniform(m_lower_bound, lower_bound);
-    m_program.setUniform(m_upper_bound, upper_bound);
-    m_program.setUniform(m_density_map_params, {density_map.scale, density_map.offset,
-                                                density_map.min_value, density_map.max_value});
-    m_program.setUniform(m_work_group_index_offset, work_group_index_offset);
+    (*this)(num_work_groups, work_group_index_offset, footprint, std::vector<uint>{class_index}, lower_bound,
+            upper_bound, world_scale, density_map_texture_unit, std::vector<DensityMap>{density_map},
+            candidate_buffer_binding_index, reset);
+}
+
+void
+EvaluationKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_index_offset, float footprint,
+                             const std::vector<uint> &class_indices, glm::vec2 lower_bound, glm::vec2 upper_bound,
+                             glm::vec2 world_scale, GLuint density_map_texture_unit,
+                             const std::vector<DensityMap> &density_maps, GLuint candidate_buffer_binding_index,
+                             bool reset)
+{
+    if (class_indices.size() != density_maps.size())
+        throw std::logic_error("there must be one density map per evaluated class");
+    if (class_indices.size() > max_packed_classes)
+        throw std::logic_error("too many classes for a single evaluation");
+    if (!density_maps.empty() && std::any_of(density_maps.begin(), density_maps.end(), [&](const DensityMap &map)
+    {
+        return map.texture != density_maps.front().texture;
+    }))
+        throw std::logic_error("the density maps of a single evaluation must share their texture");
+
+    // parameters
+    for (std::size_t i = 0; i < class_indices.size(); i++)
+    {
+        const DensityMap &density_map = density_maps[i];
+        m_parameters.density_map_params[i] = {density_map.scale, density_map.offset,
+                                              density_map.min_value, density_map.max_value};
+        m_parameters.class_indices[i] = class_indices[i];
+        m_parameters.density_map_channels[i] = static_cast<GLuint>(density_map.channel);
+    }
+    m_parameters.class_count = static_cast<GLuint>(class_indices.size());
+    m_parameters.lower_bound = lower_bound;
+    m_parameters.upper_bound = upper_bound;
+    m_parameters.world_scale = world_scale;
+    m_parameters.footprint = footprint;
+    m_parameters.work_group_index_offset = work_group_index_offset;
+    m_parameters.num_work_groups = num_work_groups;
+    m_parameters.reset = reset;
+    m_parameter_buffer.bind(m_parameter_block.getBindingIndex(), m_parameters);
 
     // textures
     m_program.setUniform(m_density_map, static_cast<GLint>(density_map_texture_unit));
 
     // shader storage buffer bindings
     m_program.setShaderStorageBlockBindingIndex(m_candidate_buffer, candidate_buffer_binding_index);
-    m_program.setShaderStorageBlockBindingIndex(m_world_uv_buffer, world_uv_buffer_binding_index);
-    m_program.setShaderStorageBlockBindingIndex(m_density_buffer, density_buffer_binding_index);
 
-    m_program.dispatch({num_work_groups, 1});
+    m_program.dispatch({m_configuration.getDispatchSize(num_work_groups), 1});
 }
 
 } // placement
\ No newline at end of file
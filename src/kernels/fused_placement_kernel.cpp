@@ -0,0 +1,383 @@
+#include "placement/kernel/fused_placement_kernel.hpp"
+#include "placement/kernel/evaluation_kernel.hpp"
+#include "placement/density_map.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+static constexpr auto source_string = R"gl(
+layout(local_size_x = FUSED_LOCAL_SIZE) in;
+
+const uvec2 pattern_size = uvec2(PATTERN_SIZE_X, PATTERN_SIZE_Y);
+const uint pattern_candidate_count = PATTERN_SIZE_X * PATTERN_SIZE_Y;
+
+// parameters of each dispatch, in a range of a uniform buffer of their own.
+layout(std140) uniform Parameters
+{
+    vec4 u_density_map_params[MAX_CLASS_COUNT];
+    vec3 u_world_scale;
+    float u_footprint;
+    vec2 u_work_group_scale;
+    vec2 u_lower_bound;
+    vec2 u_upper_bound;
+    uvec2 u_work_group_offset;
+    uvec2 u_num_work_groups;
+    float u_sample_footprint;
+    uint u_class_count;
+    uint u_active_classes;
+    uint u_pattern_tile_count;
+    uint u_threshold_texture_size;
+    // texture slot of each class, 4 bits per class, and channel of each class, 2 bits per class.
+    uint u_texture_slots;
+    uint u_density_map_channels;
+};
+
+uniform float u_dithering_matrix[PATTERN_SIZE_X][PATTERN_SIZE_Y];
+uniform sampler2D u_threshold_texture;
+uniform sampler2D u_heightmap;
+uniform sampler2D u_density_maps[MAX_CLASS_COUNT];
+
+struct Element
+{
+    vec3 position;
+    uint class_index;
+};
+
+layout(std430) restrict readonly
+buffer PatternTileBuffer
+{
+    vec2[PATTERN_SIZE_X][PATTERN_SIZE_Y] pattern_tiles[];
+};
+
+layout(std430) restrict writeonly
+buffer CountBuffer
+{
+    uint array[];
+} b_count;
+
+layout(std430) restrict writeonly
+buffer ElementBuffer
+{
+    Element array[];
+} b_element;
+
+// class index plus one of each candidate, or zero if it is rejected, packed four candidates per uint.
+shared uint s_candidate_classes[(MAX_CANDIDATE_COUNT + 3) / 4];
+
+// element count of each class, then the index of the next element of each class in the element buffer.
+shared uint s_class_cursors[MAX_CLASS_COUNT];
+
+uint hashGridIndex(uvec2 grid_index)
+{
+    uint h = grid_index.x * 0x8da6b343u ^ grid_index.y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// candidates are numbered as in the candidate buffer of the separate kernels: work group by work group, row by row,
+// and column by column within a work group.
+uvec2 getPatternIndex(uint candidate_index)
+{
+    const uint pattern_index = candidate_index % pattern_candidate_count;
+    return uvec2(pattern_index / PATTERN_SIZE_Y, pattern_index % PATTERN_SIZE_Y);
+}
+
+uvec2 getGridIndex(uint candidate_index)
+{
+    const uint work_group_index = candidate_index / pattern_candidate_count;
+    return u_work_group_offset + uvec2(work_group_index % u_num_work_groups.x, work_group_index / u_num_work_groups.x);
+}
+
+vec2 generatePosition(uvec2 grid_index, uvec2 pattern_index)
+{
+    const vec2 pattern_position =
+            pattern_tiles[hashGridIndex(grid_index) % u_pattern_tile_count][pattern_index.x][pattern_index.y];
+
+    // precise, as in the GenerationKernel.
+    precise vec2 position = u_footprint * (pattern_position + grid_index * u_work_group_scale);
+    return position;
+}
+
+float getThreshold(uvec2 grid_index, uvec2 pattern_index)
+{
+    if (u_threshold_texture_size > 0u)
+    {
+        // reduced first, as grid_index * pattern_size wraps around at 2^32, which sizes other than powers of two
+        // do not divide.
+        const uvec2 texel = ((grid_index % u_threshold_texture_size) * pattern_size + pattern_index)
+                            % u_threshold_texture_size;
+        return texelFetch(u_threshold_texture, ivec2(texel), 0).x;
+    }
+
+    const uvec2 threshold_matrix_index = (pattern_index + grid_index) % pattern_size;
+    return u_dithering_matrix[threshold_matrix_index.x][threshold_matrix_index.y];
+}
+
+uint getTextureSlot(uint class_index)
+{
+    return (u_texture_slots >> (class_index * 4u)) & 0xFu;
+}
+
+vec4 sampleDensityMapTexel(uint slot, vec2 world_uv)
+{
+    float lod = 0.0f;
+    if (u_sample_footprint > 0.0f)
+    {
+        const vec2 footprint_texels = u_sample_footprint * vec2(textureSize(u_density_maps[slot], 0))
+                                      / u_world_scale.xy;
+        lod = clamp(log2(max(footprint_texels.x, footprint_texels.y)), 0.0f,
+                    float(textureQueryLevels(u_density_maps[slot]) - 1));
+    }
+
+    return textureLod(u_density_maps[slot], world_uv, lod);
+}
+
+float getDensity(uint class_index, vec4 texel)
+{
+    const vec4 params = u_density_map_params[class_index];
+    const uint channel = (u_density_map_channels >> (class_index * 2u)) & 0x3u;
+
+    return clamp(texel[channel] * params.x + params.y, params.z, params.w);
+}
+
+void main()
+{
+    const uint candidate_count = u_num_work_groups.x * u_num_work_groups.y * pattern_candidate_count;
+
+    for (uint i = gl_LocalInvocationIndex; i < (candidate_count + 3u) / 4u; i += gl_WorkGroupSize.x)
+        s_candidate_classes[i] = 0u;
+
+    if (gl_LocalInvocationIndex < MAX_CLASS_COUNT)
+        s_class_cursors[gl_LocalInvocationIndex] = 0u;
+
+    barrier();
+    memoryBarrierShared();
+
+    // generation and evaluation. A candidate takes the first class whose accumulated density exceeds its threshold,
+    // so the density maps of the following classes are not sampled.
+    for (uint candidate_index = gl_LocalInvocationIndex; candidate_index < candidate_count;
+         candidate_index += gl_WorkGroupSize.x)
+    {
+        const uvec2 pattern_index = getPatternIndex(candidate_index);
+        const uvec2 grid_index = getGridIndex(candidate_index);
+        const vec2 position = generatePosition(grid_index, pattern_index);
+
+        if (any(lessThan(position, u_lower_bound)) || any(greaterThanEqual(position, u_upper_bound)))
+            continue;
+
+        const float threshold = getThreshold(grid_index, pattern_index);
+        const vec2 world_uv = position / u_world_scale.xy;
+
+        // classes whose density maps share a texture read the same texel, which is fetched once.
+        float density = 0.0f;
+        uint texel_slot = uint(MAX_CLASS_COUNT);
+        vec4 texel = vec4(0.0f);
+        for (uint class_index = 0; class_index < u_class_count; class_index++)
+        {
+            if ((u_active_classes & (1u << class_index)) == 0u)
+                continue;
+
+            const uint slot = getTextureSlot(class_index);
+            if (slot != texel_slot)
+            {
+                texel = sampleDensityMapTexel(slot, world_uv);
+                texel_slot = slot;
+            }
+
+            density += getDensity(class_index, texel);
+            if (density > threshold)
+            {
+                atomicOr(s_candidate_classes[candidate_index / 4u], (class_index + 1u) << (candidate_index % 4u * 8u));
+                atomicAdd(s_class_cursors[class_index], 1u);
+                break;
+            }
+        }
+    }
+
+    barrier();
+    memoryBarrierShared();
+
+    // class offsets, from the element counts.
+    if (gl_LocalInvocationIndex == 0)
+    {
+        uint offset = 0;
+        for (uint class_index = 0; class_index < u_class_count; class_index++)
+        {
+            const uint count = s_class_cursors[class_index];
+            b_count.array[class_index] = count;
+            s_class_cursors[class_index] = offset;
+            offset += count;
+        }
+    }
+
+    barrier();
+    memoryBarrierShared();
+
+    // compaction. Generating a candidate again is cheaper than keeping its position.
+    for (uint candidate_index = gl_LocalInvocationIndex; candidate_index < candidate_count;
+         candidate_index += gl_WorkGroupSize.x)
+    {
+        const uint class_value = (s_candidate_classes[candidate_index / 4u] >> (candidate_index % 4u * 8u)) & 0xFFu;
+        if (class_value == 0u)
+            continue;
+
+        const uint class_index = class_value - 1u;
+        const vec2 position = generatePosition(getGridIndex(candidate_index), getPatternIndex(candidate_index));
+        const float height = texture(u_heightmap, position / u_world_scale.xy).x * u_world_scale.z;
+
+        const uint element_index = atomicAdd(s_class_cursors[class_index], 1u);
+        b_element.array[element_index] = Element(vec3(position, height), class_index);
+    }
+}
+)gl";
+
+namespace placement {
+
+ComputeShaderProgram FusedPlacementKernel::compileAsync(const KernelConfiguration &configuration)
+{
+    const std::string source = "#define FUSED_LOCAL_SIZE " + std::to_string(local_size) + "\n"
+                               "#define MAX_CANDIDATE_COUNT " + std::to_string(max_candidate_count) + "\n"
+                               "#define MAX_CLASS_COUNT " + std::to_string(max_class_count) + "\n"
+                               + source_string;
+
+    return ComputeShaderProgram::compileAsync(configuration.makeSource(source.c_str()));
+}
+
+FusedPlacementKernel::FusedPlacementKernel(const KernelConfiguration &configuration)
+        : FusedPlacementKernel(configuration, compileAsync(configuration))
+{}
+
+FusedPlacementKernel::FusedPlacementKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program)
+        : m_configuration(configuration),
+          m_program(std::move(program)),
+          m_parameter_block(m_program.getUniformBlockIndex("Parameters")),
+          m_dithering_matrix(m_program.getUniformLocation("u_dithering_matrix[0][0]")),
+          m_threshold_texture(m_program.getUniformLocation("u_threshold_texture")),
+          m_heightmap(m_program.getUniformLocation("u_heightmap")),
+          m_density_maps(m_program.getUniformLocation("u_density_maps[0]")),
+          m_pattern_tile_buffer(m_program.getShaderStorageBlockIndex("PatternTileBuffer")),
+          m_count_buffer(m_program.getShaderStorageBlockIndex("CountBuffer")),
+          m_element_buffer(m_program.getShaderStorageBlockIndex("ElementBuffer"))
+{
+    // arrays of arrays take consecutive locations, one per element, but are set one column at a time.
+    const std::vector<float> dithering_matrix = EvaluationKernel::makeDitheringMatrix(configuration.pattern_size);
+    for (uint i = 0; i < configuration.pattern_size.x; i++)
+    {
+        const CS::UniformLocation location {m_dithering_matrix.value
+                                            + static_cast<GLint>(i * configuration.pattern_size.y)};
+        m_program.setUniform(location, static_cast<GLsizei>(configuration.pattern_size.y),
+                             dithering_matrix.data() + i * configuration.pattern_size.y);
+    }
+
+    std::array<GLint, max_class_count> texture_units {};
+    std::iota(texture_units.begin(), texture_units.end(), 0);
+    m_program.setUniform(m_density_maps, static_cast<GLsizei>(texture_units.size()), texture_units.data());
+}
+
+std::vector<GLuint> FusedPlacementKernel::getDensityMapTextures(const std::vector<DensityMap> &density_maps,
+                                                              const std::vector<bool> &active_classes)
+{
+    std::vector<GLuint> textures;
+    for (std::size_t i = 0; i < density_maps.size() && i < active_classes.size(); i++)
+        if (active_classes[i] && std::find(textures.begin(), textures.end(), density_maps[i].texture) == textures.end())
+            textures.push_back(density_maps[i].texture);
+
+    return textures;
+}
+
+void FusedPlacementKernel::setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count)
+{
+    if (tile_count == 0)
+        throw std::logic_error("the fused placement kernel requires at least one pattern tile");
+
+    m_parameters.pattern_tile_count = tile_count;
+    m_program.setShaderStorageBlockBindingIndex(m_pattern_tile_buffer, pattern_tile_buffer_binding_index);
+}
+
+void FusedPlacementKernel::setThresholdTexture(GLuint texture_unit, uint size)
+{
+    m_program.setUniform(m_threshold_texture, static_cast<GLint>(texture_unit));
+    m_parameters.threshold_texture_size = size;
+}
+
+void FusedPlacementKernel::setSampleFootprint(float footprint)
+{
+    m_parameters.sample_footprint = footprint;
+}
+
+void FusedPlacementKernel::setParameterBindingIndex(GLuint binding_index)
+{
+    m_program.setUniformBlockBindingIndex(m_parameter_block, binding_index);
+}
+
+void FusedPlacementKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 work_group_offset, float footprint,
+                                      glm::vec2 lower_bound, glm::vec2 upper_bound, glm::vec3 world_scale,
+                                      GLuint heightmap_texture_unit, GLuint density_map_base_texture_unit,
+                                      const std::vector<DensityMap> &density_maps,
+                                      const std::vector<bool> &active_classes,
+                                      GLuint count_buffer_binding_index, GLuint element_buffer_binding_index)
+{
+    const GLsizeiptr candidate_count = static_cast<GLsizeiptr>(num_work_groups.x) * num_work_groups.y
+                                       * m_configuration.getPatternCandidateCount();
+    if (candidate_count > max_candidate_count)
+        throw std::logic_error("too many candidates for the fused placement kernel");
+
+    if (density_maps.size() > max_class_count || active_classes.size() != density_maps.size())
+        throw std::logic_error("too many classes for the fused placement kernel");
+
+    // parameters
+    m_parameters.world_scale = world_scale;
+    m_parameters.footprint = footprint;
+    m_parameters.lower_bound = lower_bound;
+    m_parameters.upper_bound = upper_bound;
+    m_parameters.work_group_offset = work_group_offset;
+    m_parameters.num_work_groups = num_work_groups;
+    m_parameters.class_count = static_cast<GLuint>(density_maps.size());
+    m_parameters.active_classes = 0;
+    m_parameters.texture_slots = 0;
+    m_parameters.density_map_channels = 0;
+
+    const std::vector<GLuint> textures = getDensityMapTextures(density_maps, active_classes);
+
+    for (std::size_t i = 0; i < density_maps.size(); i++)
+    {
+        const DensityMap &density_map = density_maps[i];
+        m_parameters.density_map_params[i] = {density_map.scale, density_map.offset,
+                                              density_map.min_value, density_map.max_value};
+        m_parameters.density_map_channels |= static_cast<GLuint>(density_map.channel) << (2 * i);
+
+        if (!active_classes[i])
+            continue;
+
+        const auto slot = std::find(textures.begin(), textures.end(), density_map.texture) - textures.begin();
+        m_parameters.active_classes |= 1u << i;
+        m_parameters.texture_slots |= static_cast<GLuint>(slot) << (4 * i);
+    }
+
+    m_parameter_buffer.bind(m_parameter_block.getBindingIndex(), m_parameters);
+
+    // textures
+    m_program.setUniform(m_heightmap, static_cast<GLint>(heightmap_texture_unit));
+
+    if (density_map_base_texture_unit != m_density_map_base_texture_unit)
+    {
+        std::array<GLint, max_class_count> texture_units {};
+        std::iota(texture_units.begin(), texture_units.end(), static_cast<GLint>(density_map_base_texture_unit));
+        m_program.setUniform(m_density_maps, static_cast<GLsizei>(texture_units.size()), texture_units.data());
+        m_density_map_base_texture_unit = density_map_base_texture_unit;
+    }
+
+    // shader storage buffer bindings
+    m_program.setShaderStorageBlockBindingIndex(m_count_buffer, count_buffer_binding_index);
+    m_program.setShaderStorageBlockBindingIndex(m_element_buffer, element_buffer_binding_index);
+
+    m_program.dispatch({1, 1, 1});
+}
+
+} // placement
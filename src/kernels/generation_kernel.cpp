@@ -1,98 +1,146 @@
 #include "placement/kernel/generation_kernel.hpp"
 
-static constexpr auto source_string = R"gl(
-#version 450 core
+#include <stdexcept>
 
+static constexpr auto source_string = R"gl(
 #define INVALID_INDEX 0xFFffFFff
+#define CULLED_INDEX 0xFFffFFfe
 
-layout(local_size_x = 8, local_size_y = 8) in;
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
 
-uniform float u_footprint;
-uniform vec3 u_world_scale;
-uniform vec2 u_work_group_scale;
-uniform uvec2 u_work_group_offset;
-uniform vec2 u_work_group_pattern[gl_WorkGroupSize.x][gl_WorkGroupSize.y];
+const uvec2 pattern_size = uvec2(PATTERN_SIZE_X, PATTERN_SIZE_Y);
 
-uniform sampler2D u_heightmap;
+// parameters of each dispatch, in a range of a uniform buffer of their own.
+layout(std140) uniform Parameters
+{
+    vec2 u_work_group_scale;
+    vec2 u_lower_bound;
+    vec2 u_upper_bound;
+    uvec2 u_work_group_offset;
+    uvec2 u_num_work_groups;
+    uvec2 u_sub_grid_offset;
+    float u_footprint;
+    uint u_grid_width;
+    uint u_pattern_tile_count;
+};
 
+// positions are not stored, as the kernels that follow generate them again from the pattern tiles. Until a class is
+// chosen, the density holds the density accumulated by the evaluated classes.
 struct Candidate
 {
-    vec3 position;
+    float density;
     uint class_index;
 };
 
 layout(std430) restrict writeonly
 buffer CandidateBuffer
 {
-    Candidate[gl_WorkGroupSize.x][gl_WorkGroupSize.y] candidate_array[];
+    Candidate[PATTERN_SIZE_X][PATTERN_SIZE_Y] candidate_array[];
 };
 
-layout(std430) restrict writeonly
-buffer WorldUVBuffer
+// alternative work group patterns, with identical points near their borders so that they can be placed side by side.
+layout(std430) restrict readonly
+buffer PatternTileBuffer
 {
-    vec2[gl_WorkGroupSize.x][gl_WorkGroupSize.y] world_uv_array[];
+    vec2[PATTERN_SIZE_X][PATTERN_SIZE_Y] pattern_tiles[];
 };
 
-layout(std430) restrict writeonly
-buffer DensityBuffer
+uint hashGridIndex(uvec2 grid_index)
 {
-    float[gl_WorkGroupSize.x][gl_WorkGroupSize.y] density_array[];
-};
+    uint h = grid_index.x * 0x8da6b343u ^ grid_index.y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
 
 void main()
 {
-    const uint array_index = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    // one invocation per candidate; compute work groups are not aligned with the work groups of the candidate grid.
+    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, u_num_work_groups * pattern_size)))
+        return;
+
+    const uvec2 pattern_index = gl_GlobalInvocationID.xy % pattern_size;
+
+    // position of the work group within the full grid, which may be larger than the dispatched one.
+    const uvec2 work_group_id = gl_GlobalInvocationID.xy / pattern_size + u_sub_grid_offset;
+    const uint grid_width = u_grid_width == 0u ? u_num_work_groups.x : u_grid_width;
+    const uint array_index = work_group_id.y * grid_width + work_group_id.x;
 
-    const uvec2 grid_index = gl_WorkGroupID.xy + u_work_group_offset;
-    const vec2 h_position = u_footprint * (u_work_group_pattern[gl_LocalInvocationID.x][gl_LocalInvocationID.y]
-                                         + grid_index * u_work_group_scale);
+    const uvec2 grid_index = work_group_id + u_work_group_offset;
+    const vec2 pattern_position =
+            pattern_tiles[hashGridIndex(grid_index) % u_pattern_tile_count][pattern_index.x][pattern_index.y];
 
-    const vec2 world_uv = h_position / u_world_scale.xy;
-    world_uv_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y] = world_uv;
+    // precise, so that the compiler cannot fuse the multiplication and the addition, and positions are bit for bit
+    // those of the CPU pipeline.
+    precise vec2 h_position = u_footprint * (pattern_position + grid_index * u_work_group_scale);
 
-    const float height = texture(u_heightmap, world_uv).x * u_world_scale.z;
-    candidate_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y] = Candidate(vec3(h_position, height),
-                                                                                             INVALID_INDEX);
+    // candidates outside of the placement region are marked with a reserved class index, so that evaluation can skip
+    // them without sampling any density map. The density itself may legitimately become negative.
+    const bool in_bounds = all(greaterThanEqual(h_position, u_lower_bound)) && all(lessThan(h_position, u_upper_bound));
 
-    density_array[array_index][gl_LocalInvocationID.x][gl_LocalInvocationID.y] = 0.0f;
+    candidate_array[array_index][pattern_index.x][pattern_index.y] =
+            Candidate(0.0f, in_bounds ? INVALID_INDEX : CULLED_INDEX);
 }
 )gl";
 
 namespace placement {
 
-GenerationKernel::GenerationKernel()
-        : m_program(source_string),
-          m_footprint(m_program.getUniformLocation("u_footprint")),
-          m_world_scale(m_program.getUniformLocation("u_world_scale")),
-          m_work_group_scale(m_program.getUniformLocation("u_work_group_scale")),
-          m_work_group_offset(m_program.getUniformLocation("u_work_group_offset")),
-          m_work_group_pattern(m_program.getUniformLocation("u_work_group_pattern[0][0]")),
-          m_heightmap_tex(m_program.getUniformLocation("u_heightmap")),
+ComputeShaderProgram GenerationKernel::compileAsync(const KernelConfiguration &configuration)
+{
+    return ComputeShaderProgram::compileAsync(configuration.makeSource(source_string));
+}
+
+GenerationKernel::GenerationKernel(const KernelConfiguration &configuration)
+        : GenerationKernel(configuration, compileAsync(configuration))
+{}
+
+GenerationKernel::GenerationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program)
+        : m_configuration(configuration),
+          m_program(std::move(program)),
+          m_parameter_block(m_program.getUniformBlockIndex("Parameters")),
           m_candidate_buf(m_program.getShaderStorageBlockIndex("CandidateBuffer")),
-          m_world_uv_buf(m_program.getShaderStorageBlockIndex("WorldUVBuffer")),
-          m_density_buf(m_program.getShaderStorageBlockIndex("DensityBuffer"))
+          m_pattern_tile_buf(m_program.getShaderStorageBlockIndex("PatternTileBuffer"))
 {}
 
-void GenerationKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 group_offset, float footprint,
-                                  glm::vec3 world_scale, GLuint heightmap_texture_unit,
-                                  GLuint candidate_buffer_binding_index,
-                                  GLuint world_uv_buffer_binding_index,
-                                  GLuint density_buffer_binding_index)
+void GenerationKernel::setPatternTiles(GLuint pattern_tile_buffer_binding_index, uint tile_count)
 {
-    // uniforms
-    m_program.setUniform(m_work_group_offset, group_offset);
-    m_program.setUniform(m_footprint, footprint);
-    m_program.setUniform(m_world_scale, world_scale);
+    if (tile_count == 0)
+        throw std::logic_error("the generation kernel requires at least one pattern tile");
 
-    // textures
-    m_program.setUniform(m_heightmap_tex, static_cast<GLint>(heightmap_texture_unit));
+    m_parameters.pattern_tile_count = tile_count;
+    m_program.setShaderStorageBlockBindingIndex(m_pattern_tile_buf, pattern_tile_buffer_binding_index);
+}
+
+void GenerationKernel::setSubGrid(glm::uvec2 sub_grid_offset, uint grid_width)
+{
+    m_parameters.sub_grid_offset = sub_grid_offset;
+    m_parameters.grid_width = grid_width;
+}
+
+void GenerationKernel::setParameterBindingIndex(GLuint binding_index)
+{
+    m_program.setUniformBlockBindingIndex(m_parameter_block, binding_index);
+}
+
+void GenerationKernel::operator()(glm::uvec2 num_work_groups, glm::uvec2 group_offset, float footprint,
+                                  glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                  GLuint candidate_buffer_binding_index)
+{
+    // parameters
+    m_parameters.work_group_offset = group_offset;
+    m_parameters.num_work_groups = num_work_groups;
+    m_parameters.footprint = footprint;
+    m_parameters.lower_bound = lower_bound;
+    m_parameters.upper_bound = upper_bound;
+    m_parameter_buffer.bind(m_parameter_block.getBindingIndex(), m_parameters);
 
     // ssbo bindings
     m_program.setShaderStorageBlockBindingIndex(m_candidate_buf, candidate_buffer_binding_index);
-    m_program.setShaderStorageBlockBindingIndex(m_density_buf, density_buffer_binding_index);
-    m_program.setShaderStorageBlockBindingIndex(m_world_uv_buf, world_uv_buffer_binding_index);
 
-    m_program.dispatch({num_work_groups, 1});
+    m_program.dispatch({m_configuration.getDispatchSize(num_work_groups), 1});
 }
 
 } // placement
\ No newline at end of file
@@ -1,15 +1,25 @@
 #include "placement/kernel/indexation_kernel.hpp"
+#include "../gl_context.hpp"
 
-static constexpr auto source_string = R"gl(
-#version 450 core
+#include <string>
 
+#ifndef GL_SUBGROUP_SUPPORTED_STAGES_KHR
+#define GL_SUBGROUP_SUPPORTED_STAGES_KHR 0x9533
+#define GL_SUBGROUP_SUPPORTED_FEATURES_KHR 0x9534
+#define GL_SUBGROUP_FEATURE_BASIC_BIT_KHR 0x00000001
+#define GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR 0x00000004
+#define GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR 0x00000008
+#endif
+
+// buffers and helpers shared by both variants of the kernel.
+static constexpr auto common_source = R"gl(
 #define INVALID_INDEX 0xFFffFFff
 
-layout(local_size_x = 32) in;
+layout(local_size_x = INDEXATION_LOCAL_SIZE) in;
 
 struct Candidate
 {
-    vec3 position;
+    float density;
     uint class_index;
 };
 
@@ -43,7 +53,10 @@ void writeIndex(uint array_index, uint value)
     if (array_index < b_index.array.length())
         b_index.array[array_index] = value;
 }
+)gl";
 
+// scan of the whole work group in shared memory, one class at a time.
+static constexpr auto scan_source = R"gl(
 shared uint s_index_array[2 * gl_WorkGroupSize.x];
 shared uint s_index_offset;
 
@@ -107,9 +120,121 @@ void main()
 }
 )gl";
 
+static constexpr auto subgroup_extensions = R"gl(
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_ballot : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+)gl";
+
+// each subgroup counts its candidates with a ballot, and only the subgroup counts are added up in shared memory.
+static constexpr auto subgroup_source = R"gl(
+// number of candidates of the current class in each subgroup, in the first and the second half of the work group.
+shared uvec2 s_subgroup_count[gl_WorkGroupSize.x];
+
+// two copies of the offsets, so that those of a class can be written while the previous class is still being read.
+shared uvec2 s_subgroup_offset[2][gl_WorkGroupSize.x];
+// offset of the work group in the class, and number of candidates of the class in the first half of the work group.
+shared uvec2 s_index_offset[2];
+
+void main()
+{
+    const uvec2 local_index = {gl_LocalInvocationID.x, gl_LocalInvocationID.x + gl_WorkGroupSize.x};
+    const uvec2 global_index = uvec2(gl_WorkGroupID.x * 2 * gl_WorkGroupSize.x) + local_index;
+    const uvec2 class_index = {readClassIndex(global_index.x), readClassIndex(global_index.y)};
+
+    uvec2 result_value = uvec2(INVALID_INDEX);
+
+    for (uint i = 0; i < b_count.array.length(); i++)
+    {
+        const uint copy = i % 2u;
+        const bvec2 is_class = equal(class_index, uvec2(i));
+        const uvec4 ballot_x = subgroupBallot(is_class.x);
+        const uvec4 ballot_y = subgroupBallot(is_class.y);
+
+        if (subgroupElect())
+            s_subgroup_count[gl_SubgroupID] = uvec2(subgroupBallotBitCount(ballot_x), subgroupBallotBitCount(ballot_y));
+
+        barrier();
+        memoryBarrierShared();
+
+        // prefix sum of the subgroup counts, gl_SubgroupSize subgroups at a time.
+        if (gl_SubgroupID == 0)
+        {
+            uvec2 total = uvec2(0);
+            for (uint base = 0; base < gl_NumSubgroups; base += gl_SubgroupSize)
+            {
+                const uint subgroup = base + gl_SubgroupInvocationID;
+                const uvec2 count = subgroup < gl_NumSubgroups ? s_subgroup_count[subgroup] : uvec2(0);
+                const uvec2 offset = total + subgroupExclusiveAdd(count);
+
+                if (subgroup < gl_NumSubgroups)
+                    s_subgroup_offset[copy][subgroup] = offset;
+
+                total += subgroupAdd(count);
+            }
+
+            if (subgroupElect())
+                s_index_offset[copy] = uvec2(atomicAdd(b_count.array[i], total.x + total.y), total.x);
+        }
+
+        barrier();
+        memoryBarrierShared();
+
+        // as in the scan, the candidates of the first half of the work group come before those of the second half.
+        const uvec2 subgroup_offset = s_subgroup_offset[copy][gl_SubgroupID];
+        const uvec2 index_offset = s_index_offset[copy];
+
+        if (is_class.x)
+            result_value.x = index_offset.x + subgroup_offset.x + subgroupBallotExclusiveBitCount(ballot_x);
+        if (is_class.y)
+            result_value.y = index_offset.x + index_offset.y + subgroup_offset.y
+                             + subgroupBallotExclusiveBitCount(ballot_y);
+    }
+
+    writeIndex(global_index.x, result_value.x);
+    writeIndex(global_index.y, result_value.y);
+}
+)gl";
+
 namespace placement {
-IndexationKernel::IndexationKernel()
-        : m_program(source_string),
+bool IndexationKernel::isSubgroupIndexationSupported()
+{
+    if (!hasExtension("GL_KHR_shader_subgroup"))
+        return false;
+
+    GLint stages = 0;
+    GLint features = 0;
+    gl.GetIntegerv(GL_SUBGROUP_SUPPORTED_STAGES_KHR, &stages);
+    gl.GetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &features);
+
+    constexpr GLint required_features = GL_SUBGROUP_FEATURE_BASIC_BIT_KHR | GL_SUBGROUP_FEATURE_BALLOT_BIT_KHR
+                                        | GL_SUBGROUP_FEATURE_ARITHMETIC_BIT_KHR;
+
+    return (stages & GL_COMPUTE_SHADER_BIT) != 0 && (features & required_features) == required_features;
+}
+
+bool IndexationKernel::s_usesSubgroups(const KernelConfiguration &configuration)
+{
+    return configuration.subgroup_indexation && isSubgroupIndexationSupported();
+}
+
+ComputeShaderProgram IndexationKernel::compileAsync(const KernelConfiguration &configuration)
+{
+    const std::string source = s_usesSubgroups(configuration)
+                               ? std::string(subgroup_extensions) + common_source + subgroup_source
+                               : std::string(common_source) + scan_source;
+
+    return ComputeShaderProgram::compileAsync(configuration.makeSource(source.c_str(), glsl_version));
+}
+
+IndexationKernel::IndexationKernel(const KernelConfiguration &configuration)
+        : IndexationKernel(configuration, compileAsync(configuration))
+{}
+
+IndexationKernel::IndexationKernel(const KernelConfiguration &configuration, ComputeShaderProgram &&program)
+        : m_local_size(configuration.indexation_local_size),
+          m_uses_subgroups(s_usesSubgroups(configuration)),
+          m_program(std::move(program)),
           m_candidate_buffer(m_program.getShaderStorageBlockIndex("CandidateBuffer")),
           m_count_buffer(m_program.getShaderStorageBlockIndex("CountBuffer")),
           m_index_buffer(m_program.getShaderStorageBlockIndex("IndexBuffer"))
@@ -0,0 +1,49 @@
+#include "placement/kernel/kernel_configuration.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+
+namespace placement {
+
+bool KernelConfiguration::isSupported() const
+{
+    const auto is_supported_size = [](glm::uvec2 size)
+    {
+        return std::find(supported_sizes.begin(), supported_sizes.end(), size) != supported_sizes.end();
+    };
+
+    const auto is_supported_linear_size = [](GLuint size)
+    {
+        return std::find(supported_linear_sizes.begin(), supported_linear_sizes.end(), size)
+               != supported_linear_sizes.end();
+    };
+
+    return is_supported_size(pattern_size) && is_supported_size(local_size)
+           && is_supported_linear_size(indexation_local_size) && is_supported_linear_size(copy_local_size);
+}
+
+std::string KernelConfiguration::makeSource(const char *source, GLuint glsl_version) const
+{
+    if (!isSupported())
+        throw std::logic_error("unsupported kernel configuration");
+
+    return "#version " + std::to_string(glsl_version) + " core\n"
+           "#define PATTERN_SIZE_X " + std::to_string(pattern_size.x) + "\n"
+           "#define PATTERN_SIZE_Y " + std::to_string(pattern_size.y) + "\n"
+           "#define LOCAL_SIZE_X " + std::to_string(local_size.x) + "\n"
+           "#define LOCAL_SIZE_Y " + std::to_string(local_size.y) + "\n"
+           "#define INDEXATION_LOCAL_SIZE " + std::to_string(indexation_local_size) + "\n"
+           "#define COPY_LOCAL_SIZE " + std::to_string(copy_local_size) + "\n"
+           + source;
+}
+
+bool KernelConfiguration::operator<(const KernelConfiguration &other) const
+{
+    return std::tie(pattern_size.x, pattern_size.y, local_size.x, local_size.y, indexation_local_size, copy_local_size,
+                    subgroup_indexation)
+           < std::tie(other.pattern_size.x, other.pattern_size.y, other.local_size.x, other.local_size.y,
+                      other.indexation_local_size, other.copy_local_size, other.subgroup_indexation);
+}
+
+} // placement
@@ -0,0 +1,89 @@
+#include "placement/kernel/reprojection_kernel.hpp"
+
+static constexpr auto source_string = R"gl(
+#version 450 core
+
+layout(local_size_x = 64) in;
+
+layout(std140) uniform Parameters
+{
+    vec3 u_world_scale;
+    uint u_element_count;
+    vec2 u_lower_bound;
+    vec2 u_upper_bound;
+};
+
+uniform sampler2D u_heightmap;
+
+struct Element
+{
+    vec3 position;
+    uint class_index;
+};
+
+layout(std430) restrict
+buffer ElementBuffer
+{
+    Element array[];
+} b_element;
+
+void main()
+{
+    const uint element_index = gl_GlobalInvocationID.x;
+    // the element array of the buffer has room for every candidate, past the elements that were placed.
+    if (element_index >= u_element_count)
+        return;
+
+    const vec2 position2d = b_element.array[element_index].position.xy;
+    if (any(lessThan(position2d, u_lower_bound)) || any(greaterThanEqual(position2d, u_upper_bound)))
+        return;
+
+    const vec2 world_uv = position2d / u_world_scale.xy;
+    b_element.array[element_index].position.z = texture(u_heightmap, world_uv).x * u_world_scale.z;
+}
+)gl";
+
+namespace placement {
+
+ComputeShaderProgram ReprojectionKernel::compileAsync()
+{
+    return ComputeShaderProgram::compileAsync(source_string);
+}
+
+ReprojectionKernel::ReprojectionKernel() : ReprojectionKernel(compileAsync())
+{}
+
+ReprojectionKernel::ReprojectionKernel(ComputeShaderProgram &&program)
+        : m_program(std::move(program)),
+          m_parameter_block(m_program.getUniformBlockIndex("Parameters")),
+          m_heightmap_tex(m_program.getUniformLocation("u_heightmap")),
+          m_element_buffer(m_program.getShaderStorageBlockIndex("ElementBuffer"))
+{}
+
+void ReprojectionKernel::operator()(uint element_count, glm::vec3 world_scale, GLuint heightmap_texture_unit,
+                                    glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                    GLuint element_buffer_binding_index)
+{
+    // parameters
+    Parameters parameters;
+    parameters.world_scale = world_scale;
+    parameters.element_count = element_count;
+    parameters.lower_bound = lower_bound;
+    parameters.upper_bound = upper_bound;
+    m_parameter_buffer.bind(m_parameter_block.getBindingIndex(), parameters);
+
+    // textures
+    m_program.setUniform(m_heightmap_tex, static_cast<GLint>(heightmap_texture_unit));
+
+    // ssbo bindings
+    m_program.setShaderStorageBlockBindingIndex(m_element_buffer, element_buffer_binding_index);
+
+    m_program.dispatch({calculateNumWorkGroups(element_count), 1, 1});
+}
+
+void ReprojectionKernel::setParameterBindingIndex(GLuint binding_index)
+{
+    m_program.setUniformBlockBindingIndex(m_parameter_block, binding_index);
+}
+
+} // placement
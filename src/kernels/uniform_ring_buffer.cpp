@@ -0,0 +1,67 @@
+#include "placement/kernel/uniform_ring_buffer.hpp"
+#include "../gl_context.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace placement {
+
+UniformRingBuffer::UniformRingBuffer(GLsizeiptr size) : m_size(size)
+{
+    GLint alignment = 1;
+    gl.GetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_alignment = std::max<GLsizeiptr>(alignment, 1);
+
+    using SFlags = GL::Buffer::StorageFlags;
+    using AFlags = GL::Buffer::AccessFlags;
+
+    m_buffer.allocateImmutable(m_size, SFlags::map_write | SFlags::map_persistent | SFlags::map_coherent);
+    m_mapping = static_cast<std::byte*>(m_buffer.mapRange(0, m_size,
+                                                          AFlags::write | AFlags::persistent | AFlags::coherent));
+}
+
+void UniformRingBuffer::bindData(GLuint binding_index, const void *data, GLsizeiptr size)
+{
+    const GLsizeiptr segment_size = m_size / static_cast<GLsizeiptr>(segment_count);
+    if (size > segment_size)
+        throw std::logic_error("parameter block is larger than a segment of the ring buffer");
+
+    GLintptr offset = (m_offset + m_alignment - 1) / m_alignment * m_alignment;
+    if (offset + size > m_size)
+        offset = 0;
+
+    // a range spans at most two segments.
+    m_enterSegment(static_cast<std::size_t>(offset / segment_size));
+    m_enterSegment(static_cast<std::size_t>((offset + size - 1) / segment_size));
+
+    // the mapping is coherent, so commands issued after the copy see it.
+    std::memcpy(m_mapping + offset, data, static_cast<std::size_t>(size));
+    m_buffer.bindRange(GL::Buffer::IndexedTarget::uniform, binding_index, {offset, size});
+
+    m_offset = offset + size;
+}
+
+void UniformRingBuffer::m_enterSegment(std::size_t segment)
+{
+    if (segment == m_segment)
+        return;
+
+    // the commands issued so far are the last ones that read the segment being left.
+    m_fences[m_segment] = GL::createFenceSync();
+
+    if (auto &fence = m_fences[segment])
+    {
+        GL::Sync::Status status;
+        do
+            status = fence->clientWait(true, std::chrono::milliseconds(100));
+        while (status == GL::Sync::Status::timeout_expired);
+
+        fence.reset();
+    }
+
+    m_segment = segment;
+}
+
+} // placement
@@ -1,24 +1,93 @@
 #include "placement/placement_pipeline.hpp"
 #include "gl_context.hpp"
-#include "disk_distribution_generator.hpp"
+#include "work_group_pattern.hpp"
 
 #include "glutils/guard.hpp"
 #include "glutils/buffer.hpp"
+#include "glutils/error.hpp"
 
 #include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cstring>
 
 namespace placement {
 
 using Candidate = Result::Element;
 
-PlacementPipeline::PlacementPipeline()
+PlacementPipeline::PlacementPipeline() : PlacementPipeline(KernelConfiguration{})
+{}
+
+PlacementPipeline::PlacementPipeline(const std::filesystem::path &tuning_cache_file)
+    : PlacementPipeline(getTunedKernelConfiguration(tuning_cache_file))
+{}
+
+PlacementPipeline::PlacementPipeline(const KernelConfiguration &configuration)
+    : PlacementPipeline(configuration, true)
+{}
+
+PlacementPipeline PlacementPipeline::createAsync(const KernelConfiguration &configuration)
+{
+    return {configuration, false};
+}
+
+std::shared_ptr<PlacementPipeline::KernelVariant>
+PlacementPipeline::s_getKernelVariant(const KernelConfiguration &configuration, KernelPrograms *programs)
 {
+    std::weak_ptr<KernelVariant> &entry = s_kernel_registry[configuration];
+
+    std::shared_ptr<KernelVariant> variant = entry.lock();
+    if (!variant)
+    {
+        variant = programs ? std::make_shared<KernelVariant>(configuration, std::move(*programs))
+                           : std::make_shared<KernelVariant>(configuration);
+        entry = variant;
+    }
+
+    return variant;
+}
+
+std::shared_ptr<ReprojectionKernel> PlacementPipeline::s_getReprojectionKernel(ComputeShaderProgram *program)
+{
+    std::shared_ptr<ReprojectionKernel> kernel = s_reprojection_kernel.lock();
+    if (!kernel)
+    {
+        kernel = program ? std::make_shared<ReprojectionKernel>(std::move(*program))
+                         : std::make_shared<ReprojectionKernel>();
+        s_reprojection_kernel = kernel;
+    }
+
+    return kernel;
+}
+
+PlacementPipeline::PlacementPipeline(const KernelConfiguration &configuration, bool wait)
+{
+    if (!configuration.isSupported())
+        throw std::logic_error("unsupported kernel configuration");
+
+    m_pending_kernels = std::make_unique<PendingKernels>(configuration);
+
     setBaseTextureUnit(0);
     setBaseShaderStorageBindingPoint(0);
-    setRandomSeed(0);
+
+    // the pattern is generated on the CPU while the kernels compile.
+    m_usePattern(m_random_seed);
+
+    GLint max_count_x = 0, max_count_y = 0;
+    gl.GetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &max_count_x);
+    gl.GetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 1, &max_count_y);
+    m_max_work_group_count = {max_count_x, max_count_y};
+
+    GLint64 max_block_size = 0;
+    gl.GetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+    m_max_storage_block_size = max_block_size;
+
+    if (wait)
+        waitReady();
 }
 
-ResultBuffer PlacementPipeline::s_makeResultBuffer(uint candidate_count, uint class_count)
+ResultBuffer PlacementPipeline::s_makeResultBuffer(uint candidate_count, uint class_count, const void *data)
 {
     constexpr GLsizeiptr result_element_size = sizeof(glm::vec4);
     constexpr GLsizeiptr uint_size = sizeof(uint);
@@ -30,7 +99,7 @@ ResultBuffer PlacementPipeline::s_makeResultBuffer(uint candidate_count, uint cl
     using SFlags = GL::Buffer::StorageFlags;
 
     GL::BufferHandle buffer = result_buffer.gl_object;
-    buffer.allocateImmutable(size, SFlags::map_read | SFlags::map_persistent | SFlags::map_coherent, nullptr);
+    buffer.allocateImmutable(size, SFlags::map_read | SFlags::map_persistent | SFlags::map_coherent, data);
 
     using AFlags = GL::Buffer::AccessFlags;
     result_buffer.mapped_ptr = static_cast<const std::byte*>(buffer.mapRange(0, size, AFlags::read | AFlags::coherent | AFlags::persistent));
@@ -38,7 +107,9 @@ ResultBuffer PlacementPipeline::s_makeResultBuffer(uint candidate_count, uint cl
     if (!result_buffer.mapped_ptr)
         throw std::runtime_error("GL memory mapping error!");
 
-    gl.ClearNamedBufferSubData(buffer.getName(), GL_R8, 0, class_count * uint_size, GL_RED,  GL_UNSIGNED_BYTE, nullptr);
+    if (!data)
+        gl.ClearNamedBufferSubData(buffer.getName(), GL_R8, 0, class_count * uint_size, GL_RED,  GL_UNSIGNED_BYTE,
+                                   nullptr);
 
     return result_buffer;
 }
@@ -53,18 +124,18 @@ namespace {
 struct TransientBuffer
 {
 public:
+    // only the accumulated density and the class of each candidate. Positions, and the world uvs derived from them, are
+    // generated again from the pattern tiles by the evaluation and copy kernels.
+    static constexpr GLsizeiptr candidate_size = GenerationKernel::candidate_size;
+    static constexpr GLsizeiptr index_size = sizeof(uint);
+
     explicit TransientBuffer(uint candidate_count)
     {
-        constexpr GLsizeiptr candidate_size = sizeof(float) * 4;
-        m_candidate_range = allocate(candidate_count * candidate_size);
-
-        constexpr GLsizeiptr density_size = sizeof(float);
-        m_density_range = allocate(candidate_count * density_size);
-
-        constexpr GLsizeiptr world_uv_size = sizeof(float) * 2;
-        m_world_uv_range = allocate(candidate_count * world_uv_size);
+        GLint alignment = 1;
+        gl.GetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_alignment = std::max<GLsizeiptr>(alignment, 1);
 
-        constexpr GLsizeiptr index_size = sizeof(uint);
+        m_candidate_range = allocate(candidate_count * candidate_size);
         m_index_range = allocate(candidate_count * index_size);
 
         m_buffer.allocateImmutable(m_size, GL::Buffer::StorageFlags::none);
@@ -74,24 +145,20 @@ public:
 
     [[nodiscard]] GL::Buffer::Range getCandidateRange() const { return m_candidate_range; }
 
-    [[nodiscard]] GL::Buffer::Range getDensityRange() const { return m_density_range; }
-
-    [[nodiscard]] GL::Buffer::Range getWorldUVRange() const { return m_world_uv_range; }
-
     [[nodiscard]] GL::Buffer::Range getIndexRange() const { return m_index_range; }
 
 private:
     GL::Buffer m_buffer;
     GL::Buffer::Range m_candidate_range;
-    GL::Buffer::Range m_density_range;
-    GL::Buffer::Range m_world_uv_range;
     GL::Buffer::Range m_index_range;
     GLsizeiptr m_size {0};
+    GLsizeiptr m_alignment {1};
 
+    /// Ranges are bound on their own, so each of them starts at a multiple of the SSBO offset alignment.
     GL::Buffer::Range allocate(GLsizeiptr alloc_size)
     {
-        const auto offset = m_size;
-        m_size += alloc_size;
+        const auto offset = (m_size + m_alignment - 1) / m_alignment * m_alignment;
+        m_size = offset + alloc_size;
         return { offset, alloc_size };
     }
 };
@@ -100,20 +167,17 @@ private:
 enum BufferIndex
 {
     candidate_buffer_index,
-    world_uv_buffer_index,
-    density_buffer_index,
     index_buffer_index,
     count_buffer_index,
-    element_buffer_index
+    element_buffer_index,
+    pattern_tile_buffer_index
 };
 
 auto makeBindingArray(const TransientBuffer &transient_buffer, const ResultBuffer &result_buffer)
 {
-    std::array<std::pair<GL::BufferHandle, GL::Buffer::Range>, 6> array;
+    std::array<std::pair<GL::BufferHandle, GL::Buffer::Range>, 4> array;
 
     array[candidate_buffer_index] = {transient_buffer.getBuffer(), transient_buffer.getCandidateRange()};
-    array[world_uv_buffer_index] = {transient_buffer.getBuffer(), transient_buffer.getWorldUVRange()};
-    array[density_buffer_index] = {transient_buffer.getBuffer(), transient_buffer.getDensityRange()};
     array[index_buffer_index] = {transient_buffer.getBuffer(), transient_buffer.getIndexRange()};
     array[count_buffer_index] = {result_buffer.gl_object, result_buffer.getCountRange()};
     array[element_buffer_index] = {result_buffer.gl_object, result_buffer.getElementRange()};
@@ -128,55 +192,714 @@ void bindBuffers(uint base_index, const TransientBuffer& transient_buffer, const
     GL::Buffer::bindRanges(GL::Buffer::IndexedTarget::shader_storage, base_index, bindings.begin(), bindings.end());
 }
 
+/// Memory used by a single candidate while a tile is being placed: its transient data and its slot in the tile results.
+constexpr GLsizeiptr tile_bytes_per_candidate = TransientBuffer::candidate_size + TransientBuffer::index_size
+                                                + ResultBuffer::element_ssize;
+
+/// Result buffer for a tile of a split placement. It is only accessed by the GL, so it is not mapped.
+ResultBuffer makeTileResultBuffer(GLsizeiptr candidate_count, uint class_count)
+{
+    const auto size = class_count * ResultBuffer::uint_ssize + candidate_count * ResultBuffer::element_ssize;
+
+    ResultBuffer result_buffer {class_count, size, GL::Buffer(), nullptr};
+    result_buffer.gl_object.allocateImmutable(size, GL::Buffer::StorageFlags::none);
+
+    gl.ClearNamedBufferSubData(result_buffer.gl_object.getName(), GL_R8, 0, result_buffer.getCountBufferSize(), GL_RED,
+                               GL_UNSIGNED_BYTE, nullptr);
+
+    return result_buffer;
+}
+
 } // namespace
 
+/// Candidates generated for a placement region, along with the arguments that determine them.
+struct PlacementPipeline::CandidateCache
+{
+    uint seed;
+    glm::vec3 world_scale;
+    float footprint;
+    glm::vec2 lower_bound;
+    glm::vec2 upper_bound;
+    TransientBuffer transient_buffer;
+
+    [[nodiscard]] bool matches(uint seed_, const WorldData &world_data, float footprint_, glm::vec2 lower_bound_,
+                               glm::vec2 upper_bound_) const
+    {
+        return seed == seed_ && world_scale == world_data.scale && footprint == footprint_
+               && lower_bound == lower_bound_ && upper_bound == upper_bound_;
+    }
+};
+
+/// Placement kernels compiled for a KernelConfiguration.
+struct PlacementPipeline::KernelVariant
+{
+    explicit KernelVariant(const KernelConfiguration &configuration)
+            : generation(configuration), evaluation(configuration), indexation(configuration), copy(configuration)
+    {}
+
+    explicit KernelVariant(const KernelConfiguration &configuration, KernelPrograms &&programs);
+
+    /// Start compiling the FusedPlacementKernel in the background, unless it was already.
+    void compileFusedKernel()
+    {
+        if (!fused && !fused_program && !fused_failed)
+            fused_program.emplace(FusedPlacementKernel::compileAsync(generation.getConfiguration()));
+    }
+
+    /// The FusedPlacementKernel, compiled on first use, or nullptr if it failed to compile.
+    [[nodiscard]] FusedPlacementKernel *getFusedKernel()
+    {
+        compileFusedKernel();
+
+        if (fused_program)
+        {
+            try
+            {
+                fused.emplace(generation.getConfiguration(), std::move(*fused_program));
+            }
+            catch (const GL::GLError &)
+            {
+                fused_failed = true;
+            }
+            fused_program.reset();
+        }
+
+        return fused ? &*fused : nullptr;
+    }
+
+    GenerationKernel generation;
+    EvaluationKernel evaluation;
+    IndexationKernel indexation;
+    CopyKernel copy;
+
+    /// Only used for single dispatch placement, so only compiled once it is enabled.
+    std::optional<ComputeShaderProgram> fused_program;
+    std::optional<FusedPlacementKernel> fused;
+    bool fused_failed {false};
+};
+
+/// Programs of a KernelVariant whose compilation has been started, but not waited for.
+struct PlacementPipeline::KernelPrograms
+{
+    explicit KernelPrograms(const KernelConfiguration &configuration)
+            : generation(GenerationKernel::compileAsync(configuration)),
+              evaluation(EvaluationKernel::compileAsync(configuration)),
+              indexation(IndexationKernel::compileAsync(configuration)),
+              copy(CopyKernel::compileAsync(configuration))
+    {}
+
+    [[nodiscard]] bool isReady() const
+    {
+        return generation.isReady() && evaluation.isReady() && indexation.isReady() && copy.isReady();
+    }
+
+    ComputeShaderProgram generation;
+    ComputeShaderProgram evaluation;
+    ComputeShaderProgram indexation;
+    ComputeShaderProgram copy;
+};
+
+/// Kernels of an asynchronous construction. Only those that no other pipeline had compiled already are compiled.
+struct PlacementPipeline::PendingKernels
+{
+    explicit PendingKernels(const KernelConfiguration &configuration_) : configuration(configuration_)
+    {
+        if (!s_kernel_registry.count(configuration) || s_kernel_registry.at(configuration).expired())
+            programs.emplace(configuration);
+
+        if (s_reprojection_kernel.expired())
+            reprojection.emplace(ReprojectionKernel::compileAsync());
+    }
+
+    [[nodiscard]] bool isReady() const
+    {
+        return (!programs || programs->isReady()) && (!reprojection || reprojection->isReady());
+    }
+
+    KernelConfiguration configuration;
+    std::optional<KernelPrograms> programs;
+    std::optional<ComputeShaderProgram> reprojection;
+};
+
+std::map<KernelConfiguration, std::weak_ptr<PlacementPipeline::KernelVariant>> PlacementPipeline::s_kernel_registry;
+
+std::weak_ptr<ReprojectionKernel> PlacementPipeline::s_reprojection_kernel;
+
+PlacementPipeline::KernelVariant::KernelVariant(const KernelConfiguration &configuration, KernelPrograms &&programs)
+        : generation(configuration, std::move(programs.generation)),
+          evaluation(configuration, std::move(programs.evaluation)),
+          indexation(configuration, std::move(programs.indexation)),
+          copy(configuration, std::move(programs.copy))
+{}
+
+/// Work group pattern generated from a random seed, along with the pattern tiles and blue noise thresholds generated
+/// from it.
+struct PlacementPipeline::SeedPattern
+{
+    WorkGroupPattern work_group_pattern;
+    std::optional<ThresholdTexture> threshold_texture;
+    /// Number of patterns in the tile buffer, the first of which is the original one. Zero until it is allocated.
+    uint tile_count {0};
+    GL::Buffer tile_buffer;
+};
+
+PlacementPipeline::~PlacementPipeline() = default;
+
+PlacementPipeline::PlacementPipeline(PlacementPipeline&&) = default;
+
+PlacementPipeline& PlacementPipeline::operator=(PlacementPipeline&&) = default;
+
 FutureResult PlacementPipeline::computePlacement(const WorldData &world_data, const LayerData &layer_data,
                                                  glm::vec2 lower_bound, glm::vec2 upper_bound)
 {
-    constexpr glm::uvec2 wg_size{GenerationKernel::work_group_size};
+    return m_computePlacement(world_data, layer_data, lower_bound, upper_bound, m_random_seed, nullptr);
+}
+
+FutureResult PlacementPipeline::computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                 glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed)
+{
+    return m_computePlacement(world_data, layer_data, lower_bound, upper_bound, seed, nullptr);
+}
+
+FutureResult PlacementPipeline::updatePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                                glm::vec2 dirty_lower_bound, glm::vec2 dirty_upper_bound)
+{
+    const DirtyRect dirty_rect {dirty_lower_bound, dirty_upper_bound};
+    return m_computePlacement(world_data, layer_data, lower_bound, upper_bound, m_random_seed, &dirty_rect);
+}
+
+FutureResult PlacementPipeline::m_computePlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                   glm::vec2 lower_bound, glm::vec2 upper_bound, uint seed,
+                                                   const DirtyRect *dirty_rect)
+{
+    waitReady();
+    m_usePattern(seed);
+
+    const uint pattern_candidates = getKernelConfiguration().getPatternCandidateCount();
     const glm::vec2 wg_bounds = m_work_group_scale * layer_data.footprint;
 
-    const glm::uvec2 work_group_offset{lower_bound / wg_bounds};
-    const glm::uvec3 num_work_groups = {1u + glm::uvec2((upper_bound - lower_bound) / wg_bounds), 1u};
+    // an empty region has no elements, and no work groups to dispatch.
+    if (glm::any(glm::lessThanEqual(upper_bound, lower_bound)))
+    {
+        auto fence = GL::createFenceSync();
+        return {s_makeResultBuffer(0, layer_data.densitymaps.size()), std::move(fence)};
+    }
+
+    // only the work groups that overlap the region; the candidates of the boundary ones that fall outside of it are
+    // culled by the generation kernel.
+    glm::uvec2 work_group_offset{glm::floor(lower_bound / wg_bounds)};
+    glm::uvec3 num_work_groups = {glm::uvec2(glm::ceil(upper_bound / wg_bounds)) - work_group_offset, 1u};
+
+    // a region thinner than the rounding error of the division may still round to no work groups.
+    if (num_work_groups.x == 0 || num_work_groups.y == 0)
+    {
+        auto fence = GL::createFenceSync();
+        return {s_makeResultBuffer(0, layer_data.densitymaps.size()), std::move(fence)};
+    }
+
+    const auto cache_iter = std::find_if(m_candidate_cache.begin(), m_candidate_cache.end(), [&](const auto &entry)
+    {
+        return entry->matches(seed, world_data, layer_data.footprint, lower_bound, upper_bound);
+    });
+    const bool reuse_candidates = cache_iter != m_candidate_cache.end();
+
+    // culling. A class that adds exactly zero density over the whole region can be skipped without affecting the
+    // others, and an element can only be accepted where the density of at least one class is positive.
+    const uint class_count = layer_data.densitymaps.size();
+    std::vector<bool> active_classes(class_count, true);
+    bool all_classes_have_pyramids = true;
+    bool populated = false;
+
+    // the class tile grid rules out most classes of a layer with many of them, whose pyramids need not be queried.
+    std::vector<bool> present_classes(class_count, true);
+    if (layer_data.class_tiles)
+    {
+        if (layer_data.class_tiles->getClassCount() != class_count)
+            throw std::logic_error("the class tile grid does not match the density maps of the layer");
+
+        // a filtered sample reads texels up to two footprints wide, and up to two of them away from the sampled point.
+        const float margin = m_footprint_filtering ? 4.0f * layer_data.footprint : 0.0f;
+        const glm::vec2 world_size {world_data.scale};
+        present_classes = layer_data.class_tiles->getPresentClasses((lower_bound - margin) / world_size,
+                                                                    (upper_bound + margin) / world_size);
+    }
+
+    for (uint i = 0; i < class_count; i++)
+    {
+        if (!present_classes[i])
+        {
+            active_classes[i] = false;
+            continue;
+        }
+
+        const auto range = m_getDensityRange(layer_data.densitymaps[i], world_data, layer_data.footprint,
+                                             lower_bound, upper_bound);
+        active_classes[i] = !range || range->x != 0.0f || range->y != 0.0f;
+        all_classes_have_pyramids = all_classes_have_pyramids && range.has_value();
+        populated = populated || !range || range->y > 0.0f;
+    }
+
+    if (!populated && !reuse_candidates)
+    {
+        auto fence = GL::createFenceSync();
+        return {s_makeResultBuffer(0, class_count), std::move(fence)};
+    }
+
+    // cached candidates still need their classes to be reset by at least one evaluation.
+    if (reuse_candidates && std::find(active_classes.begin(), active_classes.end(), true) == active_classes.end())
+        active_classes.front() = true;
+
+    // cached candidates must cover the whole region, as the populated area changes with the density maps.
+    if (all_classes_have_pyramids && !isIncrementalModeEnabled())
+    {
+        glm::uvec2 populated_begin {std::numeric_limits<uint>::max()};
+        glm::uvec2 populated_end {0u};
+
+        // subdivide the grid, descending only into the parts that may contain elements.
+        const std::function<void(glm::uvec2, glm::uvec2)> find_populated_area = [&](glm::uvec2 begin, glm::uvec2 end)
+        {
+            if (glm::all(glm::greaterThanEqual(begin, populated_begin))
+                && glm::all(glm::lessThanEqual(end, populated_end)))
+                return;
+
+            const glm::vec2 lower = glm::max(glm::vec2(work_group_offset + begin) * wg_bounds, lower_bound);
+            const glm::vec2 upper = glm::min(glm::vec2(work_group_offset + end) * wg_bounds, upper_bound);
+
+            if (glm::any(glm::greaterThanEqual(lower, upper)))
+                return;
+
+            bool area_populated = false;
+            for (uint i = 0; i < class_count && !area_populated; i++)
+                area_populated = active_classes[i]
+                                 && m_getDensityRange(layer_data.densitymaps[i], world_data, layer_data.footprint,
+                                                      lower, upper)->y > 0.0f;
+
+            if (!area_populated)
+                return;
+
+            const glm::uvec2 size = end - begin;
+            if (size.x == 1 && size.y == 1)
+            {
+                populated_begin = glm::min(populated_begin, begin);
+                populated_end = glm::max(populated_end, end);
+            }
+            else if (size.x >= size.y)
+            {
+                find_populated_area(begin, {begin.x + size.x / 2, end.y});
+                find_populated_area({begin.x + size.x / 2, begin.y}, end);
+            }
+            else
+            {
+                find_populated_area(begin, {end.x, begin.y + size.y / 2});
+                find_populated_area({begin.x, begin.y + size.y / 2}, end);
+            }
+        };
+
+        find_populated_area(glm::uvec2(0u), glm::uvec2(num_work_groups));
+
+        if (glm::any(glm::greaterThanEqual(populated_begin, populated_end)))
+        {
+            auto fence = GL::createFenceSync();
+            return {s_makeResultBuffer(0, class_count), std::move(fence)};
+        }
+
+        work_group_offset += populated_begin;
+        num_work_groups = {populated_end - populated_begin, 1u};
+    }
+
+    // regions that exceed the device limits or the memory budget are placed one tile at a time. Their candidates are
+    // not cached, as they do not fit in a single buffer.
+    const glm::uvec2 tile_size = m_getTileSize(num_work_groups);
+    if (!reuse_candidates && tile_size != glm::uvec2(num_work_groups))
+        return m_computeTiledPlacement(world_data, layer_data, lower_bound, upper_bound, active_classes,
+                                       work_group_offset, num_work_groups, tile_size);
+
+    const uint candidate_count = num_work_groups.x * num_work_groups.y * pattern_candidates;
+
+    if (!reuse_candidates && !isIncrementalModeEnabled() && candidate_count <= m_single_dispatch_threshold
+        && class_count <= FusedPlacementKernel::max_class_count)
+    {
+        // the separate kernels place the region if the fused one failed to compile.
+        if (FusedPlacementKernel *kernel = m_kernels->getFusedKernel())
+            return m_computeSingleDispatchPlacement(*kernel, world_data, layer_data, lower_bound, upper_bound,
+                                                    active_classes, work_group_offset, num_work_groups);
+    }
+
+    std::optional<TransientBuffer> owned_transient_buffer;
+    const TransientBuffer *transient_buffer;
+
+    if (reuse_candidates)
+    {
+        // move the entry to the back, as it is now the most recently used.
+        std::rotate(cache_iter, cache_iter + 1, m_candidate_cache.end());
+        transient_buffer = &m_candidate_cache.back()->transient_buffer;
+    }
+    else if (isIncrementalModeEnabled())
+    {
+        if (m_candidate_cache.size() >= m_max_cached_regions)
+            m_candidate_cache.erase(m_candidate_cache.begin());
+
+        m_candidate_cache.emplace_back(new CandidateCache{seed, world_data.scale, layer_data.footprint, lower_bound,
+                                                          upper_bound, TransientBuffer{candidate_count}});
+        transient_buffer = &m_candidate_cache.back()->transient_buffer;
+    }
+    else
+        transient_buffer = &owned_transient_buffer.emplace(candidate_count);
+
+    // work groups that have to be evaluated; only those overlapping the dirty rectangle when updating previously
+    // generated candidates.
+    glm::uvec2 sub_grid_offset {0u};
+    glm::uvec2 sub_grid_size = num_work_groups;
 
-    const uint candidate_count = num_work_groups.x * num_work_groups.y * wg_size.x * wg_size.y;
+    if (reuse_candidates && dirty_rect)
+    {
+        const glm::ivec2 grid_size {num_work_groups};
+        const glm::ivec2 dirty_begin = glm::ivec2(glm::floor(dirty_rect->lower_bound / wg_bounds))
+                                       - glm::ivec2(work_group_offset);
+        const glm::ivec2 dirty_end = glm::ivec2(glm::ceil(dirty_rect->upper_bound / wg_bounds))
+                                     - glm::ivec2(work_group_offset);
 
-    TransientBuffer transient_buffer {candidate_count};
+        sub_grid_offset = glm::uvec2(glm::clamp(dirty_begin, glm::ivec2(0), grid_size));
+        sub_grid_size = glm::uvec2(glm::max(glm::clamp(dirty_end, glm::ivec2(0), grid_size)
+                                            - glm::ivec2(sub_grid_offset), glm::ivec2(0)));
+    }
 
     ResultBuffer result_buffer = s_makeResultBuffer(candidate_count, layer_data.densitymaps.size());
 
-    bindBuffers(m_base_binding_index, transient_buffer, result_buffer);
+    bindBuffers(m_base_binding_index, *transient_buffer, result_buffer);
 
-    // generation
+    m_dispatchKernels(world_data, layer_data, lower_bound, upper_bound, active_classes, work_group_offset,
+                      num_work_groups, sub_grid_offset, sub_grid_size, !reuse_candidates);
+
+    // fence
+    auto fence = GL::createFenceSync();
+    gl.Flush();
+
+    return {std::move(result_buffer), std::move(fence)};
+}
+
+FutureResult PlacementPipeline::m_computeSingleDispatchPlacement(FusedPlacementKernel &kernel,
+                                                                const WorldData &world_data,
+                                                                const LayerData &layer_data,
+                                                                glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                                                const std::vector<bool> &active_classes,
+                                                                glm::uvec2 work_group_offset,
+                                                                glm::uvec2 num_work_groups)
+{
+    const uint candidate_count = num_work_groups.x * num_work_groups.y
+                                 * kernel.getConfiguration().getPatternCandidateCount();
+
+    ResultBuffer result_buffer = s_makeResultBuffer(candidate_count, layer_data.densitymaps.size());
+
+    using Target = GL::Buffer::IndexedTarget;
+    result_buffer.gl_object.bindRange(Target::shader_storage, m_getBindingIndex(count_buffer_index),
+                                      result_buffer.getCountRange());
+    result_buffer.gl_object.bindRange(Target::shader_storage, m_getBindingIndex(element_buffer_index),
+                                      result_buffer.getElementRange());
+
+    const SeedPattern &pattern = *m_seed_patterns.at(*m_pattern_seed);
+
+    pattern.tile_buffer.bindRange(Target::shader_storage, m_getBindingIndex(pattern_tile_buffer_index),
+                                  {0, pattern.tile_count * m_kernels->generation.getPatternTileSize()});
+    kernel.setPatternTiles(m_getBindingIndex(pattern_tile_buffer_index), pattern.tile_count);
+    kernel.setWorkGroupPatternBoundaries(pattern.work_group_pattern.scale);
+    kernel.setParameterBindingIndex(m_uniform_binding_index);
+    kernel.setSampleFootprint(m_footprint_filtering ? layer_data.footprint : 0.0f);
+
+    const auto &threshold_texture = pattern.threshold_texture;
+    if (threshold_texture)
+        gl.BindTextureUnit(m_base_tex_unit + 1, threshold_texture->getTexture());
+    kernel.setThresholdTexture(m_base_tex_unit + 1, threshold_texture ? threshold_texture->getSize() : 0u);
+
+    // each density map texture has its own texture unit, after those of the heightmap and of the thresholds.
     gl.BindTextureUnit(m_base_tex_unit, world_data.heightmap);
-    m_generation_kernel(num_work_groups, work_group_offset, layer_data.footprint, world_data.scale, m_base_tex_unit,
-                        m_getBindingIndex(candidate_buffer_index), m_getBindingIndex(world_uv_buffer_index),
-                        m_getBindingIndex(density_buffer_index));
-    gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    const std::vector<GLuint> textures = FusedPlacementKernel::getDensityMapTextures(layer_data.densitymaps,
+                                                                                     active_classes);
+    for (std::size_t i = 0; i < textures.size(); i++)
+        gl.BindTextureUnit(m_base_tex_unit + 2 + i, textures[i]);
 
-    // evaluation
-    const uint class_count = layer_data.densitymaps.size();
-    for (std::size_t i = 0; i < class_count; i++)
-    {
-        gl.BindTextureUnit(m_base_tex_unit, layer_data.densitymaps[i].texture);
-        m_evaluation_kernel(num_work_groups, work_group_offset, i, lower_bound, upper_bound, m_base_tex_unit,
-                            layer_data.densitymaps[i],
-                            m_getBindingIndex(candidate_buffer_index),
-                            m_getBindingIndex(world_uv_buffer_index),
-                            m_getBindingIndex(density_buffer_index));
+    kernel(num_work_groups, work_group_offset, layer_data.footprint, lower_bound, upper_bound, world_data.scale,
+           m_base_tex_unit, m_base_tex_unit + 2, layer_data.densitymaps, active_classes,
+           m_getBindingIndex(count_buffer_index), m_getBindingIndex(element_buffer_index));
+
+    // fence
+    auto fence = GL::createFenceSync();
+    gl.Flush();
+
+    return {std::move(result_buffer), std::move(fence)};
+}
+
+void PlacementPipeline::m_dispatchKernels(const WorldData &world_data, const LayerData &layer_data,
+                                          glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                          const std::vector<bool> &active_classes, glm::uvec2 work_group_offset,
+                                          glm::uvec2 num_work_groups, glm::uvec2 sub_grid_offset,
+                                          glm::uvec2 sub_grid_size, bool generate)
+{
+    GenerationKernel &generation_kernel = m_kernels->generation;
+    EvaluationKernel &evaluation_kernel = m_kernels->evaluation;
+
+    const uint candidate_count = num_work_groups.x * num_work_groups.y
+                                 * generation_kernel.getConfiguration().getPatternCandidateCount();
+    const bool dispatch_sub_grid = sub_grid_size.x > 0 && sub_grid_size.y > 0;
+
+    generation_kernel.setParameterBindingIndex(m_uniform_binding_index);
+    evaluation_kernel.setParameterBindingIndex(m_uniform_binding_index);
+    m_kernels->copy.setParameterBindingIndex(m_uniform_binding_index);
+
+    evaluation_kernel.setSubGrid(sub_grid_offset, num_work_groups.x);
+    evaluation_kernel.setSampleFootprint(m_footprint_filtering ? layer_data.footprint : 0.0f);
+
+    const SeedPattern &pattern = *m_seed_patterns.at(*m_pattern_seed);
+
+    // the kernels are shared with other pipelines, so the pattern is passed with every dispatch.
+    pattern.tile_buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage,
+                                  m_getBindingIndex(pattern_tile_buffer_index),
+                                  {0, pattern.tile_count * generation_kernel.getPatternTileSize()});
+    generation_kernel.setPatternTiles(m_getBindingIndex(pattern_tile_buffer_index), pattern.tile_count);
+    generation_kernel.setWorkGroupPatternBoundaries(pattern.work_group_pattern.scale);
+    evaluation_kernel.setPatternTiles(m_getBindingIndex(pattern_tile_buffer_index), pattern.tile_count);
+    evaluation_kernel.setWorkGroupPatternBoundaries(pattern.work_group_pattern.scale);
+    m_kernels->copy.setPatternTiles(m_getBindingIndex(pattern_tile_buffer_index), pattern.tile_count);
+    m_kernels->copy.setWorkGroupPatternBoundaries(pattern.work_group_pattern.scale);
+
+    const auto &threshold_texture = pattern.threshold_texture;
+    if (threshold_texture)
+        gl.BindTextureUnit(m_base_tex_unit + 1, threshold_texture->getTexture());
+    evaluation_kernel.setThresholdTexture(m_base_tex_unit + 1, threshold_texture ? threshold_texture->getSize() : 0u);
+
+    // generation
+    if (generate)
+    {
+        generation_kernel(sub_grid_size, work_group_offset, layer_data.footprint, lower_bound, upper_bound,
+                          m_getBindingIndex(candidate_buffer_index));
+        gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // evaluation, one dispatch per run of active classes whose density maps share a texture. Inactive classes add no
+    // density, so skipping them does not break a run.
+    bool reset = !generate;
+
+    // with a class tile grid, each run is only evaluated where it is present, so the cached candidates are reset
+    // beforehand by a dispatch that evaluates no class.
+    if (reset && layer_data.class_tiles && dispatch_sub_grid)
+    {
+        evaluation_kernel(sub_grid_size, work_group_offset, layer_data.footprint, std::vector<uint>(), lower_bound,
+                          upper_bound, glm::vec2(world_data.scale), m_base_tex_unit, std::vector<DensityMap>(),
+                          m_getBindingIndex(candidate_buffer_index), true);
         gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        reset = false;
     }
 
+    std::size_t i = 0;
+    while (dispatch_sub_grid && i < active_classes.size())
+    {
+        if (!active_classes[i])
+        {
+            i++;
+            continue;
+        }
+
+        const GLuint texture = layer_data.densitymaps[i].texture;
+        std::vector<uint> class_indices;
+        std::vector<DensityMap> density_maps;
+        for (; i < active_classes.size() && class_indices.size() < EvaluationKernel::max_packed_classes; i++)
+        {
+            if (!active_classes[i])
+                continue;
+            if (layer_data.densitymaps[i].texture != texture)
+                break;
+
+            class_indices.push_back(i);
+            density_maps.push_back(layer_data.densitymaps[i]);
+        }
+
+        // the ranges are disjoint, so their dispatches need no barrier between them.
+        std::vector<std::pair<glm::uvec2, glm::uvec2>> ranges {{sub_grid_offset, sub_grid_offset + sub_grid_size}};
+        if (layer_data.class_tiles)
+        {
+            ranges = m_getClassWorkGroups(world_data, layer_data, class_indices, work_group_offset, sub_grid_offset,
+                                          sub_grid_offset + sub_grid_size);
+            if (ranges.empty())
+                continue;
+        }
+
+        gl.BindTextureUnit(m_base_tex_unit, texture);
+        for (const auto &[begin, end] : ranges)
+        {
+            evaluation_kernel.setSubGrid(begin, num_work_groups.x);
+            evaluation_kernel(end - begin, work_group_offset, layer_data.footprint, class_indices, lower_bound,
+                              upper_bound, glm::vec2(world_data.scale), m_base_tex_unit, density_maps,
+                              m_getBindingIndex(candidate_buffer_index), reset);
+        }
+        gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        reset = false;
+    }
+
+    evaluation_kernel.setSubGrid({0u, 0u}, 0u);
+
     // indexation
-    m_indexation_kernel(IndexationKernel::calculateNumWorkGroups(candidate_count),
-                        m_getBindingIndex(candidate_buffer_index), m_getBindingIndex(count_buffer_index),
-                        m_getBindingIndex(index_buffer_index));
+    m_kernels->indexation(m_kernels->indexation.calculateNumWorkGroups(candidate_count),
+                          m_getBindingIndex(candidate_buffer_index), m_getBindingIndex(count_buffer_index),
+                          m_getBindingIndex(index_buffer_index));
     gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
     // copy
-    m_copy_kernel(CopyKernel::calculateNumWorkGroups(candidate_count), m_getBindingIndex(candidate_buffer_index),
-                  m_getBindingIndex(count_buffer_index), m_getBindingIndex(index_buffer_index),
-                  m_getBindingIndex(element_buffer_index));
+    gl.BindTextureUnit(m_base_tex_unit, world_data.heightmap);
+    m_kernels->copy(m_kernels->copy.calculateNumWorkGroups(candidate_count), work_group_offset, num_work_groups.x,
+                    layer_data.footprint, world_data.scale, m_base_tex_unit, m_getBindingIndex(candidate_buffer_index),
+                    m_getBindingIndex(count_buffer_index), m_getBindingIndex(index_buffer_index),
+                    m_getBindingIndex(element_buffer_index));
+}
+
+FutureResult PlacementPipeline::m_computeTiledPlacement(const WorldData &world_data, const LayerData &layer_data,
+                                                        glm::vec2 lower_bound, glm::vec2 upper_bound,
+                                                        const std::vector<bool> &active_classes,
+                                                        glm::uvec2 work_group_offset, glm::uvec2 num_work_groups,
+                                                        glm::uvec2 tile_size)
+{
+    const uint pattern_candidates = getKernelConfiguration().getPatternCandidateCount();
+    const uint class_count = active_classes.size();
+
+    // the elements of each class, in host memory until the final result is created. Keeping them on the GPU would use
+    // as much memory as the final result on top of it, which the budget does not cover.
+    std::vector<std::vector<ResultElement>> class_elements(class_count);
+    std::vector<ResultElement> tile_elements;
+
+    for (uint y = 0; y < num_work_groups.y; y += tile_size.y)
+        for (uint x = 0; x < num_work_groups.x; x += tile_size.x)
+        {
+            const glm::uvec2 tile_offset {x, y};
+            const glm::uvec2 tile_work_groups = glm::min(tile_size, num_work_groups - tile_offset);
+            const uint candidate_count = tile_work_groups.x * tile_work_groups.y * pattern_candidates;
+
+            // the grid index of each work group is the same as in a single dispatch, so the result is too.
+            TransientBuffer transient_buffer {candidate_count};
+            ResultBuffer tile_buffer = makeTileResultBuffer(candidate_count, class_count);
+
+            bindBuffers(m_base_binding_index, transient_buffer, tile_buffer);
+            m_dispatchKernels(world_data, layer_data, lower_bound, upper_bound, active_classes,
+                              work_group_offset + tile_offset, tile_work_groups, {0u, 0u}, tile_work_groups, true);
+            gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            // reading the tile back waits for it to finish, which bounds the GPU memory in use to a single tile.
+            std::vector<uint> class_counts(class_count);
+            tile_buffer.gl_object.read(tile_buffer.getCountRange(), class_counts.data());
+
+            GLsizeiptr element_count = 0;
+            for (uint count : class_counts)
+                element_count += count;
+
+            if (element_count == 0)
+                continue;
+
+            tile_elements.resize(element_count);
+            tile_buffer.gl_object.read({tile_buffer.getElementBufferOffset(),
+                                        element_count * ResultBuffer::element_ssize}, tile_elements.data());
+
+            auto tile_iter = tile_elements.begin();
+            for (uint i = 0; i < class_count; i++)
+            {
+                class_elements[i].insert(class_elements[i].end(), tile_iter, tile_iter + class_counts[i]);
+                tile_iter += class_counts[i];
+            }
+        }
+
+    GLsizeiptr total_count = 0;
+    for (const auto &elements : class_elements)
+        total_count += elements.size();
+
+    if (total_count > std::numeric_limits<uint>::max())
+        throw std::runtime_error("placement result exceeds the maximum element count");
+
+    // counts followed by the elements, stitched class by class so that they remain sorted by class.
+    std::vector<std::byte> data(class_count * ResultBuffer::uint_ssize + total_count * ResultBuffer::element_ssize);
+    std::byte *write_ptr = data.data();
+    for (const auto &elements : class_elements)
+    {
+        const auto count = static_cast<uint>(elements.size());
+        std::memcpy(write_ptr, &count, sizeof(count));
+        write_ptr += sizeof(count);
+    }
+    for (auto &elements : class_elements)
+    {
+        std::memcpy(write_ptr, elements.data(), elements.size() * ResultBuffer::element_ssize);
+        write_ptr += elements.size() * ResultBuffer::element_ssize;
+        elements = {};
+    }
+
+    ResultBuffer result_buffer = s_makeResultBuffer(total_count, class_count, data.data());
+
+    // fence
+    auto fence = GL::createFenceSync();
+    gl.Flush();
+
+    return {std::move(result_buffer), std::move(fence)};
+}
+
+glm::uvec2 PlacementPipeline::m_getTileSize(glm::uvec2 num_work_groups) const
+{
+    const KernelConfiguration &configuration = getKernelConfiguration();
+    const GLsizeiptr work_group_candidates = configuration.getPatternCandidateCount();
+
+    // the candidate and element arrays of a tile are each bound as a single shader storage block.
+    GLsizeiptr max_work_groups = m_max_storage_block_size / (work_group_candidates * ResultBuffer::element_ssize);
+
+    // indexation and copy are dispatched over a one-dimensional grid of candidates.
+    const GLsizeiptr linear_candidates_per_group = std::min(2 * configuration.indexation_local_size,
+                                                            configuration.copy_local_size);
+    max_work_groups = std::min(max_work_groups, (m_max_work_group_count.x - 1) * linear_candidates_per_group
+                                                / work_group_candidates);
+
+    if (m_memory_budget > 0)
+        max_work_groups = std::min(max_work_groups,
+                                   m_memory_budget / (work_group_candidates * tile_bytes_per_candidate));
+
+    // a budget set for a smaller pattern size may not fit a single work group, which is then placed on its own.
+    max_work_groups = std::max<GLsizeiptr>(max_work_groups, 1);
+
+    // generation and evaluation dispatch one invocation per candidate, in compute work groups of the local size.
+    glm::uvec2 max_grid_size;
+    for (int i = 0; i < 2; i++)
+        max_grid_size[i] = static_cast<uint>(std::min<GLsizeiptr>(
+                static_cast<GLsizeiptr>(m_max_work_group_count[i]) * configuration.local_size[i]
+                / configuration.pattern_size[i], std::numeric_limits<uint>::max()));
+
+    glm::uvec2 tile_size = glm::min(num_work_groups, max_grid_size);
+    tile_size.x = std::min<GLsizeiptr>(tile_size.x, max_work_groups);
+    tile_size.y = std::min<GLsizeiptr>(tile_size.y, max_work_groups / tile_size.x);
+
+    return tile_size;
+}
+
+FutureResult PlacementPipeline::reprojectHeights(Result &&result, const WorldData &world_data)
+{
+    // every element is updated, including those placed outside of [0, world_data.scale).
+    return reprojectHeights(std::move(result), world_data, glm::vec2(std::numeric_limits<float>::lowest()),
+                            glm::vec2(std::numeric_limits<float>::max()));
+}
+
+FutureResult PlacementPipeline::reprojectHeights(Result &&result, const WorldData &world_data,
+                                                 glm::vec2 dirty_lower_bound, glm::vec2 dirty_upper_bound)
+{
+    waitReady();
+
+    const uint element_count = result.getElementArrayLength();
+    ResultBuffer result_buffer = result.moveBuffer();
+
+    if (element_count > 0)
+    {
+        result_buffer.gl_object.bindRange(GL::Buffer::IndexedTarget::shader_storage,
+                                          m_getBindingIndex(element_buffer_index), result_buffer.getElementRange());
+
+        gl.BindTextureUnit(m_base_tex_unit, world_data.heightmap);
+        m_reprojection_kernel->setParameterBindingIndex(m_uniform_binding_index);
+
+        // the elements may have just been written by the copy kernel of the placement.
+        gl.MemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        (*m_reprojection_kernel)(element_count, world_data.scale, m_base_tex_unit, dirty_lower_bound,
+                                 dirty_upper_bound, m_getBindingIndex(element_buffer_index));
+    }
 
     // fence
     auto fence = GL::createFenceSync();
@@ -195,22 +918,322 @@ void PlacementPipeline::setBaseShaderStorageBindingPoint(GLuint index)
     m_base_binding_index = index;
 }
 
+void PlacementPipeline::setUniformBufferBindingPoint(GLuint index)
+{
+    m_uniform_binding_index = index;
+}
+
+void PlacementPipeline::setIncrementalMode(bool enabled, uint max_cached_regions)
+{
+    m_max_cached_regions = enabled ? std::max(max_cached_regions, 1u) : 0u;
+
+    if (m_candidate_cache.size() > m_max_cached_regions)
+        m_candidate_cache.erase(m_candidate_cache.begin(),
+                                m_candidate_cache.end() - static_cast<std::ptrdiff_t>(m_max_cached_regions));
+}
+
+void PlacementPipeline::generateDensityMipmaps(GLuint texture)
+{
+    GLint immutable = GL_FALSE;
+    gl.GetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+
+    if (immutable)
+    {
+        GLint levels = 0;
+        gl.GetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+        if (levels < 2)
+            throw std::logic_error("density map texture has no storage for mip levels");
+    }
+
+    gl.GenerateTextureMipmap(texture);
+    gl.TextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void PlacementPipeline::setBlueNoiseThresholds(uint size)
+{
+    m_blue_noise_size = size;
+    m_usePattern(m_random_seed);
+}
+
+void PlacementPipeline::setPatternTileCount(uint count)
+{
+    if (count == 0)
+        throw std::logic_error("pattern tile count must be non-zero");
+
+    // cached candidates were generated with the previous tiles.
+    invalidateCandidates();
+
+    m_pattern_tile_count = count;
+    m_usePattern(m_random_seed);
+}
+
+void PlacementPipeline::setMemoryBudget(GLsizeiptr bytes)
+{
+    const GLsizeiptr min_budget = getKernelConfiguration().getPatternCandidateCount() * tile_bytes_per_candidate;
+
+    if (bytes < 0 || (bytes > 0 && bytes < min_budget))
+        throw std::logic_error("memory budget must be zero or large enough for a single work group");
+
+    m_memory_budget = bytes;
+}
+
+void PlacementPipeline::setSingleDispatchThreshold(uint candidate_count)
+{
+    if (candidate_count > FusedPlacementKernel::max_candidate_count)
+        throw std::logic_error("single dispatch threshold exceeds the candidates of a single work group");
+
+    m_single_dispatch_threshold = candidate_count;
+
+    // the kernel compiles in the background until the first region small enough for it.
+    if (candidate_count > 0 && m_kernels)
+        m_kernels->compileFusedKernel();
+}
+
+void PlacementPipeline::invalidateCandidates()
+{
+    m_candidate_cache.clear();
+}
+
+void PlacementPipeline::setDensityPyramid(GLuint texture, DensityPyramid pyramid, DensityMap::Channel channel)
+{
+    m_density_pyramids.insert_or_assign({texture, channel}, std::move(pyramid));
+}
+
+void PlacementPipeline::buildDensityPyramid(GLuint texture, DensityMap::Channel channel)
+{
+    setDensityPyramid(texture, DensityPyramid::fromTexture(texture, channel), channel);
+}
+
+void PlacementPipeline::removeDensityPyramid(GLuint texture)
+{
+    // the channels of a texture are adjacent in the map.
+    m_density_pyramids.erase(m_density_pyramids.lower_bound({texture, DensityMap::Channel::red}),
+                             m_density_pyramids.upper_bound({texture, DensityMap::Channel::alpha}));
+}
+
+ClassTileGrid PlacementPipeline::buildClassTileGrid(const std::vector<DensityMap> &density_maps, glm::uvec2 size) const
+{
+    std::vector<const DensityPyramid*> pyramids;
+    for (const DensityMap &density_map : density_maps)
+    {
+        const auto iter = m_density_pyramids.find({density_map.texture, density_map.channel});
+        pyramids.push_back(iter == m_density_pyramids.end() ? nullptr : &iter->second);
+    }
+
+    return {size, density_maps, pyramids};
+}
+
+std::vector<std::pair<glm::uvec2, glm::uvec2>>
+PlacementPipeline::m_getClassWorkGroups(const WorldData &world_data, const LayerData &layer_data,
+                                        const std::vector<uint> &class_indices, glm::uvec2 work_group_offset,
+                                        glm::uvec2 begin, glm::uvec2 end) const
+{
+    const ClassTileGrid &grid = *layer_data.class_tiles;
+    const glm::vec2 wg_bounds = m_work_group_scale * layer_data.footprint;
+    const glm::vec2 world_size {world_data.scale};
+
+    // candidates sample the density maps up to this distance away from their position, see m_getDensityRange().
+    const float margin = m_footprint_filtering ? 4.0f * layer_data.footprint : 0.0f;
+
+    const glm::vec2 lower = glm::vec2(work_group_offset + begin) * wg_bounds - margin;
+    const glm::vec2 upper = glm::vec2(work_group_offset + end) * wg_bounds + margin;
+    const auto [tile_begin, tile_end] = grid.getTileRange(lower / world_size, upper / world_size);
+
+    // work groups of [begin, end) with candidates that may sample a tile where one of the classes is present.
+    const glm::uvec2 size = end - begin;
+    std::vector<bool> covered(static_cast<std::size_t>(size.x) * size.y, false);
+
+    // tiles outside of the grid are those sampled past the edges of the density maps.
+    for (int y = tile_begin.y; y < tile_end.y; y++)
+        for (int x = tile_begin.x; x < tile_end.x; x++)
+        {
+            const glm::ivec2 tile {x, y};
+            if (std::none_of(class_indices.begin(), class_indices.end(),
+                             [&](uint class_index) { return grid.isClassPresent(tile, class_index); }))
+                continue;
+
+            const glm::vec2 tile_lower = grid.getTileLowerBound(tile) * world_size - margin;
+            const glm::vec2 tile_upper = grid.getTileLowerBound(tile + 1) * world_size + margin;
+            const glm::ivec2 tile_wg_begin = glm::ivec2(glm::floor(tile_lower / wg_bounds))
+                                             - glm::ivec2(work_group_offset + begin);
+            const glm::ivec2 tile_wg_end = glm::ivec2(glm::ceil(tile_upper / wg_bounds))
+                                           - glm::ivec2(work_group_offset + begin);
+
+            const glm::uvec2 covered_begin {glm::clamp(tile_wg_begin, glm::ivec2(0), glm::ivec2(size))};
+            const glm::uvec2 covered_end {glm::clamp(tile_wg_end, glm::ivec2(0), glm::ivec2(size))};
+            for (uint j = covered_begin.y; j < covered_end.y; j++)
+                std::fill_n(covered.begin() + j * size.x + covered_begin.x, covered_end.x - covered_begin.x, true);
+        }
+
+    // the covered work groups as disjoint rectangles, since evaluating candidates twice would add their density twice:
+    // one per run of covered work groups in a row, extended over the following rows that have the same run.
+    std::vector<std::pair<glm::uvec2, glm::uvec2>> ranges;
+    std::vector<std::pair<glm::uvec2, glm::uvec2>> open_ranges;
+    for (uint y = 0; y < size.y; y++)
+    {
+        std::vector<std::pair<glm::uvec2, glm::uvec2>> row_ranges;
+        for (uint x = 0; x < size.x;)
+        {
+            if (!covered[y * size.x + x])
+            {
+                x++;
+                continue;
+            }
+
+            const uint run_begin = x;
+            while (x < size.x && covered[y * size.x + x])
+                x++;
+
+            const auto open = std::find_if(open_ranges.begin(), open_ranges.end(), [&](const auto &range)
+            {
+                return range.first.x == begin.x + run_begin && range.second.x == begin.x + x;
+            });
+            if (open != open_ranges.end())
+            {
+                row_ranges.push_back({open->first, open->second + glm::uvec2(0, 1)});
+                open_ranges.erase(open);
+            }
+            else
+                row_ranges.push_back({begin + glm::uvec2(run_begin, y), begin + glm::uvec2(x, y + 1)});
+        }
+
+        ranges.insert(ranges.end(), open_ranges.begin(), open_ranges.end());
+        open_ranges = std::move(row_ranges);
+    }
+    ranges.insert(ranges.end(), open_ranges.begin(), open_ranges.end());
+
+    return ranges;
+}
+
+std::optional<glm::vec2> PlacementPipeline::m_getDensityRange(const DensityMap &density_map,
+                                                              const WorldData &world_data, float footprint,
+                                                              glm::vec2 lower_bound, glm::vec2 upper_bound) const
+{
+    const auto iter = m_density_pyramids.find({density_map.texture, density_map.channel});
+    if (iter == m_density_pyramids.end())
+        return std::nullopt;
+
+    // a filtered sample reads texels up to two footprints wide, and up to two of them away from the sampled point.
+    if (m_footprint_filtering)
+    {
+        lower_bound -= 4.0f * footprint;
+        upper_bound += 4.0f * footprint;
+    }
+
+    const glm::vec2 world_size {world_data.scale};
+    return iter->second.getRange(density_map, lower_bound / world_size, upper_bound / world_size);
+}
+
+bool PlacementPipeline::isReady() const
+{
+    return !m_pending_kernels || m_pending_kernels->isReady();
+}
+
+void PlacementPipeline::waitReady()
+{
+    // the programs of a failed construction may have been moved into the kernels, so they cannot be waited for again.
+    if (m_kernel_error)
+        std::rethrow_exception(m_kernel_error);
+
+    if (!m_pending_kernels)
+        return;
+
+    PendingKernels &pending = *m_pending_kernels;
+    const KernelConfiguration &configuration = pending.configuration;
+
+    try
+    {
+        // another pipeline may have compiled the same kernels in the meantime, in which case ours are discarded.
+        m_reprojection_kernel = s_getReprojectionKernel(pending.reprojection ? &*pending.reprojection : nullptr);
+        const auto &variant = s_getKernelVariant(configuration, pending.programs ? &*pending.programs : nullptr);
+        m_kernels = m_kernel_variants.emplace(configuration, variant).first->second.get();
+    }
+    catch (...)
+    {
+        m_kernel_error = std::current_exception();
+        throw;
+    }
+
+    m_pending_kernels.reset();
+
+    if (m_single_dispatch_threshold > 0)
+        m_kernels->compileFusedKernel();
+}
+
+void PlacementPipeline::setKernelConfiguration(const KernelConfiguration &configuration)
+{
+    if (!configuration.isSupported())
+        throw std::logic_error("unsupported kernel configuration");
+
+    waitReady();
+
+    auto iter = m_kernel_variants.find(configuration);
+    if (iter == m_kernel_variants.end())
+        iter = m_kernel_variants.emplace(configuration, s_getKernelVariant(configuration)).first;
+
+    // patterns and cached candidates are laid out for a single pattern size.
+    if (m_kernels && getKernelConfiguration().pattern_size != configuration.pattern_size)
+    {
+        m_seed_patterns.clear();
+        invalidateCandidates();
+    }
+
+    m_kernels = iter->second.get();
+    m_usePattern(m_random_seed);
+
+    if (m_single_dispatch_threshold > 0)
+        m_kernels->compileFusedKernel();
+}
+
+const KernelConfiguration &PlacementPipeline::getKernelConfiguration() const
+{
+    return m_pending_kernels ? m_pending_kernels->configuration : m_kernels->generation.getConfiguration();
+}
+
 void PlacementPipeline::setRandomSeed(uint seed)
 {
-    constexpr auto wg_size = GenerationKernel::work_group_size;
+    m_random_seed = seed;
+    m_usePattern(seed);
+}
+
+void PlacementPipeline::m_usePattern(uint seed)
+{
+    auto iter = m_seed_patterns.find(seed);
 
-    DiskDistributionGenerator generator{1.0f, wg_size * 2u};
-    generator.setSeed(seed);
-    generator.setMaxAttempts(100);
-    m_work_group_scale = generator.getGrid().getBounds();
-    m_generation_kernel.setWorkGroupPatternBoundaries(m_work_group_scale);
+    if (iter == m_seed_patterns.end())
+    {
+        if (m_seed_patterns.size() >= max_cached_patterns)
+        {
+            m_seed_patterns.clear();
+            m_pattern_seed.reset();
+        }
+
+        auto pattern = std::make_unique<SeedPattern>();
+        pattern->work_group_pattern = generateWorkGroupPattern(seed, getKernelConfiguration().pattern_size);
+        iter = m_seed_patterns.emplace(seed, std::move(pattern)).first;
+    }
+
+    SeedPattern &pattern = *iter->second;
+
+    if (pattern.tile_count != m_pattern_tile_count)
+    {
+        const std::vector<glm::vec2> tiles = generatePatternTiles(pattern.work_group_pattern, seed,
+                                                                  m_pattern_tile_count);
+
+        pattern.tile_buffer = GL::Buffer();
+        pattern.tile_buffer.allocateImmutable(static_cast<GLsizeiptr>(tiles.size() * sizeof(glm::vec2)),
+                                              GL::Buffer::StorageFlags::none, tiles.data());
+        pattern.tile_count = m_pattern_tile_count;
+    }
 
-    std::array<std::array<glm::vec2, wg_size.y>, wg_size.x> positions;
-    for (auto &column: positions)
-        for (auto &cell: column)
-            cell = generator.generate();
+    const uint threshold_texture_size = pattern.threshold_texture ? pattern.threshold_texture->getSize() : 0u;
+    if (m_blue_noise_size == 0)
+        pattern.threshold_texture.reset();
+    else if (threshold_texture_size != m_blue_noise_size)
+        pattern.threshold_texture = ThresholdTexture::fromSeed(m_blue_noise_size, seed);
 
-    m_generation_kernel.setWorkGroupPatternColumns(positions);
+    m_work_group_scale = pattern.work_group_pattern.scale;
+    m_pattern_seed = seed;
 }
 
-} // placement
\ No newline at end of file
+} // placement
@@ -0,0 +1,227 @@
+#include "placement/threshold_texture.hpp"
+#include "gl_context.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <random>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+
+namespace placement {
+
+namespace {
+
+/// Sum of toroidal gaussian kernels centered on the set pixels of a binary pattern.
+class EnergyField
+{
+public:
+    explicit EnergyField(GLuint size) : m_size(size), m_energy(static_cast<std::size_t>(size) * size, 0.0f)
+    {
+        constexpr float sigma = 1.5f;
+        constexpr int radius = 6;
+
+        // the window must not wrap around onto itself for small sizes.
+        m_begin = -std::min(radius, static_cast<int>(size - 1) / 2);
+        m_end = std::min(radius, static_cast<int>(size) / 2) + 1;
+
+        for (int y = m_begin; y < m_end; y++)
+            for (int x = m_begin; x < m_end; x++)
+                m_weights.push_back(std::exp(-static_cast<float>(x * x + y * y) / (2.0f * sigma * sigma)));
+    }
+
+    void add(std::size_t index, float sign)
+    {
+        const int size = static_cast<int>(m_size);
+        const int center_x = static_cast<int>(index % m_size);
+        const int center_y = static_cast<int>(index / m_size);
+
+        auto weight = m_weights.begin();
+        for (int y = m_begin; y < m_end; y++)
+            for (int x = m_begin; x < m_end; x++)
+            {
+                const int wrapped_x = (center_x + x + size) % size;
+                const int wrapped_y = (center_y + y + size) % size;
+                m_energy[wrapped_y * m_size + wrapped_x] += sign * *weight++;
+            }
+    }
+
+    [[nodiscard]] float operator[](std::size_t index) const { return m_energy[index]; }
+
+private:
+    GLuint m_size;
+    int m_begin;
+    int m_end;
+    std::vector<float> m_weights;
+    std::vector<float> m_energy;
+};
+
+struct BinaryPattern
+{
+    std::vector<std::uint8_t> pixels;
+    EnergyField energy;
+
+    void set(std::size_t index, bool value)
+    {
+        pixels[index] = value;
+        energy.add(index, value ? 1.0f : -1.0f);
+    }
+
+    /// The set pixel with the highest energy.
+    [[nodiscard]] std::size_t findTightestCluster() const
+    {
+        std::size_t result = pixels.size();
+        for (std::size_t i = 0; i < pixels.size(); i++)
+            if (pixels[i] && (result == pixels.size() || energy[i] > energy[result]))
+                result = i;
+        return result;
+    }
+
+    /// The unset pixel with the lowest energy.
+    [[nodiscard]] std::size_t findLargestVoid() const
+    {
+        std::size_t result = pixels.size();
+        for (std::size_t i = 0; i < pixels.size(); i++)
+            if (!pixels[i] && (result == pixels.size() || energy[i] < energy[result]))
+                result = i;
+        return result;
+    }
+};
+
+/// Void-and-cluster threshold matrix of a size, stored row by row. Its initial pattern is drawn from @p seed.
+std::vector<float> generateVoidAndCluster(GLuint size, GLuint seed)
+{
+    const std::size_t pixel_count = static_cast<std::size_t>(size) * size;
+
+    BinaryPattern initial {std::vector<std::uint8_t>(pixel_count, 0), EnergyField(size)};
+
+    // about a tenth of the pixels, at random.
+    const std::size_t initial_count = std::max<std::size_t>(1, pixel_count / 10);
+    std::mt19937 generator {seed};
+    std::uniform_int_distribution<std::size_t> distribution {0, pixel_count - 1};
+
+    for (std::size_t count = 0; count < initial_count;)
+    {
+        const std::size_t index = distribution(generator);
+        if (initial.pixels[index])
+            continue;
+
+        initial.set(index, true);
+        count++;
+    }
+
+    // move pixels from the tightest cluster to the largest void until the pattern is evenly distributed.
+    for (std::size_t i = 0; i < pixel_count; i++)
+    {
+        const std::size_t cluster = initial.findTightestCluster();
+        initial.set(cluster, false);
+
+        const std::size_t void_ = initial.findLargestVoid();
+        initial.set(void_, true);
+
+        if (void_ == cluster)
+            break;
+    }
+
+    std::vector<std::size_t> ranks(pixel_count);
+
+    // the pixels of the initial pattern are ranked by removing them from the tightest cluster first...
+    {
+        BinaryPattern pattern = initial;
+        for (std::size_t rank = initial_count; rank > 0; rank--)
+        {
+            const std::size_t cluster = pattern.findTightestCluster();
+            pattern.set(cluster, false);
+            ranks[cluster] = rank - 1;
+        }
+    }
+
+    // ...and the remaining ones by filling the largest void first.
+    for (std::size_t rank = initial_count; rank < pixel_count; rank++)
+    {
+        const std::size_t void_ = initial.findLargestVoid();
+        initial.set(void_, true);
+        ranks[void_] = rank;
+    }
+
+    std::vector<float> values(pixel_count);
+    for (std::size_t i = 0; i < pixel_count; i++)
+        values[i] = static_cast<float>(ranks[i]) / static_cast<float>(pixel_count);
+
+    return values;
+}
+
+} // namespace
+
+std::vector<float> generateBlueNoise(GLuint size, GLuint seed)
+{
+    if (size == 0)
+        throw std::logic_error("blue noise size must be non-zero");
+
+    // generation takes seconds for large sizes, so each size is only generated once, by whichever thread needs it
+    // first. Pipelines with different seeds then only pay for a copy.
+    static std::mutex cache_mutex;
+    static std::map<GLuint, std::vector<float>> cache;
+
+    std::unique_lock lock {cache_mutex};
+    auto iter = cache.find(size);
+    if (iter == cache.end())
+        iter = cache.emplace(size, generateVoidAndCluster(size, 0)).first;
+    const std::vector<float> &matrix = iter->second;
+
+    // a toroidal shift keeps the matrix tileable and its thresholds evenly spread.
+    std::mt19937 generator {seed};
+    std::uniform_int_distribution<GLuint> distribution {0, size - 1};
+    const GLuint offset_x = distribution(generator);
+    const GLuint offset_y = distribution(generator);
+
+    std::vector<float> values(matrix.size());
+    for (GLuint y = 0; y < size; y++)
+        for (GLuint x = 0; x < size; x++)
+            values[y * size + x] = matrix[((y + offset_y) % size) * size + (x + offset_x) % size];
+
+    return values;
+}
+
+ThresholdTexture::ThresholdTexture(GLuint size, const float *values) : m_size(size)
+{
+    if (size == 0)
+        throw std::logic_error("threshold texture size must be non-zero");
+
+    gl.CreateTextures(GL_TEXTURE_2D, 1, &m_texture);
+    gl.TextureStorage2D(m_texture, 1, GL_R32F, static_cast<GLsizei>(size), static_cast<GLsizei>(size));
+    gl.TextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl.TextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl.TextureSubImage2D(m_texture, 0, 0, 0, static_cast<GLsizei>(size), static_cast<GLsizei>(size), GL_RED, GL_FLOAT,
+                         values);
+}
+
+ThresholdTexture ThresholdTexture::fromSeed(GLuint size, GLuint seed)
+{
+    const auto values = generateBlueNoise(size, seed);
+    return {size, values.data()};
+}
+
+ThresholdTexture::~ThresholdTexture()
+{
+    if (m_texture)
+        gl.DeleteTextures(1, &m_texture);
+}
+
+ThresholdTexture::ThresholdTexture(ThresholdTexture &&other) noexcept
+        : m_texture(std::exchange(other.m_texture, 0)),
+          m_size(std::exchange(other.m_size, 0))
+{}
+
+ThresholdTexture& ThresholdTexture::operator=(ThresholdTexture &&other) noexcept
+{
+    std::swap(m_texture, other.m_texture);
+    std::swap(m_size, other.m_size);
+    return *this;
+}
+
+} // placement
@@ -0,0 +1,147 @@
+#include "work_group_pattern.hpp"
+#include "disk_distribution_generator.hpp"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace placement {
+
+namespace {
+
+/// Same as in the kernels.
+constexpr float diameter = 1.0f;
+
+/// Generate points until there is no room left for another one, so that the distribution has no voids.
+void fillDistribution(DiskDistributionGenerator &generator)
+{
+    try
+    {
+        while (true)
+            (void) generator.generate();
+    }
+    catch (std::runtime_error &)
+    {}
+}
+
+/**
+ * Remove points until @p count of them remain, keeping the others in the same order. The point removed each time is the
+ * one closest to another point of the periodic distribution, so that the remaining ones cover the domain evenly. The
+ * first @p fixed_count points are never removed.
+ */
+std::vector<glm::vec2> subsample(std::vector<glm::vec2> positions, std::size_t count, glm::vec2 bounds,
+                                 std::size_t fixed_count = 0)
+{
+    const auto distance = [&](glm::vec2 p, glm::vec2 q)
+    {
+        const glm::vec2 d = glm::abs(p - q);
+        return glm::length(glm::min(d, bounds - d));
+    };
+
+    while (positions.size() > count)
+    {
+        std::size_t removed_index = 0;
+        float min_distance = std::numeric_limits<float>::infinity();
+        for (std::size_t i = fixed_count; i < positions.size(); i++)
+            for (std::size_t j = 0; j < i; j++)
+                if (const float d = distance(positions[i], positions[j]); d < min_distance)
+                {
+                    min_distance = d;
+                    removed_index = i;
+                }
+
+        positions.erase(positions.begin() + static_cast<std::ptrdiff_t>(removed_index));
+    }
+
+    return positions;
+}
+
+/**
+ * Generate a variation of a periodic work group pattern that can be placed next to it, or next to any other variation.
+ * Points closer than one diameter to the border of the pattern are kept, and the interior is filled again, so points
+ * in different tiles are either shared with the original pattern or at least one diameter away from the border.
+ */
+std::optional<std::vector<glm::vec2>> generatePatternTile(const WorkGroupPattern &pattern, std::uint32_t seed)
+{
+    const auto is_interior = [&](glm::vec2 position)
+    {
+        return glm::all(glm::greaterThanEqual(position, glm::vec2(diameter)))
+               && glm::all(glm::lessThan(position, pattern.scale - diameter));
+    };
+
+    DiskDistributionGenerator generator{diameter, pattern.grid_size};
+    generator.setSeed(seed);
+    generator.setMaxAttempts(100);
+
+    std::vector<glm::vec2> positions;
+    for (const glm::vec2 position: pattern.positions)
+        if (!is_interior(position))
+        {
+            (void) generator.tryInsert(position);
+            positions.emplace_back(position);
+        }
+
+    // points generated near the border are part of the distribution, but not of the tile.
+    const std::size_t border_count = positions.size();
+    fillDistribution(generator);
+    for (const glm::vec2 position : generator.getPositions())
+        if (is_interior(position))
+            positions.push_back(position);
+
+    if (positions.size() < pattern.positions.size())
+        return std::nullopt;
+
+    return subsample(std::move(positions), pattern.positions.size(), pattern.scale, border_count);
+}
+
+} // namespace
+
+WorkGroupPattern generateWorkGroupPattern(std::uint32_t seed, glm::uvec2 pattern_size)
+{
+    const std::size_t candidate_count = pattern_size.x * pattern_size.y;
+
+    // a maximal distribution generated by Bridson's algorithm has about 0.65 points per unit of area, or 0.32 per grid
+    // cell. The pattern is cut from the maximal distribution of the smallest grid that holds enough points, so that it
+    // has as few points as possible to remove, which would leave voids repeated in every work group.
+    constexpr std::uint32_t max_attempts = 8;
+    for (glm::uvec2 grid_size = glm::max(glm::uvec2(glm::vec2(pattern_size) * 1.76f), 1u);; grid_size += 1u)
+        for (std::uint32_t attempt = 0; attempt < max_attempts; attempt++)
+        {
+            const std::uint32_t attempt_seed = seed ^ (0x9e3779b9u * attempt);
+
+            DiskDistributionGenerator generator{diameter, grid_size};
+            generator.setSeed(attempt_seed);
+            generator.setMaxAttempts(100);
+            fillDistribution(generator);
+
+            if (generator.getPositions().size() >= candidate_count)
+                return {generator.getGrid().getBounds(), grid_size,
+                        subsample(generator.getPositions(), candidate_count,
+                                  generator.getGrid().getBounds())};
+        }
+}
+
+std::vector<glm::vec2> generatePatternTiles(const WorkGroupPattern &pattern, std::uint32_t seed,
+                                            std::uint32_t tile_count)
+{
+    // tiles are stored one after another.
+    std::vector<glm::vec2> tiles {pattern.positions};
+    for (std::uint32_t i = 1; i < tile_count; i++)
+    {
+        // a tile may fail to fill up its interior, in which case the original pattern takes its place.
+        constexpr std::uint32_t max_attempts = 32;
+        std::optional<std::vector<glm::vec2>> tile;
+        for (std::uint32_t attempt = 0; attempt < max_attempts && !tile; attempt++)
+            tile = generatePatternTile(pattern, seed ^ (0x9e3779b9u * (i * max_attempts + attempt + 1)));
+
+        const std::vector<glm::vec2> &positions = tile ? *tile : pattern.positions;
+        tiles.insert(tiles.end(), positions.begin(), positions.end());
+    }
+
+    return tiles;
+}
+
+} // placement
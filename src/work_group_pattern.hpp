@@ -0,0 +1,50 @@
+#ifndef PROCEDURALPLACEMENTLIB_WORK_GROUP_PATTERN_HPP
+#define PROCEDURALPLACEMENTLIB_WORK_GROUP_PATTERN_HPP
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace placement {
+
+/// Candidate positions of a work group of the candidate grid, relative to its corner, in footprint units.
+struct WorkGroupPattern
+{
+    /// Size of the work group, which is also the period of the pattern.
+    glm::vec2 scale;
+    /// Size of the DiskDistributionGrid the pattern was generated in, whose bounds are the scale.
+    glm::uvec2 grid_size;
+    /// One position per candidate, stored column by column.
+    std::vector<glm::vec2> positions;
+};
+
+/**
+ * @brief The pattern of the placement kernels for @p seed, with pattern_size.x * pattern_size.y candidates.
+ * The pattern is a periodic Poisson disk distribution that is close to maximal, so that no part of a work group is
+ * left without candidates.
+ */
+[[nodiscard]] WorkGroupPattern generateWorkGroupPattern(std::uint32_t seed, glm::uvec2 pattern_size);
+
+/**
+ * @brief Generate the pattern tiles of a seed, see PlacementPipeline::setPatternTileCount().
+ * @return The positions of @p tile_count patterns, one after another, the first of which is @p pattern itself.
+ */
+[[nodiscard]] std::vector<glm::vec2> generatePatternTiles(const WorkGroupPattern &pattern, std::uint32_t seed,
+                                                          std::uint32_t tile_count);
+
+/// Hash of a work group grid index, which selects its pattern tile. Same as hashGridIndex() in the kernels.
+[[nodiscard]] constexpr std::uint32_t hashGridIndex(glm::uvec2 grid_index)
+{
+    std::uint32_t h = grid_index.x * 0x8da6b343u ^ grid_index.y * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+} // placement
+
+#endif //PROCEDURALPLACEMENTLIB_WORK_GROUP_PATTERN_HPP
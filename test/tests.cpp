@@ -1,9 +1,17 @@
 #include "placement/placement.hpp"
 #include "placement/placement_pipeline.hpp"
+#include "placement/instance_ring_buffer.hpp"
+#include "placement/density_pyramid.hpp"
+#include "placement/threshold_texture.hpp"
+#include "placement/kernel_tuning.hpp"
+#include "placement/kernel/uniform_ring_buffer.hpp"
+#include "placement/cpu/placement_pipeline.hpp"
 
 #include "../src/disk_distribution_generator.hpp"
+#include "../src/work_group_pattern.hpp"
 
 #include "glutils/debug.hpp"
+#include "glutils/error.hpp"
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
@@ -13,8 +21,10 @@
 #include <ostream>
 #include <algorithm>
 #include <map>
-#include <execution>
 #include <thread>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 
 // included here to make it available to catch.hpp
 #include "ostream_operators.hpp"
@@ -257,6 +267,14 @@ bool elementCompare(const placement::Result::Element &l, const placement::Result
            std::make_tuple(r.class_index, r.position.x, r.position.y, r.position.z);
 };
 
+/// Copy all the elements of a result to the host, sorted with elementCompare().
+std::vector<placement::Result::Element> sortResult(const placement::Result &result)
+{
+    auto elements = result.copyAllToHost();
+    std::sort(elements.begin(), elements.end(), elementCompare);
+    return elements;
+}
+
 namespace placement {
 
 bool operator==(const Result::Element &l, const Result::Element &r)
@@ -264,6 +282,38 @@ bool operator==(const Result::Element &l, const Result::Element &r)
 
 } // placement
 
+/// A candidate in the candidate buffer of the separate kernels.
+struct TransientCandidate
+{
+    float density;
+    std::uint32_t class_index;
+
+    bool operator==(const TransientCandidate &other) const
+    { return density == other.density && class_index == other.class_index; }
+};
+
+static_assert(sizeof(TransientCandidate) == placement::GenerationKernel::candidate_size);
+
+std::ostream &operator<<(std::ostream &out, const TransientCandidate &candidate)
+{
+    return out << "{density: " << candidate.density << ", class_index: " << candidate.class_index << "}";
+}
+
+/**
+ * Position of a candidate of the candidate buffer, as generated by the kernels from a single pattern tile, stored
+ * column by column. Candidates are stored work group by work group, row by row, and in the order of the pattern within
+ * a work group.
+ */
+glm::vec2 getCandidatePosition(std::size_t candidate_index, const std::vector<glm::vec2> &pattern,
+                               std::uint32_t grid_width, glm::vec2 work_group_scale, float footprint,
+                               glm::uvec2 work_group_offset = {0u, 0u})
+{
+    const auto work_group_index = static_cast<std::uint32_t>(candidate_index / pattern.size());
+    const glm::uvec2 grid_index = work_group_offset + glm::uvec2(work_group_index % grid_width,
+                                                                 work_group_index / grid_width);
+    return footprint * (pattern[candidate_index % pattern.size()] + glm::vec2(grid_index) * work_group_scale);
+}
+
 // end: Utilities
 
 TEST_CASE("PlacementPipeline", "[pipeline]")
@@ -297,6 +347,18 @@ TEST_CASE("PlacementPipeline", "[pipeline]")
 
         points = result.copyAllToHost();
         REQUIRE(points.empty());
+
+        // degenerate regions, on a work group boundary and within a work group.
+        for (const auto &[lower, upper] : {std::pair{glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 10.0f)},
+                                           std::pair{glm::vec2(0.0f, 0.0f), glm::vec2(10.0f, 0.0f)},
+                                           std::pair{glm::vec2(2.5f, 2.5f), glm::vec2(2.5f, 2.5f)}})
+        {
+            CAPTURE(lower, upper);
+            result = pipeline.computePlacement(world_data, layer_data, lower, upper).readResult();
+            CHECK(result.getNumClasses() == 1);
+            CHECK(result.getElementArrayLength() == 0);
+            CHECK(result.copyAllToHost().empty());
+        }
     }
 
     SECTION("Determinism (simple)")
@@ -454,6 +516,85 @@ TEST_CASE("PlacementPipeline", "[pipeline]")
     }
 }
 
+TEST_CASE("PlacementPipeline (asynchronous construction)", "[pipeline]")
+{
+    WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/black.png"]};
+    const GLuint white_texture = s_texture_loader["assets/textures/grayscale/white.png"];
+    LayerData layer_data{0.01f, {{white_texture, /*scale=*/0.5f}}};
+
+    PlacementPipeline pipeline;
+    const auto expected = pipeline.computePlacement(world_data, layer_data, {0.0f, 0.0f}, {1.0f, 1.0f})
+            .readResult().copyAllToHost();
+
+    KernelConfiguration configuration;
+    configuration.local_size = {16, 16};
+    auto async_pipeline = PlacementPipeline::createAsync(configuration);
+    CHECK(async_pipeline.getKernelConfiguration() == configuration);
+
+    SECTION("Implicit wait")
+    {
+        // settings made before the kernels are ready are applied once they are.
+        async_pipeline.setRandomSeed(1);
+        async_pipeline.setRandomSeed(0);
+    }
+
+    SECTION("Explicit wait")
+    {
+        while (!async_pipeline.isReady())
+            std::this_thread::yield();
+        async_pipeline.waitReady();
+        CHECK(async_pipeline.isReady());
+    }
+
+    const auto result = async_pipeline.computePlacement(world_data, layer_data, {0.0f, 0.0f}, {1.0f, 1.0f})
+            .readResult().copyAllToHost();
+    CHECK(async_pipeline.isReady());
+    CHECK(result.size() == expected.size());
+}
+
+TEST_CASE("PlacementPipeline (shared kernels)", "[pipeline]")
+{
+    WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/black.png"]};
+    const GLuint white_texture = s_texture_loader["assets/textures/grayscale/white.png"];
+    LayerData layer_data{0.02f, {{white_texture, /*scale=*/0.5f}}};
+
+    const auto compute = [&](PlacementPipeline &pipeline)
+    {
+        auto elements = pipeline.computePlacement(world_data, layer_data, {0.0f, 0.0f}, {1.0f, 1.0f})
+                .readResult().copyAllToHost();
+        std::sort(elements.begin(), elements.end(), [](const auto &a, const auto &b)
+        {
+            return std::tie(a.position.x, a.position.y) < std::tie(b.position.x, b.position.y);
+        });
+        return elements;
+    };
+
+    // pipelines with different seeds and pattern tiles, which share the same kernels.
+    PlacementPipeline pipeline_a;
+    PlacementPipeline pipeline_b;
+    pipeline_b.setRandomSeed(1);
+    pipeline_b.setPatternTileCount(4);
+    pipeline_b.setBlueNoiseThresholds(16);
+
+    const auto expected_a = compute(pipeline_a);
+    const auto expected_b = compute(pipeline_b);
+    REQUIRE(expected_a.size() > 0);
+
+    // neither pipeline is affected by the state the other leaves in the kernels.
+    for (int i = 0; i < 2; i++)
+    {
+        CHECK(compute(pipeline_a) == expected_a);
+        CHECK(compute(pipeline_b) == expected_b);
+    }
+
+    // kernels outlive the pipeline that compiled them, as long as another one uses them.
+    {
+        PlacementPipeline pipeline_c;
+        CHECK(compute(pipeline_c) == expected_a);
+    }
+    CHECK(compute(pipeline_a) == expected_a);
+}
+
 TEST_CASE("PlacementPipeline (multiclass)", "[pipeline][multiclass]")
 {
     using namespace placement;
@@ -561,19 +702,12 @@ TEST_CASE("PlacementPipeline (multiclass)", "[pipeline][multiclass]")
 
     SECTION("Determinism")
     {
-        const auto sort_result = [](const Result &result)
-        {
-            auto elements = result.copyAllToHost();
-            std::sort(elements.begin(), elements.end(), elementCompare);
-            return elements;
-        };
-
         auto results_1 = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
         auto results_2 = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
 
-        const auto positions_0 = sort_result(results);
-        const auto positions_1 = sort_result(results_1);
-        const auto positions_2 = sort_result(results_2);
+        const auto positions_0 = sortResult(results);
+        const auto positions_1 = sortResult(results_1);
+        const auto positions_2 = sortResult(results_2);
 
         {
             const auto diffs_01 = findDifferences(positions_0, positions_1);
@@ -587,352 +721,884 @@ TEST_CASE("PlacementPipeline (multiclass)", "[pipeline][multiclass]")
             CHECK(diffs_02.empty());
         }
     }
-}
-
-TEST_CASE("GenerationKernel", "[generation][kernel]")
-{
-    GenerationKernel kernel;
 
-    constexpr auto wg_size = GenerationKernel::work_group_size;
-    constexpr glm::vec2 wg_scale{1.0f};
+    SECTION("Incremental mode")
+    {
+        LayerData edited_layer_data = layer_data;
+        std::reverse(edited_layer_data.densitymaps.begin(), edited_layer_data.densitymaps.end());
 
-    glm::vec2 position_stencil[wg_size.x][wg_size.y];
-    for (auto i = 0u; i < wg_size.x; i++)
-        for (auto j = 0u; j < wg_size.y; j++)
-            position_stencil[i][j] = glm::vec2(i, j) * wg_scale;
+        const auto expected = sortResult(
+                pipeline.computePlacement(world_data, edited_layer_data, lower_bound, upper_bound).readResult());
 
-    constexpr glm::vec3 world_scale{1.0f};
+        pipeline.setIncrementalMode(true);
+        REQUIRE(pipeline.isIncrementalModeEnabled());
 
-    const auto black_texture = s_texture_loader["assets/textures/grayscale/black.png"];
+        // the first call fills the cache, the second one re-evaluates the cached candidates.
+        (void) pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
+        const auto reused = sortResult(
+                pipeline.computePlacement(world_data, edited_layer_data, lower_bound, upper_bound).readResult());
 
-    const uint height_texture_unit = 0;
-    gl.BindTextureUnit(height_texture_unit, black_texture);
+        const auto diffs = findDifferences(expected, reused);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
+    }
 
-    const auto footprint = GENERATE(take(3, random(0.01f, 0.1f)));
-    CAPTURE(footprint);
+    SECTION("Negative densities")
+    {
+        // the first class lowers the accumulated density of every candidate to -1, the second raises it back to 1.
+        const LayerData negative_layer_data {footprint, {{white_texture, -1.f, 0.f, -1.f, 0.f},
+                                                         {white_texture, 2.f, 0.f, 0.f, 2.f}}};
+        const LayerData positive_layer_data {footprint, {{white_texture, 1.f}}};
 
-    const glm::uvec2 wg_count{world_scale / (glm::vec3(wg_scale, 1.0f) * glm::vec3(wg_size))};
+        pipeline.setSingleDispatchThreshold(0);
 
-    const std::size_t candidate_count = wg_count.x * wg_count.y * wg_size.x * wg_size.y;
+        const auto expected = sortResult(
+                pipeline.computePlacement(world_data, positive_layer_data, lower_bound, upper_bound).readResult());
+        REQUIRE(!expected.empty());
 
-    GL::Buffer buffer;
-    const GL::Buffer::Range candidate_range{0, GenerationKernel::getCandidateBufferSizeRequirement({wg_count, 1})};
-    const GL::Buffer::Range world_uv_range{candidate_range.offset + candidate_range.size,
-                                           GenerationKernel::getWorldUVBufferSizeRequirement({wg_count, 1})};
-    const GL::Buffer::Range density_range{world_uv_range.offset + world_uv_range.size,
-                                          GenerationKernel::getDensityBufferMemoryRequirement({wg_count, 1})};
+        const auto check_result = [&](const Result &result)
+        {
+            REQUIRE(result.getIndexOffsets() == std::vector<uint>{0, 0, static_cast<uint>(expected.size())});
 
-    buffer.allocateImmutable(candidate_range.size + world_uv_range.size + density_range.size,
-                             GL::BufferHandle::StorageFlags::map_read);
+            auto elements = result.copyClassToHost(1);
+            for (auto &element : elements)
+                element.class_index = 0;
+            std::sort(elements.begin(), elements.end(), elementCompare);
 
-    constexpr uint candidate_binding_index = 0;
-    constexpr uint world_uv_binding_index = 1;
-    constexpr uint density_binding_index = 2;
+            const auto diffs = findDifferences(expected, elements);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
+        };
 
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, world_uv_binding_index, world_uv_range);
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, density_binding_index, density_range);
+        check_result(pipeline.computePlacement(world_data, negative_layer_data, lower_bound, upper_bound).readResult());
 
-    kernel(wg_count, /*work group index offset*/ {0, 0}, footprint, world_scale,
-           height_texture_unit, candidate_binding_index, world_uv_binding_index, density_binding_index);
-    gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        // cached candidates keep no state of the previous evaluation, whatever the sign of its densities.
+        pipeline.setIncrementalMode(true);
+        (void) pipeline.computePlacement(world_data, negative_layer_data, lower_bound, upper_bound).readResult();
+        check_result(pipeline.computePlacement(world_data, negative_layer_data, lower_bound, upper_bound).readResult());
+    }
 
-    std::vector<Result::Element> candidates;
-    candidates.resize(candidate_count);
-    buffer.read(candidate_range, candidates.data());
+    SECTION("Dirty rectangle update")
+    {
+        LayerData edited_layer_data = layer_data;
+        std::reverse(edited_layer_data.densitymaps.begin(), edited_layer_data.densitymaps.end());
 
-    std::vector<glm::vec2> world_uvs;
-    world_uvs.resize(candidate_count);
-    buffer.read(world_uv_range, world_uvs.data());
+        const auto expected_edited = sortResult(
+                pipeline.computePlacement(world_data, edited_layer_data, lower_bound, upper_bound).readResult());
+        const auto expected_original = sortResult(results);
 
-    std::vector<float> densities;
-    densities.resize(candidate_count);
-    buffer.read(density_range, densities.data());
+        pipeline.setIncrementalMode(true);
+        (void) pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
 
-    SECTION("correctness")
-    {
-        using Candidate = Result::Element;
+        {
+            INFO("An empty dirty rectangle keeps the previous elements");
+            const auto updated = sortResult(pipeline.updatePlacement(world_data, edited_layer_data, lower_bound,
+                                                                      upper_bound, glm::vec2(2.f), glm::vec2(2.f))
+                                                     .readResult());
+            const auto diffs = findDifferences(expected_original, updated);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
+        }
 
         {
-            constexpr uint invalid_index = 0xFFffFFff;
-            INFO("candidate class index must be initialized to " << invalid_index);
-            CHECK(std::all_of(candidates.begin(), candidates.end(),
-                              [=](const Candidate &c)
-                              { return c.class_index == invalid_index; }));
+            INFO("A dirty rectangle covering the region matches a full placement");
+            const auto updated = sortResult(pipeline.updatePlacement(world_data, edited_layer_data, lower_bound,
+                                                                      upper_bound, lower_bound, upper_bound)
+                                                     .readResult());
+            const auto diffs = findDifferences(expected_edited, updated);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
         }
 
         {
-            INFO("density must be initialized to 0.0f");
-            CHECK(std::all_of(densities.begin(), densities.end(), EqualToValue(0.0f)));
+            INFO("A partial dirty rectangle only updates the work groups overlapping it");
+            const glm::vec2 dirty_lower_bound {0.23f, 0.41f};
+            const glm::vec2 dirty_upper_bound {0.58f, 0.77f};
+
+            // the rectangle is not aligned to the work group grid, so it extends to the work groups it overlaps.
+            const glm::vec2 wg_bounds = layer_data.footprint
+                                        * generateWorkGroupPattern(pipeline.getRandomSeed(),
+                                                                   pipeline.getKernelConfiguration().pattern_size)
+                                                  .scale;
+            const glm::vec2 dirty_begin = glm::floor(dirty_lower_bound / wg_bounds);
+            const glm::vec2 dirty_end = glm::ceil(dirty_upper_bound / wg_bounds);
+            REQUIRE(dirty_lower_bound != dirty_begin * wg_bounds);
+            REQUIRE(dirty_upper_bound != dirty_end * wg_bounds);
+
+            const auto is_dirty = [&](const Element &element)
+            {
+                const glm::vec2 grid_index = glm::floor(glm::vec2(element.position) / wg_bounds);
+                return glm::all(glm::greaterThanEqual(grid_index, dirty_begin))
+                       && glm::all(glm::lessThan(grid_index, dirty_end));
+            };
+
+            std::vector<Element> expected;
+            std::copy_if(expected_edited.begin(), expected_edited.end(), std::back_inserter(expected), is_dirty);
+            const std::size_t dirty_count = expected.size();
+            std::copy_if(expected_original.begin(), expected_original.end(), std::back_inserter(expected),
+                         [&](const Element &element) { return !is_dirty(element); });
+            std::sort(expected.begin(), expected.end(), elementCompare);
+
+            // both parts must be non-empty for the test to be meaningful.
+            REQUIRE(dirty_count > 0);
+            REQUIRE(dirty_count < expected.size());
+
+            const auto updated = sortResult(pipeline.updatePlacement(world_data, edited_layer_data, lower_bound,
+                                                                      upper_bound, dirty_lower_bound,
+                                                                      dirty_upper_bound)
+                                                     .readResult());
+            const auto diffs = findDifferences(expected, updated);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
         }
+    }
 
+    SECTION("Height reprojection")
+    {
+        const auto original = results.copyAllToHost();
+        const auto index_offsets = results.getIndexOffsets();
+
+        const WorldData flat_world_data {world_data.scale, white_texture};
+
+        SECTION("Whole result")
         {
-            INFO("uv * world_scale must equal position.xy");
-            CHECK(std::equal(candidates.begin(), candidates.end(), world_uvs.begin(),
-                             [=](const Candidate &c, glm::vec2 uv)
-                             {
-                                 return c.position.x == Approx(uv.x * world_scale.x) &&
-                                        c.position.y == Approx(uv.y * world_scale.y);
-                             }));
+            const auto reprojected = pipeline.reprojectHeights(std::move(results), flat_world_data).readResult();
+            const auto elements = reprojected.copyAllToHost();
+
+            REQUIRE(elements.size() == original.size());
+            CHECK(reprojected.getIndexOffsets() == index_offsets);
+            for (std::size_t i = 0; i < elements.size(); i++)
+            {
+                CAPTURE(i, original[i], elements[i]);
+                CHECK(glm::vec2(elements[i].position) == glm::vec2(original[i].position));
+                CHECK(elements[i].class_index == original[i].class_index);
+                CHECK(elements[i].position.z == Approx(world_data.scale.z));
+            }
         }
 
+        SECTION("Rectangle")
         {
-            INFO("minimum separation equal to footprint");
-            for (auto iter_i = candidates.begin(); iter_i != candidates.end(); iter_i++)
+            const glm::vec2 dirty_lower_bound {0.25f, 0.3f};
+            const glm::vec2 dirty_upper_bound {0.6f, 0.7f};
+
+            const auto reprojected = pipeline.reprojectHeights(std::move(results), flat_world_data,
+                                                               dirty_lower_bound, dirty_upper_bound).readResult();
+            const auto elements = reprojected.copyAllToHost();
+
+            REQUIRE(elements.size() == original.size());
+            CHECK(reprojected.getIndexOffsets() == index_offsets);
+
+            std::size_t inside_count = 0;
+            for (std::size_t i = 0; i < elements.size(); i++)
             {
-                const glm::vec2 pos_i = iter_i->position;
-                for (auto iter_j = candidates.begin(); iter_j != iter_i; iter_j++)
-                {
-                    const glm::vec2 pos_j = iter_j->position;
-                    REQUIRE(glm::distance(pos_i, pos_j) > footprint);
-                }
+                const glm::vec2 position {original[i].position};
+                const bool inside = glm::all(glm::greaterThanEqual(position, dirty_lower_bound))
+                                    && glm::all(glm::lessThan(position, dirty_upper_bound));
+                inside_count += inside;
+
+                CAPTURE(i, inside, original[i], elements[i]);
+                CHECK(glm::vec2(elements[i].position) == position);
+                CHECK(elements[i].class_index == original[i].class_index);
+                if (inside)
+                    CHECK(elements[i].position.z == Approx(world_data.scale.z));
+                else
+                    CHECK(elements[i].position.z == original[i].position.z);
             }
+
+            // the rectangle must split the result for the test to be meaningful.
+            CHECK(inside_count > 0);
+            CHECK(inside_count < elements.size());
         }
     }
 
-    SECTION("determinism")
+    SECTION("Memory budget")
     {
-        kernel(wg_count, /*work group index offest*/ {0, 0}, footprint, world_scale,
-               height_texture_unit, candidate_binding_index, world_uv_binding_index, density_binding_index);
-        gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        const auto expected = sortResult(results);
 
-        auto candidates_duplicate = candidates;
-        auto world_uvs_duplicate = world_uvs;
-        auto densities_duplicate = densities;
+        // small enough to split the region into several tiles.
+        pipeline.setMemoryBudget(4 * 64 * 36);
+        REQUIRE(pipeline.getMemoryBudget() == 4 * 64 * 36);
+        CHECK_THROWS_AS(pipeline.setMemoryBudget(1), std::logic_error);
 
-        buffer.read(candidate_range, candidates_duplicate.data());
-        buffer.read(world_uv_range, world_uvs_duplicate.data());
-        buffer.read(density_range, densities_duplicate.data());
+        const auto split = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
+        CHECK(split.getIndexOffsets() == results.getIndexOffsets());
 
-        CHECK(candidates == candidates_duplicate);
-        CHECK(world_uvs == world_uvs_duplicate);
-        CHECK(densities == densities_duplicate);
-    }
-}
+        const auto elements = sortResult(split);
 
-TEST_CASE("EvaluationKernel", "[evaluation][kernel]")
-{
-    const uint wg_count_x = GENERATE(take(3, random(1, 4)));
-    const uint wg_count_y = GENERATE(take(3, random(1, 4)));
-    const glm::uvec2 wg_count = {wg_count_x, wg_count_y};
-    CAPTURE(wg_count);
+        const auto diffs = findDifferences(expected, elements);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
 
-    const glm::vec2 world_boundaries{10.f};
+        // classes must remain sorted after stitching.
+        for (uint i = 0; i < split.getNumClasses(); i++)
+            for (const auto &element : split.copyClassToHost(i))
+                CHECK(element.class_index == i);
+    }
 
-    const float lower_bound_x = GENERATE(take(1, random(0.f, 10.f)));
-    const float lower_bound_y = GENERATE(take(1, random(0.f, 10.f)));
-    const float placement_area_x = GENERATE(take(1, random(0.f, 10.f)));
-    const float placement_area_y = GENERATE(take(1, random(0.f, 10.f)));
+    SECTION("Single dispatch")
+    {
+        // small enough for a single work group.
+        const glm::vec2 small_lower_bound {0.2f, 0.3f};
+        const glm::vec2 small_upper_bound {0.45f, 0.5f};
 
-    const glm::vec2 lower_bound{lower_bound_x, lower_bound_y};
-    const glm::vec2 upper_bound = lower_bound + glm::vec2{placement_area_x, placement_area_y};
+        // opt-in, since it needs more texture units.
+        CHECK(PlacementPipeline().getSingleDispatchThreshold() == 0);
 
-    const GLsizeiptr candidate_count_x = wg_count_x * EvaluationKernel::work_group_size.x;
-    const GLsizeiptr candidate_count_y = wg_count_y * EvaluationKernel::work_group_size.y;
-    const GLsizeiptr candidate_count = candidate_count_x * candidate_count_y;
+        pipeline.setSingleDispatchThreshold(0);
+        CHECK(pipeline.getSingleDispatchThreshold() == 0);
+        const auto separate = pipeline.computePlacement(world_data, layer_data, small_lower_bound, small_upper_bound)
+                .readResult();
 
-    EvaluationKernel kernel;
+        pipeline.setSingleDispatchThreshold(FusedPlacementKernel::max_candidate_count);
+        CHECK_THROWS_AS(pipeline.setSingleDispatchThreshold(FusedPlacementKernel::max_candidate_count + 1),
+                        std::logic_error);
+        const auto single = pipeline.computePlacement(world_data, layer_data, small_lower_bound, small_upper_bound)
+                .readResult();
 
-    std::vector<Result::Element> candidates;
-    std::vector<Result::Element> expected_result;
-    std::vector<glm::vec2> world_uvs;
-    std::vector<float> densities;
+        REQUIRE(separate.getElementArrayLength() > 0);
+        CHECK(single.getIndexOffsets() == separate.getIndexOffsets());
 
-    candidates.reserve(candidate_count);
-    expected_result.reserve(candidate_count);
-    world_uvs.reserve(candidate_count);
-    densities.reserve(candidate_count);
+        const auto expected = sortResult(separate);
+        const auto elements = sortResult(single);
 
-    constexpr uint invalid_index = 0xFFffFFff;
+        const auto diffs = findDifferences(expected, elements);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
 
-    for (std::size_t i = 0; i < candidate_count_x; i++)
-    {
-        const float world_u = static_cast<float>(i) / static_cast<float>(candidate_count_x);
-        const float position_x = world_u * world_boundaries.x;
+        for (uint i = 0; i < single.getNumClasses(); i++)
+            for (const auto &element : single.copyClassToHost(i))
+                CHECK(element.class_index == i);
+    }
 
-        for (std::size_t j = 0; j < candidate_count_y; j++)
+    SECTION("Packed density maps")
+    {
+        // the same densities as the layer, one class per channel of a single texture.
+        GLuint packed_texture;
+        gl.CreateTextures(GL_TEXTURE_2D, 1, &packed_texture);
+        gl.TextureStorage2D(packed_texture, 1, GL_RGBA32F, 4, 4);
+        gl.TextureParameteri(packed_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.TextureParameteri(packed_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        const std::vector<glm::vec4> texels (16, glm::vec4(.4f, .3f, .2f, .1f));
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        gl.TextureSubImage2D(packed_texture, 0, 0, 0, 4, 4, GL_RGBA, GL_FLOAT, texels.data());
+
+        using Channel = DensityMap::Channel;
+        LayerData packed_layer_data {footprint, {}};
+        for (const Channel channel : {Channel::red, Channel::green, Channel::blue, Channel::alpha})
         {
-            const float world_v = static_cast<float>(j) / static_cast<float>(candidate_count_y);
-            const float position_y = world_v * world_boundaries.y;
+            DensityMap density_map {packed_texture};
+            density_map.channel = channel;
+            packed_layer_data.densitymaps.push_back(density_map);
+        }
 
-            Result::Element new_candidate{glm::vec3(position_x, position_y, 0.f), invalid_index};
+        const auto packed = pipeline.computePlacement(world_data, packed_layer_data, lower_bound, upper_bound)
+                .readResult();
+        CHECK(packed.getIndexOffsets() == results.getIndexOffsets());
+        CHECK(sortResult(packed) == sortResult(results));
 
-            candidates.push_back(new_candidate);
-            world_uvs.emplace_back(world_u, world_v);
-            densities.emplace_back(0.0f);
+        // the single dispatch path reads the packed texture as well.
+        const glm::vec2 small_lower_bound {0.2f, 0.3f};
+        const glm::vec2 small_upper_bound {0.45f, 0.5f};
 
-            const bool inside_bounds = glm::all(glm::greaterThanEqual(glm::vec2(new_candidate.position), lower_bound))
-                                       && glm::all(glm::lessThan(glm::vec2(new_candidate.position), upper_bound));
+        pipeline.setSingleDispatchThreshold(0);
+        const auto separate = pipeline.computePlacement(world_data, layer_data, small_lower_bound, small_upper_bound)
+                .readResult();
 
-            if (inside_bounds)
-                new_candidate.class_index = 0;
+        pipeline.setSingleDispatchThreshold(FusedPlacementKernel::max_candidate_count);
+        const auto single = pipeline.computePlacement(world_data, packed_layer_data, small_lower_bound,
+                                                      small_upper_bound).readResult();
 
-            expected_result.emplace_back(new_candidate);
+        REQUIRE(separate.getElementArrayLength() > 0);
+        CHECK(single.getIndexOffsets() == separate.getIndexOffsets());
+        CHECK(sortResult(single) == sortResult(separate));
+
+        // each channel has a pyramid of its own.
+        for (uint i = 0; i < packed_layer_data.densitymaps.size(); i++)
+        {
+            const DensityMap &density_map = packed_layer_data.densitymaps[i];
+            const auto pyramid = DensityPyramid::fromTexture(packed_texture, density_map.channel);
+            CHECK(pyramid.getRange({0.0f, 0.0f}, {1.0f, 1.0f}) == glm::vec2(texels[0][i]));
+            pipeline.setDensityPyramid(packed_texture, pyramid, density_map.channel);
         }
+
+        CHECK(sortResult(pipeline.computePlacement(world_data, packed_layer_data, lower_bound, upper_bound)
+                                  .readResult()) == sortResult(results));
+
+        pipeline.removeDensityPyramid(packed_texture);
+        gl.DeleteTextures(1, &packed_texture);
     }
 
-    constexpr GLsizeiptr candidate_size = sizeof(Result::Element);
-    constexpr GLsizeiptr world_uv_size = sizeof(glm::vec2);
-    constexpr GLsizeiptr density_size = sizeof(float);
+    SECTION("Seed override")
+    {
+        constexpr uint other_seed = 7;
 
-    const GL::Buffer buffer;
-    const GL::Buffer::Range candidate_range{0, candidate_size * candidate_count};
-    const GL::Buffer::Range world_uv_range{candidate_range.size, world_uv_size * candidate_count};
-    const GL::Buffer::Range density_range{candidate_range.size + world_uv_range.size, density_size * candidate_count};
+        const auto original = sortResult(results);
 
-    buffer.allocateImmutable(candidate_range.size + world_uv_range.size + density_range.size,
-                             GL::Buffer::StorageFlags::dynamic_storage | GL::Buffer::StorageFlags::map_read);
+        const auto overridden = sortResult(
+                pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound, other_seed).readResult());
+        CHECK(pipeline.getRandomSeed() == 0);
 
-    buffer.write(candidate_range, candidates.data());
-    buffer.write(world_uv_range, world_uvs.data());
-    buffer.write(density_range, densities.data());
+        pipeline.setRandomSeed(other_seed);
+        const auto reseeded = sortResult(
+                pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult());
+        CHECK(overridden == reseeded);
+        CHECK(overridden != original);
 
-    constexpr uint candidate_binding_index = 0;
-    constexpr uint world_uv_binding_index = 1;
-    constexpr uint density_binding_index = 2;
+        // going back to the first seed uses its cached pattern.
+        pipeline.setRandomSeed(0);
+        const auto restored = sortResult(
+                pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult());
+        CHECK(restored == original);
+    }
 
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, world_uv_binding_index, world_uv_range);
-    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, density_binding_index, density_range);
+    SECTION("Pattern tiles")
+    {
+        pipeline.setPatternTileCount(8);
+        REQUIRE(pipeline.getPatternTileCount() == 8);
+        CHECK_THROWS_AS(pipeline.setPatternTileCount(0), std::logic_error);
 
-    constexpr uint density_tex_unit = 0;
-    const GLuint density_texture = s_texture_loader["assets/textures/grayscale/white.png"];
-    gl.BindTextureUnit(density_tex_unit, density_texture);
+        const auto tiled = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
+        const auto elements = tiled.copyAllToHost();
 
-    kernel(wg_count, {0, 0}, /*class index*/ 0, lower_bound, upper_bound, density_tex_unit, DensityMap(),
-           candidate_binding_index, world_uv_binding_index, density_binding_index);
-    gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        auto original = results.copyAllToHost();
+        auto sorted = elements;
+        std::sort(original.begin(), original.end(), elementCompare);
+        std::sort(sorted.begin(), sorted.end(), elementCompare);
+        CHECK(sorted != original);
+
+        // the densities add up to one, so every candidate takes a class, and only those along the borders of the
+        // region change with the tiles. Each class still takes its share of them.
+        REQUIRE(!elements.empty());
+        CHECK(elements.size() == Approx(results.getElementArrayLength()).epsilon(0.02));
+        for (uint i = 0; i < num_classes; i++)
+        {
+            CAPTURE(i);
+            CHECK(tiled.getClassElementCount(i)
+                  == Approx(layer_data.densitymaps[i].scale * elements.size()).epsilon(0.05));
+        }
 
+        // the footprint must be respected across the borders between different tiles.
+        for (auto p = elements.begin(); p != elements.end(); p++)
+            for (auto q = elements.begin(); q != p; q++)
+                if (glm::distance(glm::vec2(p->position), glm::vec2(q->position)) <= footprint * 0.999f)
+                {
+                    CAPTURE(*p, *q);
+                    FAIL_CHECK("elements closer than the footprint");
+                }
+    }
+
+    SECTION("Kernel configuration")
     {
-        INFO("Candidates");
+        const auto original = sortResult(results);
 
-        auto mapped_ptr = static_cast<const Result::Element *>(buffer.mapRange(candidate_range,
-                                                                               GL::Buffer::AccessFlags::read));
-        std::vector<Result::Element> computed_result{mapped_ptr, mapped_ptr + candidate_count};
-        buffer.unmap();
+        CHECK_THROWS_AS(pipeline.setKernelConfiguration({{8, 8}, {8, 4}}), std::logic_error);
+        CHECK(pipeline.getKernelConfiguration() == KernelConfiguration{});
 
-        std::vector<Difference<Result::Element>> differences;
+        // the local size must not affect the results.
+        for (const glm::uvec2 local_size : KernelConfiguration::supported_sizes)
+        {
+            CAPTURE(local_size);
+            pipeline.setKernelConfiguration({KernelConfiguration::default_pattern_size, local_size});
+            CHECK(sortResult(pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult())
+                  == original);
+        }
 
-        for (std::size_t i = 0; i < candidate_count; i++)
+        pipeline.setKernelConfiguration({{16, 16}, {8, 8}});
+        REQUIRE(pipeline.getKernelConfiguration().pattern_size == glm::uvec2(16, 16));
+
+        const auto elements = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult()
+                .copyAllToHost();
+        CHECK(!elements.empty());
+
+        for (auto p = elements.begin(); p != elements.end(); p++)
         {
-            if (expected_result[i].position == computed_result[i].position
-                && expected_result[i].class_index == computed_result[i].class_index)
-                continue;
+            CHECK(glm::all(glm::greaterThanEqual(glm::vec2(p->position), lower_bound)));
+            CHECK(glm::all(glm::lessThan(glm::vec2(p->position), upper_bound)));
 
-            differences.emplace_back(i, expected_result[i], computed_result[i]);
+            for (auto q = elements.begin(); q != p; q++)
+                if (glm::distance(glm::vec2(p->position), glm::vec2(q->position)) <= footprint * 0.999f)
+                {
+                    CAPTURE(*p, *q);
+                    FAIL_CHECK("elements closer than the footprint");
+                }
         }
 
-        CAPTURE(lower_bound, upper_bound, differences);
-        CHECK(differences.empty());
+        // switching back to a compiled configuration gives the same results as before.
+        pipeline.setKernelConfiguration({});
+        CHECK(sortResult(pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult())
+              == original);
     }
 
+    SECTION("Footprint filtering")
     {
-        INFO("Densities");
+        PlacementPipeline::generateDensityMipmaps(white_texture);
 
-        auto mapped_ptr = static_cast<const float *>(buffer.mapRange(density_range, GL::Buffer::AccessFlags::read));
-        std::vector<float> computed_densities{mapped_ptr, mapped_ptr + candidate_count};
-        buffer.unmap();
+        pipeline.setFootprintFiltering(true);
+        REQUIRE(pipeline.isFootprintFilteringEnabled());
 
-        std::vector<Difference<float>> differences;
+        // all the mip levels of a constant texture are equal, so filtering must not change the result.
+        const auto filtered = pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult();
+        CHECK(filtered.getIndexOffsets() == results.getIndexOffsets());
 
-        for (std::size_t i = 0; i < candidate_count; i++)
-        {
-            if (computed_densities[i] != 1.0f)
-                differences.emplace_back(i, computed_densities[i], 1.0f);
-        }
+        const auto expected = sortResult(results);
+        const auto elements = sortResult(filtered);
 
-        CAPTURE(differences);
-        CHECK(differences.empty());
+        const auto diffs = findDifferences(expected, elements);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
+
+        GLuint single_level_texture;
+        gl.CreateTextures(GL_TEXTURE_2D, 1, &single_level_texture);
+        gl.TextureStorage2D(single_level_texture, 1, GL_R8, 4, 4);
+        CHECK_THROWS_AS(PlacementPipeline::generateDensityMipmaps(single_level_texture), std::logic_error);
+        gl.DeleteTextures(1, &single_level_texture);
     }
 }
 
-/**
- * This test dispatches the indexation kernel with a few hand-picked input arrays and multiple randomly generated ones,
- * checking that the retrieved indices have the expected values.
- */
-TEST_CASE("IndexationKernel", "[indexation][kernel]")
+TEST_CASE("ComputeShaderProgram (asynchronous compilation)", "[kernel]")
 {
-    using Indices = std::vector<int>;
-    const auto class_indices = GENERATE(
-            Indices{-1}, Indices{0},
-            Indices{-1, -1}, Indices{-1, 0}, Indices{0, -1}, Indices{0, 0},
-            take(3, chunk(10, random(-1, 1))),
-            take(3, chunk(64, random(-1, 3))),
-            take(3, chunk(333, random(-1, 5))),
-            take(3, chunk(1024, random(-1, 7))),
-            take(3, chunk(15000, random(-1, 10))));
-
-    using Candidate = Result::Element;
+    const std::string source = "#version 450 core\n"
+                               "layout(local_size_x = 1) in;\n"
+                               "void main() {}\n";
+
+    const auto program = ComputeShaderProgram::compileAsync(source);
+    while (!program.isReady())
+        std::this_thread::yield();
+    CHECK_NOTHROW(program.waitReady());
+
+    // errors are only reported when waiting.
+    const auto invalid_program = ComputeShaderProgram::compileAsync(source + "syntax error\n");
+    CHECK_THROWS_AS(invalid_program.waitReady(), GL::GLError);
+    CHECK(invalid_program.isReady());
+
+    // and again on every later use, rather than leaving a program that was never linked.
+    CHECK_THROWS_AS(invalid_program.waitReady(), GL::GLError);
+    CHECK_THROWS_AS(invalid_program.getResourceIndex(ComputeShaderProgram::Interface::uniform, "u_value"),
+                    GL::GLError);
+    CHECK_THROWS_AS(ComputeShaderProgram(source + "syntax error\n"), GL::GLError);
+}
 
-    std::vector<Candidate> candidates;
+TEST_CASE("Program binary cache", "[kernel]")
+{
+    const auto cache_directory = std::filesystem::temp_directory_path() / "pplib_program_binary_test";
+    std::filesystem::remove_all(cache_directory);
+    ComputeShaderProgram::setBinaryCacheDirectory(cache_directory);
 
-    constexpr int invalid_index = -1;
+    constexpr const char *source = "#version 450 core\n"
+                                   "layout(local_size_x = 1) in;\n"
+                                   "layout(std430, binding = 0) buffer Output { uint value; };\n"
+                                   "void main() { value = 42u; }\n";
 
-    std::vector<unsigned int> expected_class_counts;
+    CHECK_FALSE(ComputeShaderProgram(source).isLoadedFromBinary());
 
-    for (auto &class_index: class_indices)
+    GLint format_count = 0;
+    gl.GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (format_count > 0)
     {
-        candidates.emplace_back(Candidate{glm::vec3(0.0f), static_cast<uint>(class_index)});
+        CHECK(ComputeShaderProgram(source).isLoadedFromBinary());
+
+        // a different source misses the cache.
+        const std::string other_source = std::string(source) + "// comment\n";
+        CHECK_FALSE(ComputeShaderProgram(other_source).isLoadedFromBinary());
+
+        // corrupted binaries are compiled again.
+        for (const auto &entry : std::filesystem::directory_iterator(cache_directory))
+            std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "garbage";
+        CHECK_FALSE(ComputeShaderProgram(source).isLoadedFromBinary());
+        CHECK(ComputeShaderProgram(source).isLoadedFromBinary());
+
+        // the loaded program works.
+        ComputeShaderProgram program {source};
+        GL::Buffer buffer;
+        buffer.allocateImmutable(sizeof(GLuint), GL::Buffer::StorageFlags::none);
+        buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, 0, {0, sizeof(GLuint)});
+        program.dispatch({1, 1, 1});
+        gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
-        if (class_index == invalid_index)
-            continue;
+        GLuint value = 0;
+        buffer.read({0, sizeof(GLuint)}, &value);
+        CHECK(value == 42u);
+    }
 
-        if (class_index >= expected_class_counts.size())
-            expected_class_counts.resize(class_index + 1);
+    ComputeShaderProgram::setBinaryCacheDirectory({});
+    CHECK_FALSE(ComputeShaderProgram(source).isLoadedFromBinary());
+    std::filesystem::remove_all(cache_directory);
+}
 
-        expected_class_counts[class_index]++;
-    }
+TEST_CASE("GenerationKernel", "[generation][kernel]")
+{
+    GenerationKernel kernel;
 
-    const uint expected_total_count = std::accumulate(expected_class_counts.begin(), expected_class_counts.end(), 0u);
+    constexpr auto wg_size = KernelConfiguration::default_pattern_size;
+    constexpr glm::vec2 wg_scale{1.0f};
+    const glm::vec2 wg_bounds = wg_scale * glm::vec2(wg_size);
 
-    CAPTURE(class_indices);
+    std::vector<glm::vec2> position_stencil;
+    for (auto i = 0u; i < wg_size.x; i++)
+        for (auto j = 0u; j < wg_size.y; j++)
+            position_stencil.push_back(glm::vec2(i, j) * wg_scale);
 
-    uint computed_total_count = 0;
-    std::vector<uint> computed_class_counts;
-    computed_class_counts.resize(expected_class_counts.size());
+    // a single pattern tile, shared by every work group.
+    constexpr uint pattern_tile_binding_index = 1;
+    const auto pattern_tile_size = static_cast<GLsizeiptr>(position_stencil.size() * sizeof(glm::vec2));
+    GL::Buffer pattern_tile_buffer;
+    pattern_tile_buffer.allocateImmutable(pattern_tile_size, GL::Buffer::StorageFlags::none, position_stencil.data());
+    pattern_tile_buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, pattern_tile_binding_index,
+                                  {0, pattern_tile_size});
 
-    const GLsizeiptr class_count = expected_class_counts.size();
-    const GLsizeiptr candidate_count = candidates.size();
+    CHECK_THROWS_AS(kernel.setPatternTiles(pattern_tile_binding_index, 0), std::logic_error);
+    kernel.setPatternTiles(pattern_tile_binding_index, 1);
+    kernel.setWorkGroupPatternBoundaries(wg_bounds);
 
-    CAPTURE(class_count, candidate_count);
+    constexpr glm::vec3 world_scale{1.0f};
 
-    constexpr GLsizeiptr candidate_size = sizeof(Candidate);
-    constexpr GLsizeiptr uint_size = sizeof(GLuint);
+    const auto footprint = GENERATE(take(3, random(0.01f, 0.1f)));
+    CAPTURE(footprint);
 
-    GL::Buffer buffer;
-    const GL::BufferHandle::Range candidate_range{0, candidate_count * candidate_size};
-    const GL::BufferHandle::Range index_range{candidate_range.size, candidate_count * uint_size};
-    const GL::BufferHandle::Range count_range{index_range.offset + index_range.size, class_count * uint_size};
+    const glm::uvec2 wg_count {glm::ceil(glm::vec2(world_scale) / (footprint * wg_bounds))};
 
-    buffer.allocateImmutable(candidate_range.size + index_range.size + count_range.size,
-                             GL::BufferHandle::StorageFlags::dynamic_storage);
+    const std::size_t candidate_count = wg_count.x * wg_count.y * wg_size.x * wg_size.y;
 
-    buffer.write(count_range, computed_class_counts.data()); // initialize counts
-    buffer.write(candidate_range, candidates.data()); // initialize candidates
+    GL::Buffer buffer;
+    const GL::Buffer::Range candidate_range{0, kernel.getCandidateBufferSizeRequirement({wg_count, 1})};
+    REQUIRE(candidate_range.size == candidate_count * GenerationKernel::candidate_size);
 
-    constexpr uint candidate_binding_index = 0;
-    constexpr uint index_binding_index = 1;
-    constexpr uint count_binding_index = 2;
+    buffer.allocateImmutable(candidate_range.size, GL::BufferHandle::StorageFlags::map_read);
 
-    IndexationKernel kernel;
+    constexpr uint candidate_binding_index = 0;
 
-    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
-    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, index_binding_index, index_range);
-    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, count_binding_index, count_range);
+    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
 
-    const auto wg_count = IndexationKernel::calculateNumWorkGroups(candidate_count);
+    const glm::vec2 lower_bound {0.0f};
+    const glm::vec2 upper_bound {world_scale};
 
-    kernel(wg_count, candidate_binding_index, count_binding_index, index_binding_index);
+    kernel(wg_count, /*work group index offset*/ {0, 0}, footprint, lower_bound, upper_bound, candidate_binding_index);
     gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
-    buffer.read(count_range, computed_class_counts.data());
+    std::vector<TransientCandidate> candidates;
+    candidates.resize(candidate_count);
+    buffer.read(candidate_range, candidates.data());
 
-    CHECK(computed_class_counts == expected_class_counts);
+    const auto get_position = [&](std::size_t i)
+    {
+        return getCandidatePosition(i, position_stencil, wg_count.x, wg_bounds, footprint);
+    };
 
-    computed_total_count = std::accumulate(computed_class_counts.begin(), computed_class_counts.end(), 0u);
-    CHECK(computed_total_count == expected_total_count);
+    SECTION("correctness")
+    {
+        {
+            INFO("candidate class index must be initialized to " << 0xFFffFFff << " within the bounds");
+            for (std::size_t i = 0; i < candidates.size(); i++)
+            {
+                const glm::vec2 position = get_position(i);
+                const bool in_bounds = glm::all(glm::greaterThanEqual(position, lower_bound))
+                                       && glm::all(glm::lessThan(position, upper_bound));
 
-    std::vector<int> computed_indices(class_indices.size());
+                CAPTURE(i, position);
+                CHECK(candidates[i].class_index == (in_bounds ? -1u : GenerationKernel::culled_class_index));
+            }
+        }
+
+        {
+            INFO("density must be initialized to 0.0f");
+            CHECK(std::all_of(candidates.begin(), candidates.end(),
+                              [](const TransientCandidate &c)
+                              { return c.density == 0.0f; }));
+        }
+    }
+
+    SECTION("determinism")
+    {
+        kernel(wg_count, /*work group index offest*/ {0, 0}, footprint, lower_bound, upper_bound,
+               candidate_binding_index);
+        gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        auto candidates_duplicate = candidates;
+
+        buffer.read(candidate_range, candidates_duplicate.data());
+
+        CHECK(candidates == candidates_duplicate);
+    }
+
+    SECTION("culling")
+    {
+        const glm::vec2 culling_lower_bound = upper_bound * 0.25f;
+        const glm::vec2 culling_upper_bound = upper_bound * 0.6f;
+
+        kernel(wg_count, /*work group index offest*/ {0, 0}, footprint, culling_lower_bound, culling_upper_bound,
+               candidate_binding_index);
+        gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        auto culled_candidates = candidates;
+        buffer.read(candidate_range, culled_candidates.data());
+
+        for (std::size_t i = 0; i < culled_candidates.size(); i++)
+        {
+            const glm::vec2 position = get_position(i);
+            const bool in_bounds = glm::all(glm::greaterThanEqual(position, culling_lower_bound))
+                                   && glm::all(glm::lessThan(position, culling_upper_bound));
+
+            CAPTURE(i, position);
+            CHECK(culled_candidates[i].density == 0.0f);
+            CHECK(culled_candidates[i].class_index == (in_bounds ? -1u : GenerationKernel::culled_class_index));
+        }
+    }
+
+    SECTION("local size")
+    {
+        const auto expected = candidates;
+
+        for (const glm::uvec2 local_size : KernelConfiguration::supported_sizes)
+        {
+            CAPTURE(local_size);
+
+            GenerationKernel local_size_kernel {{wg_size, local_size}};
+            local_size_kernel.setPatternTiles(pattern_tile_binding_index, 1);
+            local_size_kernel.setWorkGroupPatternBoundaries(wg_bounds);
+
+            gl.ClearNamedBufferData(buffer.getName(), GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            local_size_kernel(wg_count, {0, 0}, footprint, lower_bound, upper_bound, candidate_binding_index);
+            gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+            auto computed = candidates;
+            buffer.read(candidate_range, computed.data());
+            CHECK(computed == expected);
+        }
+    }
+}
+
+TEST_CASE("EvaluationKernel", "[evaluation][kernel]")
+{
+    const uint wg_count_x = GENERATE(take(3, random(1, 4)));
+    const uint wg_count_y = GENERATE(take(3, random(1, 4)));
+    const glm::uvec2 wg_count = {wg_count_x, wg_count_y};
+    CAPTURE(wg_count);
+
+    const glm::vec2 world_boundaries{10.f};
+
+    const float lower_bound_x = GENERATE(take(1, random(0.f, 10.f)));
+    const float lower_bound_y = GENERATE(take(1, random(0.f, 10.f)));
+    const float placement_area_x = GENERATE(take(1, random(0.f, 10.f)));
+    const float placement_area_y = GENERATE(take(1, random(0.f, 10.f)));
+
+    const glm::vec2 lower_bound{lower_bound_x, lower_bound_y};
+    const glm::vec2 upper_bound = lower_bound + glm::vec2{placement_area_x, placement_area_y};
+
+    constexpr auto wg_size = KernelConfiguration::default_pattern_size;
+    const GLsizeiptr candidate_count_x = wg_count_x * wg_size.x;
+    const GLsizeiptr candidate_count_y = wg_count_y * wg_size.y;
+    const GLsizeiptr candidate_count = candidate_count_x * candidate_count_y;
+
+    // a regular grid of candidates, one footprint apart, spanning the world along x.
+    const float footprint = world_boundaries.x / static_cast<float>(candidate_count_x);
+    const glm::vec2 wg_bounds {wg_size};
+
+    std::vector<glm::vec2> pattern;
+    for (uint i = 0; i < wg_size.x; i++)
+        for (uint j = 0; j < wg_size.y; j++)
+            pattern.emplace_back(i, j);
+
+    constexpr uint pattern_tile_binding_index = 1;
+    const auto pattern_tile_size = static_cast<GLsizeiptr>(pattern.size() * sizeof(glm::vec2));
+    GL::Buffer pattern_tile_buffer;
+    pattern_tile_buffer.allocateImmutable(pattern_tile_size, GL::Buffer::StorageFlags::none, pattern.data());
+    pattern_tile_buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, pattern_tile_binding_index,
+                                  {0, pattern_tile_size});
+
+    EvaluationKernel kernel;
+    kernel.setPatternTiles(pattern_tile_binding_index, 1);
+    kernel.setWorkGroupPatternBoundaries(wg_bounds);
+
+    constexpr uint invalid_index = 0xFFffFFff;
+
+    const std::vector<TransientCandidate> candidates (candidate_count, {0.0f, invalid_index});
+    std::vector<TransientCandidate> expected_result;
+    expected_result.reserve(candidate_count);
+
+    for (std::size_t i = 0; i < candidate_count; i++)
+    {
+        const glm::vec2 position = getCandidatePosition(i, pattern, wg_count_x, wg_bounds, footprint);
+        const bool inside_bounds = glm::all(glm::greaterThanEqual(position, lower_bound))
+                                   && glm::all(glm::lessThan(position, upper_bound));
+
+        // the density of white density maps is accumulated by all the candidates.
+        expected_result.push_back({1.0f, inside_bounds ? 0u : invalid_index});
+    }
+
+    constexpr GLsizeiptr candidate_size = sizeof(TransientCandidate);
+
+    const GL::Buffer buffer;
+    const GL::Buffer::Range candidate_range{0, candidate_size * candidate_count};
+
+    buffer.allocateImmutable(candidate_range.size,
+                             GL::Buffer::StorageFlags::dynamic_storage | GL::Buffer::StorageFlags::map_read);
+
+    buffer.write(candidate_range, candidates.data());
+
+    constexpr uint candidate_binding_index = 0;
+
+    buffer.bindRange(GL::Buffer::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
+
+    constexpr uint density_tex_unit = 0;
+    const GLuint density_texture = s_texture_loader["assets/textures/grayscale/white.png"];
+    gl.BindTextureUnit(density_tex_unit, density_texture);
+
+    kernel(wg_count, {0, 0}, footprint, /*class index*/ 0, lower_bound, upper_bound, world_boundaries,
+           density_tex_unit, DensityMap(), candidate_binding_index);
+    gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    auto mapped_ptr = static_cast<const TransientCandidate *>(buffer.mapRange(candidate_range,
+                                                                              GL::Buffer::AccessFlags::read));
+    std::vector<TransientCandidate> computed_result{mapped_ptr, mapped_ptr + candidate_count};
+    buffer.unmap();
+
+    {
+        INFO("Candidates");
+
+        std::vector<Difference<std::uint32_t>> differences;
+
+        for (std::size_t i = 0; i < candidate_count; i++)
+            if (expected_result[i].class_index != computed_result[i].class_index)
+                differences.emplace_back(i, expected_result[i].class_index, computed_result[i].class_index);
+
+        CAPTURE(lower_bound, upper_bound, differences);
+        CHECK(differences.empty());
+    }
+
+    {
+        INFO("Densities");
+
+        std::vector<Difference<float>> differences;
+
+        for (std::size_t i = 0; i < candidate_count; i++)
+        {
+            if (computed_result[i].density != 1.0f)
+                differences.emplace_back(i, computed_result[i].density, 1.0f);
+        }
+
+        CAPTURE(differences);
+        CHECK(differences.empty());
+    }
+}
+
+TEST_CASE("Dithering matrix", "[evaluation]")
+{
+    const auto default_matrix = EvaluationKernel::makeDitheringMatrix(KernelConfiguration::default_pattern_size);
+    for (uint x = 0; x < KernelConfiguration::default_pattern_size.x; x++)
+        for (uint y = 0; y < KernelConfiguration::default_pattern_size.y; y++)
+            CHECK(default_matrix[x * KernelConfiguration::default_pattern_size.y + y]
+                  == EvaluationKernel::default_dithering_matrix[x][y]);
+
+    for (const glm::uvec2 size : KernelConfiguration::supported_sizes)
+    {
+        CAPTURE(size);
+
+        // every threshold appears exactly once.
+        auto matrix = EvaluationKernel::makeDitheringMatrix(size);
+        REQUIRE(matrix.size() == size.x * size.y);
+        std::sort(matrix.begin(), matrix.end());
+        for (std::size_t i = 0; i < matrix.size(); i++)
+            CHECK(matrix[i] == static_cast<float>(i) / static_cast<float>(matrix.size()));
+    }
+
+    CHECK_THROWS_AS(EvaluationKernel::makeDitheringMatrix({6, 8}), std::logic_error);
+}
+
+/**
+ * This test dispatches the indexation kernel with a few hand-picked input arrays and multiple randomly generated ones,
+ * checking that the retrieved indices have the expected values.
+ */
+TEST_CASE("IndexationKernel", "[indexation][kernel]")
+{
+    using Indices = std::vector<int>;
+    const auto class_indices = GENERATE(
+            Indices{-1}, Indices{0},
+            Indices{-1, -1}, Indices{-1, 0}, Indices{0, -1}, Indices{0, 0},
+            take(3, chunk(10, random(-1, 1))),
+            take(3, chunk(64, random(-1, 3))),
+            take(3, chunk(333, random(-1, 5))),
+            take(3, chunk(1024, random(-1, 7))),
+            take(3, chunk(15000, random(-1, 10))));
+
+    using Candidate = TransientCandidate;
+
+    std::vector<Candidate> candidates;
+
+    constexpr int invalid_index = -1;
+
+    std::vector<unsigned int> expected_class_counts;
+
+    for (auto &class_index: class_indices)
+    {
+        candidates.emplace_back(Candidate{0.0f, static_cast<uint>(class_index)});
+
+        if (class_index == invalid_index)
+            continue;
+
+        if (class_index >= expected_class_counts.size())
+            expected_class_counts.resize(class_index + 1);
+
+        expected_class_counts[class_index]++;
+    }
+
+    const uint expected_total_count = std::accumulate(expected_class_counts.begin(), expected_class_counts.end(), 0u);
+
+    CAPTURE(class_indices);
+
+    uint computed_total_count = 0;
+    std::vector<uint> computed_class_counts;
+    computed_class_counts.resize(expected_class_counts.size());
+
+    const GLsizeiptr class_count = expected_class_counts.size();
+    const GLsizeiptr candidate_count = candidates.size();
+
+    CAPTURE(class_count, candidate_count);
+
+    constexpr GLsizeiptr candidate_size = sizeof(Candidate);
+    constexpr GLsizeiptr uint_size = sizeof(GLuint);
+
+    GL::Buffer buffer;
+    const GL::BufferHandle::Range candidate_range{0, candidate_count * candidate_size};
+    const GL::BufferHandle::Range index_range{candidate_range.size, candidate_count * uint_size};
+    const GL::BufferHandle::Range count_range{index_range.offset + index_range.size, class_count * uint_size};
+
+    buffer.allocateImmutable(candidate_range.size + index_range.size + count_range.size,
+                             GL::BufferHandle::StorageFlags::dynamic_storage);
+
+    buffer.write(count_range, computed_class_counts.data()); // initialize counts
+    buffer.write(candidate_range, candidates.data()); // initialize candidates
+
+    constexpr uint candidate_binding_index = 0;
+    constexpr uint index_binding_index = 1;
+    constexpr uint count_binding_index = 2;
+
+    KernelConfiguration configuration;
+    configuration.indexation_local_size = GENERATE(32u, 64u, 256u);
+    configuration.subgroup_indexation = GENERATE(false, true);
+    CAPTURE(configuration.indexation_local_size, configuration.subgroup_indexation);
+
+    IndexationKernel kernel {configuration};
+    CHECK(kernel.usesSubgroups() == (configuration.subgroup_indexation
+                                     && IndexationKernel::isSubgroupIndexationSupported()));
+
+    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, candidate_binding_index, candidate_range);
+    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, index_binding_index, index_range);
+    buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, count_binding_index, count_range);
+
+    const auto wg_count = kernel.calculateNumWorkGroups(candidate_count);
+
+    kernel(wg_count, candidate_binding_index, count_binding_index, index_binding_index);
+    gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    buffer.read(count_range, computed_class_counts.data());
+
+    CHECK(computed_class_counts == expected_class_counts);
+
+    computed_total_count = std::accumulate(computed_class_counts.begin(), computed_class_counts.end(), 0u);
+    CHECK(computed_total_count == expected_total_count);
+
+    std::vector<int> computed_indices(class_indices.size());
     buffer.read(index_range, computed_indices.data());
 
     std::vector<std::vector<uint>> computed_indices_by_class(class_count);
@@ -1008,7 +1674,20 @@ TEST_CASE("CopyKernel", "[copy][kernel]")
                                                take(3, chunk(15000, random(0u, 10u))))};
     constexpr uint invalid_index = -1u;
 
-    using Candidate = Result::Element;
+    using Candidate = TransientCandidate;
+    using Element = Result::Element;
+
+    // positions are generated from a single pattern tile, with values that are exact in single precision.
+    constexpr auto wg_size = KernelConfiguration::default_pattern_size;
+    const glm::vec2 wg_bounds {wg_size};
+    constexpr float footprint = 0.5f;
+    constexpr uint grid_width = 3;
+    constexpr glm::uvec2 work_group_offset {2, 1};
+
+    std::vector<glm::vec2> pattern;
+    for (uint i = 0; i < wg_size.x; i++)
+        for (uint j = 0; j < wg_size.y; j++)
+            pattern.emplace_back(i, j);
 
     std::vector<Candidate> candidates;
     candidates.reserve(indices.size());
@@ -1025,19 +1704,24 @@ TEST_CASE("CopyKernel", "[copy][kernel]")
 
         const uint class_index = index - 1;
 
-        Candidate candidate{glm::vec3(candidates.size()), class_index};
-        candidates.emplace_back(candidate);
+        candidates.push_back({0.0f, class_index});
         copy_indices.emplace_back(class_index != invalid_index ? element_counts[class_index]++ : invalid_index);
     }
 
-    std::vector<Candidate> expected_results;
+    std::vector<Element> expected_results;
     expected_results.reserve(indices.size());
 
     for (uint element_class = 0; element_class < element_counts.size(); element_class++)
     {
-        for (const Candidate &candidate: candidates)
-            if (candidate.class_index == element_class)
-                expected_results.emplace_back(candidate);
+        for (std::size_t i = 0; i < candidates.size(); i++)
+            if (candidates[i].class_index == element_class)
+            {
+                const glm::vec2 position = getCandidatePosition(i, pattern, grid_width, wg_bounds, footprint,
+                                                                work_group_offset);
+
+                // heights are sampled from a black heightmap.
+                expected_results.push_back({{position, 0.0f}, element_class});
+            }
     }
 
     CAPTURE(candidates, element_counts, expected_results, copy_indices);
@@ -1045,13 +1729,14 @@ TEST_CASE("CopyKernel", "[copy][kernel]")
     using namespace GL;
 
     constexpr GLsizeiptr candidate_size = sizeof(Candidate);
+    constexpr GLsizeiptr element_size = sizeof(Element);
     constexpr GLsizeiptr uint_size = sizeof(uint);
     const GLsizeiptr candidate_count = candidates.size();
     const GLsizeiptr class_count = element_counts.size();
 
     Buffer buffer;
     const BufferHandle::Range candidate_range{0, candidate_count * candidate_size};
-    const BufferHandle::Range output_range{candidate_range.size, candidate_range.size};
+    const BufferHandle::Range output_range{candidate_range.size, candidate_count * element_size};
     const BufferHandle::Range index_range{output_range.offset + output_range.size, candidate_count * uint_size};
     const BufferHandle::Range count_range{index_range.offset + index_range.size, class_count * uint_size};
 
@@ -1062,7 +1747,16 @@ TEST_CASE("CopyKernel", "[copy][kernel]")
     buffer.write(count_range, element_counts.data());
     buffer.write(index_range, copy_indices.data());
 
+    constexpr uint pattern_tile_binding = 4;
+    const auto pattern_tile_size = static_cast<GLsizeiptr>(pattern.size() * sizeof(glm::vec2));
+    Buffer pattern_tile_buffer;
+    pattern_tile_buffer.allocateImmutable(pattern_tile_size, BufferHandle::StorageFlags::none, pattern.data());
+    pattern_tile_buffer.bindRange(BufferHandle::IndexedTarget::shader_storage, pattern_tile_binding,
+                                  {0, pattern_tile_size});
+
     CopyKernel kernel;
+    kernel.setPatternTiles(pattern_tile_binding, 1);
+    kernel.setWorkGroupPatternBoundaries(wg_bounds);
 
     constexpr uint candidate_buffer_binding = 0;
     constexpr uint output_buffer_binding = 1;
@@ -1074,18 +1768,22 @@ TEST_CASE("CopyKernel", "[copy][kernel]")
     buffer.bindRange(BufferHandle::IndexedTarget::shader_storage, index_buffer_binding, index_range);
     buffer.bindRange(BufferHandle::IndexedTarget::shader_storage, count_buffer_binding, count_range);
 
-    const uint num_work_groups = CopyKernel::calculateNumWorkGroups(candidate_count);
+    const uint num_work_groups = kernel.calculateNumWorkGroups(candidate_count);
     CAPTURE(candidate_count);
 
-    kernel(num_work_groups,
-           candidate_buffer_binding, count_buffer_binding, index_buffer_binding, output_buffer_binding);
+    constexpr uint heightmap_texture_unit = 0;
+    gl.BindTextureUnit(heightmap_texture_unit, s_texture_loader["assets/textures/grayscale/black.png"]);
+
+    kernel(num_work_groups, work_group_offset, grid_width, footprint, /*world_scale=*/ glm::vec3(100.0f),
+           heightmap_texture_unit, candidate_buffer_binding, count_buffer_binding, index_buffer_binding,
+           output_buffer_binding);
     gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
     const uint total_count = std::accumulate(element_counts.begin(), element_counts.end(), 0u);
 
-    auto output_ptr = static_cast<const Candidate *>(buffer.mapRange(output_range, GL::Buffer::AccessFlags::read));
+    auto output_ptr = static_cast<const Element *>(buffer.mapRange(output_range, GL::Buffer::AccessFlags::read));
 
-    std::vector<Candidate> results(output_ptr, output_ptr + total_count);
+    std::vector<Element> results(output_ptr, output_ptr + total_count);
 
     buffer.unmap();
 
@@ -1114,7 +1812,7 @@ TEST_CASE("DiskDistributionGenerator")
 
     SECTION("GenerationKernel usage")
     {
-        constexpr auto wg_size = GenerationKernel::work_group_size;
+        constexpr auto wg_size = KernelConfiguration::default_pattern_size;
         CAPTURE(wg_size);
 
         const glm::uvec2 grid_size{glm::vec2(wg_size) * 2.5f};
@@ -1212,36 +1910,970 @@ TEST_CASE("DiskDistributionGenerator")
             }
         }
     }
+
+    SECTION("maximal distribution")
+    {
+        constexpr float footprint = 1.0f;
+        DiskDistributionGenerator generator{footprint, {16, 16}};
+        generator.setSeed(seed);
+
+        // fill the grid until no point can be inserted.
+        bool full = false;
+        while (!full)
+        {
+            try
+            { generator.generate(); }
+            catch (std::runtime_error &)
+            { full = true; }
+        }
+
+        const glm::vec2 bounds = generator.getGrid().getBounds();
+        const auto &positions = generator.getPositions();
+
+        // about 0.32 points per grid cell, from which generateWorkGroupPattern() sizes the grid of its patterns.
+        CHECK(positions.size() > 72);
+
+        for (auto p = positions.begin(); p != positions.end(); p++)
+            for (auto q = positions.begin(); q != p; q++)
+            {
+                CAPTURE(*p, *q);
+                CHECK(checkCollision(*p, *q, bounds, footprint));
+            }
+    }
 }
 
-TEST_CASE("SSBO alignment")
+TEST_CASE("Work group pattern", "[generation]")
 {
-    GL::Buffer buffer;
-
-    auto compile_compute_shader = [](const char *source_code)
-    {
-        GL::Program program;
-        GL::Shader shader{GL::Shader::Type::compute};
-        shader.setSource(source_code);
-        shader.compile();
+    using namespace placement;
 
-        if (shader.getParameter(GL::Shader::Parameter::compile_status) != GL_TRUE)
-            throw std::runtime_error(shader.getInfoLog());
+    const uint seed = GENERATE(take(3, random(0u, std::numeric_limits<uint>::max())));
+    const glm::uvec2 pattern_size = GENERATE(from_range(KernelConfiguration::supported_sizes));
+    CAPTURE(seed, pattern_size);
 
-        program.attachShader(shader);
-        program.link();
+    const WorkGroupPattern pattern = generateWorkGroupPattern(seed, pattern_size);
+    REQUIRE(pattern.positions.size() == pattern_size.x * pattern_size.y);
 
-        if (program.getParameter(GL::Program::Parameter::link_status) != GL_TRUE)
-            throw std::runtime_error(program.getInfoLog());
+    // shortest distance between two points of the periodic pattern.
+    const auto distance = [&](glm::vec2 p, glm::vec2 q)
+    {
+        const glm::vec2 d = glm::abs(p - q);
+        return glm::length(glm::min(d, pattern.scale - d));
+    };
 
-        program.detachShader(shader);
+    // largest distance from any point of a tile to its closest candidate, sampled over a fine grid.
+    const auto get_max_empty_radius = [&](const glm::vec2 *positions)
+    {
+        constexpr uint samples = 64;
+        float max_empty_radius = 0.0f;
+        for (uint i = 0; i < samples; i++)
+            for (uint j = 0; j < samples; j++)
+            {
+                const glm::vec2 point = (glm::vec2(i, j) + 0.5f) / float(samples) * pattern.scale;
+                float empty_radius = std::numeric_limits<float>::infinity();
+                for (std::size_t k = 0; k < pattern.positions.size(); k++)
+                    empty_radius = std::min(empty_radius, distance(point, positions[k]));
+                max_empty_radius = std::max(max_empty_radius, empty_radius);
+            }
 
-        return program;
+        return max_empty_radius;
     };
 
-    SECTION("struct {vec3; uint;}")
+    SECTION("Separation")
     {
-        struct Candidate
+        for (std::size_t i = 0; i < pattern.positions.size(); i++)
+            for (std::size_t j = 0; j < i; j++)
+            {
+                CAPTURE(pattern.positions[i], pattern.positions[j]);
+                CHECK(distance(pattern.positions[i], pattern.positions[j]) >= 1.0f);
+            }
+    }
+
+    SECTION("Coverage")
+    {
+        // a maximal distribution leaves no room for another point, i.e. no empty disk of radius 1, and a few of its
+        // points are removed. The first points of a sparser distribution left voids of radius 2 or more, repeated in
+        // every work group.
+        constexpr float max_empty_radius = 1.75f;
+
+        CHECK(get_max_empty_radius(pattern.positions.data()) < max_empty_radius);
+
+        constexpr uint tile_count = 4;
+        const std::vector<glm::vec2> tiles = generatePatternTiles(pattern, seed, tile_count);
+        REQUIRE(tiles.size() == tile_count * pattern.positions.size());
+
+        for (uint i = 1; i < tile_count; i++)
+        {
+            CAPTURE(i);
+            CHECK(get_max_empty_radius(tiles.data() + i * pattern.positions.size()) < max_empty_radius);
+        }
+    }
+}
+
+TEST_CASE("DensityPyramid", "[pyramid]")
+{
+    using namespace placement;
+
+    SECTION("Range")
+    {
+        // 5x3 texture, zero everywhere except for the texel at (3, 1).
+        std::vector<float> values(5 * 3, 0.0f);
+        values[1 * 5 + 3] = 0.5f;
+
+        const DensityPyramid pyramid {{5, 3}, values.data()};
+        CHECK(pyramid.getSize() == glm::uvec2(5, 3));
+        CHECK(pyramid.getLevelCount() == 4);
+
+        CHECK(pyramid.getRange({0.0f, 0.0f}, {1.0f, 1.0f}) == glm::vec2(0.0f, 0.5f));
+        CHECK(pyramid.getRange({0.0f, 0.0f}, {0.2f, 1.0f}) == glm::vec2(0.0f, 0.0f));
+        CHECK(pyramid.getRange({0.7f, 0.5f}, {0.7f, 0.5f}) == glm::vec2(0.0f, 0.5f));
+
+        DensityMap density_map {0, /*scale=*/-1.0f, /*offset=*/1.0f};
+        CHECK(pyramid.getRange(density_map, {0.0f, 0.0f}, {1.0f, 1.0f}) == glm::vec2(0.5f, 1.0f));
+    }
+
+    SECTION("Wrap modes")
+    {
+        // 4x4 texture, zero everywhere except for its first column.
+        std::vector<float> values(4 * 4, 0.0f);
+        for (uint y = 0; y < 4; y++)
+            values[y * 4] = 1.0f;
+
+        const DensityPyramid clamped {{4, 4}, values.data()};
+        const DensityPyramid repeated {{4, 4}, values.data(), {true, false}};
+        CHECK(repeated.getRepeat() == glm::bvec2(true, false));
+
+        // linear filtering reads the first column from the last one, and past the edges of the texture.
+        CHECK(clamped.getRange({0.9f, 0.0f}, {1.0f, 1.0f}) == glm::vec2(0.0f, 0.0f));
+        CHECK(repeated.getRange({0.9f, 0.0f}, {1.0f, 1.0f}) == glm::vec2(0.0f, 1.0f));
+        CHECK(clamped.getRange({1.2f, 0.0f}, {1.3f, 1.0f}) == glm::vec2(0.0f, 0.0f));
+        CHECK(repeated.getRange({1.2f, 0.0f}, {1.3f, 1.0f}) == glm::vec2(0.0f, 1.0f));
+        CHECK(clamped.getRange({-0.2f, 0.0f}, {-0.1f, 1.0f}) == glm::vec2(1.0f, 1.0f));
+        CHECK(repeated.getRange({-0.4f, 0.0f}, {-0.3f, 1.0f}) == glm::vec2(0.0f, 0.0f));
+        CHECK(repeated.getRange({-3.0f, 0.0f}, {3.0f, 1.0f}) == glm::vec2(0.0f, 1.0f));
+    }
+
+    SECTION("World border")
+    {
+        // non-zero density in the last column only, which repeats across the border at u = 0.
+        GLuint texture;
+        gl.CreateTextures(GL_TEXTURE_2D, 1, &texture);
+        gl.TextureStorage2D(texture, 1, GL_R32F, 4, 4);
+        gl.TextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.TextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        std::vector<float> texels(4 * 4, 0.0f);
+        for (uint y = 0; y < 4; y++)
+            texels[y * 4 + 3] = 1.0f;
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        gl.TextureSubImage2D(texture, 0, 0, 0, 4, 4, GL_RED, GL_FLOAT, texels.data());
+
+        WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/heightmap.png"]};
+        const LayerData layer_data{0.01f, {{texture}}};
+
+        // the region only covers the first column, and ends before the second one is sampled on its own.
+        const glm::vec2 lower_bound {0.0f, 0.0f};
+        const glm::vec2 upper_bound {0.1f, 1.0f};
+
+        for (const GLint wrap : {GL_REPEAT, GL_CLAMP_TO_EDGE})
+        {
+            CAPTURE(wrap);
+            gl.TextureParameteri(texture, GL_TEXTURE_WRAP_S, wrap);
+
+            PlacementPipeline pipeline;
+            const auto expected = sortResult(pipeline.computePlacement(world_data, layer_data, lower_bound,
+                                                                        upper_bound).readResult());
+            CHECK(expected.empty() == (wrap == GL_CLAMP_TO_EDGE));
+
+            pipeline.buildDensityPyramid(texture);
+            const auto culled = sortResult(pipeline.computePlacement(world_data, layer_data, lower_bound,
+                                                                      upper_bound).readResult());
+
+            const auto diffs = findDifferences(expected, culled);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
+        }
+
+        gl.TextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
+        CHECK_THROWS_AS(DensityPyramid::fromTexture(texture), std::runtime_error);
+
+        gl.DeleteTextures(1, &texture);
+    }
+
+    SECTION("Pipeline culling")
+    {
+        WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/heightmap.png"]};
+        LayerData layer_data{0.01f, {{s_texture_loader["assets/textures/grayscale/black.png"]},
+                                     {s_texture_loader["assets/textures/grayscale/radial_gradient.png"], 0.5f},
+                                     {s_texture_loader["assets/textures/grayscale/linear_gradient.png"], 0.5f}}};
+
+        const glm::vec2 lower_bound {0.1f, 0.2f};
+        const glm::vec2 upper_bound {0.6f, 0.9f};
+
+        PlacementPipeline pipeline;
+        const auto expected = sortResult(
+                pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult());
+
+        for (const auto &density_map : layer_data.densitymaps)
+            pipeline.buildDensityPyramid(density_map.texture);
+
+        const auto culled = sortResult(
+                pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound).readResult());
+
+        const auto diffs = findDifferences(expected, culled);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
+
+        const LayerData empty_layer_data{0.01f, {{s_texture_loader["assets/textures/grayscale/black.png"]}}};
+        const auto empty = pipeline.computePlacement(world_data, empty_layer_data, lower_bound, upper_bound)
+                .readResult();
+        CHECK(empty.getNumClasses() == 1);
+        CHECK(empty.getElementArrayLength() == 0);
+    }
+}
+
+TEST_CASE("ClassTileGrid", "[pyramid]")
+{
+    using namespace placement;
+
+    SECTION("Tiles")
+    {
+        // 8x8 textures: the first one is positive over its left half, the second one is zero everywhere.
+        std::vector<float> left_values(8 * 8, 0.0f);
+        for (uint y = 0; y < 8; y++)
+            for (uint x = 0; x < 4; x++)
+                left_values[y * 8 + x] = 1.0f;
+        const std::vector<float> zero_values(8 * 8, 0.0f);
+
+        const DensityPyramid left_pyramid {{8, 8}, left_values.data()};
+        const DensityPyramid zero_pyramid {{8, 8}, zero_values.data()};
+        const std::vector<DensityMap> density_maps {{0}, {0}};
+
+        const ClassTileGrid grid {{4, 4}, density_maps, {&left_pyramid, &zero_pyramid}};
+        CHECK(grid.getSize() == glm::uvec2(4, 4));
+        CHECK(grid.getClassCount() == 2);
+
+        // linear filtering reads the positive texels from the tile next to them.
+        CHECK(grid.getTileClasses({0, 0}) == std::vector<uint>{0});
+        CHECK(grid.getTileClasses({2, 3}) == std::vector<uint>{0});
+        CHECK(grid.getTileClasses({3, 1}).empty());
+        CHECK(grid.isClassPresent({1, 2}, 0));
+        CHECK(!grid.isClassPresent({1, 2}, 1));
+
+        CHECK(grid.getTileRange({0.3f, 0.3f}, {0.6f, 1.0f}) == std::pair(glm::ivec2(1, 1), glm::ivec2(3, 5)));
+        CHECK(grid.getTileRange({-0.3f, 0.0f}, {0.1f, 0.2f}) == std::pair(glm::ivec2(-2, 0), glm::ivec2(1, 1)));
+        CHECK(grid.getTileLowerBound({1, 2}) == glm::vec2(0.25f, 0.5f));
+        CHECK(grid.getPresentClasses({0.8f, 0.0f}, {1.0f, 1.0f}) == std::vector<bool>{false, false});
+        CHECK(grid.getPresentClasses({0.0f, 0.0f}, {1.0f, 1.0f}) == std::vector<bool>{true, false});
+
+        // tiles outside of the grid clamp to the edge ones, and also wrap around along repeating axes.
+        CHECK(grid.isClassPresent({-1, 1}, 0));
+        CHECK(!grid.isClassPresent({4, 1}, 0));
+        CHECK(grid.getPresentClasses({1.1f, 0.0f}, {1.2f, 1.0f}) == std::vector<bool>{false, false});
+
+        // 16x16 texture, positive in its two middle columns only, which are read from the two middle tiles.
+        std::vector<float> middle_values(16 * 16, 0.0f);
+        for (uint y = 0; y < 16; y++)
+            middle_values[y * 16 + 7] = middle_values[y * 16 + 8] = 1.0f;
+
+        const DensityPyramid clamped_pyramid {{16, 16}, middle_values.data()};
+        const DensityPyramid repeated_pyramid {{16, 16}, middle_values.data(), {true, false}};
+        const std::vector<DensityMap> middle_density_maps {{0}};
+        const ClassTileGrid clamped_grid {{4, 4}, middle_density_maps, {&clamped_pyramid}};
+        const ClassTileGrid repeated_grid {{4, 4}, middle_density_maps, {&repeated_pyramid}};
+
+        CHECK(!clamped_grid.isClassPresent({5, 1}, 0));
+        CHECK(repeated_grid.isClassPresent({5, 1}, 0));
+        CHECK(!clamped_grid.isClassPresent({-2, 1}, 0));
+        CHECK(repeated_grid.isClassPresent({-2, 1}, 0));
+        CHECK(!repeated_grid.isClassPresent({4, 1}, 0));
+        CHECK(clamped_grid.getPresentClasses({1.3f, 0.0f}, {1.4f, 1.0f}) == std::vector<bool>{false});
+        CHECK(repeated_grid.getPresentClasses({1.3f, 0.0f}, {1.4f, 1.0f}) == std::vector<bool>{true});
+
+        CHECK_THROWS_AS(ClassTileGrid({0, 4}, density_maps, {&left_pyramid, &zero_pyramid}), std::logic_error);
+        CHECK_THROWS_AS(ClassTileGrid({4, 4}, density_maps, {&left_pyramid, nullptr}), std::logic_error);
+    }
+
+    SECTION("Pipeline")
+    {
+        WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/heightmap.png"]};
+        LayerData layer_data{0.01f, {{s_texture_loader["assets/textures/grayscale/black.png"]},
+                                     {s_texture_loader["assets/textures/grayscale/radial_gradient.png"], 0.3f},
+                                     {s_texture_loader["assets/textures/grayscale/linear_gradient.png"], 0.3f},
+                                     {s_texture_loader["assets/textures/grayscale/radial_gradient.png"], 0.3f,
+                                      -0.1f}}};
+
+        const glm::vec2 lower_bound {0.1f, 0.2f};
+        const glm::vec2 upper_bound {0.9f, 0.9f};
+
+        PlacementPipeline pipeline;
+        pipeline.setSingleDispatchThreshold(0);
+        const auto expected = sortResult(pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound)
+                                                  .readResult());
+
+        CHECK_THROWS_AS((void) pipeline.buildClassTileGrid(layer_data.densitymaps, {16, 16}), std::logic_error);
+
+        for (const auto &density_map : layer_data.densitymaps)
+            pipeline.buildDensityPyramid(density_map.texture);
+
+        LayerData tiled_layer_data = layer_data;
+        tiled_layer_data.class_tiles = std::make_shared<ClassTileGrid>(
+                pipeline.buildClassTileGrid(layer_data.densitymaps, {16, 16}));
+
+        const auto culled = sortResult(pipeline.computePlacement(world_data, tiled_layer_data, lower_bound,
+                                                                  upper_bound).readResult());
+        const auto diffs = findDifferences(expected, culled);
+        CAPTURE(diffs);
+        CHECK(diffs.empty());
+
+        // cached candidates are evaluated again, with classes that only cover part of the region.
+        pipeline.setIncrementalMode(true);
+        (void) pipeline.computePlacement(world_data, tiled_layer_data, lower_bound, upper_bound).readResult();
+        CHECK(sortResult(pipeline.updatePlacement(world_data, tiled_layer_data, lower_bound, upper_bound,
+                                                   lower_bound, upper_bound).readResult()) == expected);
+
+        LayerData mismatched_layer_data = tiled_layer_data;
+        mismatched_layer_data.densitymaps.pop_back();
+        CHECK_THROWS_AS((void) pipeline.computePlacement(world_data, mismatched_layer_data, lower_bound, upper_bound),
+                        std::logic_error);
+
+        for (const auto &density_map : layer_data.densitymaps)
+            pipeline.removeDensityPyramid(density_map.texture);
+    }
+
+    SECTION("Disjoint classes")
+    {
+        // the first class is present in two opposite corners, the second one in the other two, so the tiles where
+        // either is present span the whole region.
+        std::vector<GLuint> textures (2);
+        gl.CreateTextures(GL_TEXTURE_2D, 2, textures.data());
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (uint i = 0; i < 2; i++)
+        {
+            gl.TextureStorage2D(textures[i], 1, GL_R32F, 16, 16);
+            gl.TextureParameteri(textures[i], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            gl.TextureParameteri(textures[i], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+            std::vector<float> texels(16 * 16, 0.0f);
+            for (uint y = 0; y < 16; y++)
+                for (uint x = 0; x < 16; x++)
+                    if ((x < 4 || x >= 12) && (y < 4 || y >= 12) && ((x < 4) == (y < 4)) == (i == 0))
+                        texels[y * 16 + x] = 0.5f;
+            gl.TextureSubImage2D(textures[i], 0, 0, 0, 16, 16, GL_RED, GL_FLOAT, texels.data());
+        }
+
+        WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/heightmap.png"]};
+        LayerData layer_data{0.01f, {{textures[0]}, {textures[1]}}};
+
+        const glm::vec2 lower_bound {0.0f, 0.0f};
+        const glm::vec2 upper_bound {1.0f, 1.0f};
+
+        PlacementPipeline pipeline;
+        for (const GLuint texture : textures)
+            pipeline.buildDensityPyramid(texture);
+
+        LayerData tiled_layer_data = layer_data;
+        tiled_layer_data.class_tiles = std::make_shared<ClassTileGrid>(
+                pipeline.buildClassTileGrid(layer_data.densitymaps, {8, 8}));
+
+        // footprint filtering samples the tiles next to those of the corners as well.
+        for (const bool footprint_filtering : {false, true})
+        {
+            CAPTURE(footprint_filtering);
+            pipeline.setFootprintFiltering(footprint_filtering);
+
+            const Result expected_result = pipeline.computePlacement(world_data, layer_data, lower_bound,
+                                                                     upper_bound).readResult();
+            REQUIRE(expected_result.getClassElementCount(0) > 0);
+            REQUIRE(expected_result.getClassElementCount(1) > 0);
+            const auto expected = sortResult(expected_result);
+
+            const auto culled = sortResult(pipeline.computePlacement(world_data, tiled_layer_data, lower_bound,
+                                                                      upper_bound).readResult());
+            const auto diffs = findDifferences(expected, culled);
+            CAPTURE(diffs);
+            CHECK(diffs.empty());
+        }
+
+        for (const GLuint texture : textures)
+            pipeline.removeDensityPyramid(texture);
+        gl.DeleteTextures(2, textures.data());
+    }
+}
+
+TEST_CASE("ThresholdTexture", "[threshold]")
+{
+    using namespace placement;
+
+    SECTION("Blue noise")
+    {
+        constexpr uint size = 16;
+        const auto values = generateBlueNoise(size, 0);
+        REQUIRE(values.size() == size * size);
+
+        // every threshold appears exactly once.
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        for (uint i = 0; i < sorted.size(); i++)
+            CHECK(sorted[i] == Approx(static_cast<float>(i) / sorted.size()));
+
+        CHECK(generateBlueNoise(size, 0) == values);
+
+        // other seeds shift the same matrix.
+        const auto shifted = generateBlueNoise(size, 1);
+        CHECK(shifted != values);
+        const auto is_shift = [&](glm::uvec2 offset)
+        {
+            for (uint y = 0; y < size; y++)
+                for (uint x = 0; x < size; x++)
+                    if (shifted[y * size + x] != values[(y + offset.y) % size * size + (x + offset.x) % size])
+                        return false;
+            return true;
+        };
+        bool found_shift = false;
+        for (uint y = 0; y < size; y++)
+            for (uint x = 0; x < size; x++)
+                found_shift = found_shift || is_shift({x, y});
+        CHECK(found_shift);
+
+        // sizes other than powers of two.
+        auto odd_sorted = generateBlueNoise(12, 3);
+        REQUIRE(odd_sorted.size() == 144);
+        std::sort(odd_sorted.begin(), odd_sorted.end());
+        for (uint i = 0; i < odd_sorted.size(); i++)
+            CHECK(odd_sorted[i] == Approx(static_cast<float>(i) / odd_sorted.size()));
+
+        // the lowest thresholds are spread evenly, so the 8 lowest ones are not adjacent to each other.
+        std::vector<glm::ivec2> lowest;
+        for (uint i = 0; i < values.size(); i++)
+            if (values[i] < 8.0f / values.size())
+                lowest.emplace_back(i % size, i / size);
+
+        for (std::size_t i = 0; i < lowest.size(); i++)
+            for (std::size_t j = 0; j < i; j++)
+            {
+                const glm::ivec2 distance = glm::abs(lowest[i] - lowest[j]);
+                const glm::ivec2 toroidal_distance = glm::min(distance, glm::ivec2(size) - distance);
+                CAPTURE(lowest[i], lowest[j]);
+                CHECK(glm::max(toroidal_distance.x, toroidal_distance.y) > 1);
+            }
+
+        CHECK_THROWS_AS(generateBlueNoise(0, 0), std::logic_error);
+    }
+
+    SECTION("Pipeline")
+    {
+        WorldData world_data{{1.f, 1.f, 1.f}, s_texture_loader["assets/textures/grayscale/black.png"]};
+        const GLuint white_texture = s_texture_loader["assets/textures/grayscale/white.png"];
+        LayerData layer_data{0.01f, {{white_texture, /*scale=*/0.5f}, {white_texture, /*scale=*/0.5f}}};
+
+        PlacementPipeline pipeline;
+        pipeline.setBlueNoiseThresholds(64);
+        REQUIRE(pipeline.getBlueNoiseSize() == 64);
+
+        const auto result = pipeline.computePlacement(world_data, layer_data, {0.0f, 0.0f}, {1.0f, 1.0f}).readResult();
+
+        // the first class accepts the half of the candidates with the lowest thresholds, and the second one the rest.
+        const auto first_count = static_cast<float>(result.getClassElementCount(0));
+        const auto second_count = static_cast<float>(result.getClassElementCount(1));
+        CHECK(first_count > 0.0f);
+        CHECK(first_count == Approx(second_count).epsilon(0.05));
+
+        pipeline.setBlueNoiseThresholds(0);
+        CHECK(pipeline.getBlueNoiseSize() == 0);
+    }
+}
+
+/// Load an 8-bit image as the CPU pipeline counterpart of a texture of the TextureLoader, which repeats by default.
+cpu::Image loadCPUImage(const char *filename)
+{
+    glm::ivec2 size;
+    const std::unique_ptr<stbi_uc[], void (*)(void *)> data
+            {stbi_load(filename, &size.x, &size.y, nullptr, 1), stbi_image_free};
+
+    if (!data)
+        throw std::runtime_error(stbi_failure_reason());
+
+    cpu::Image image = cpu::Image::fromUnorm8(glm::uvec2(size), data.get());
+    image.setWrap(cpu::Image::Wrap::repeat);
+    return image;
+}
+
+TEST_CASE("CPU PlacementPipeline", "[cpu]")
+{
+    using namespace placement;
+
+    SECTION("Image")
+    {
+        cpu::Image image {{2, 2}, {0.0f, 1.0f, 0.5f, 0.25f}};
+        CHECK(image.fetch({1, 0}) == 1.0f);
+        CHECK(image.fetch({0, 1}) == 0.5f);
+
+        image.setFilter(cpu::Image::Filter::nearest);
+        CHECK(image.sample({0.75f, 0.25f}) == 1.0f);
+        CHECK(image.sample({0.25f, 0.75f}) == 0.5f);
+
+        // texel centers have the values of their texels, and the center of the image their average.
+        image.setFilter(cpu::Image::Filter::linear);
+        CHECK(image.sample({0.25f, 0.25f}) == 0.0f);
+        CHECK(image.sample({0.75f, 0.75f}) == 0.25f);
+        CHECK(image.sample({0.5f, 0.5f}) == Approx(0.4375f));
+        CHECK(image.sample({0.0f, 0.25f}) == 0.0f);
+
+        image.setWrap(cpu::Image::Wrap::repeat);
+        CHECK(image.sample({0.0f, 0.25f}) == Approx(0.5f));
+        CHECK(image.fetch({-1, 2}) == 1.0f);
+
+        CHECK_THROWS_AS(cpu::Image({2, 2}, {0.0f}), std::logic_error);
+        CHECK_THROWS_AS(cpu::Image({0, 2}, {}), std::logic_error);
+    }
+
+    SECTION("Same results as the GPU pipeline")
+    {
+        constexpr auto heightmap_filename = "assets/textures/grayscale/heightmap.png";
+        constexpr auto white_filename = "assets/textures/grayscale/white.png";
+
+        const cpu::Image heightmap_image = loadCPUImage(heightmap_filename);
+        const cpu::Image white_image = loadCPUImage(white_filename);
+
+        const uint seed = GENERATE(0u, 42u);
+        const uint tile_count = GENERATE(1u, 4u);
+        const uint blue_noise_size = GENERATE(0u, 12u, 16u);
+        CAPTURE(seed, tile_count, blue_noise_size);
+
+        PlacementPipeline gpu_pipeline;
+        gpu_pipeline.setPatternTileCount(tile_count);
+        gpu_pipeline.setBlueNoiseThresholds(blue_noise_size);
+
+        cpu::PlacementPipeline cpu_pipeline;
+        cpu_pipeline.setPatternTileCount(tile_count);
+        cpu_pipeline.setBlueNoiseThresholds(blue_noise_size);
+        CHECK(cpu_pipeline.getPatternSize() == KernelConfiguration::default_pattern_size);
+
+        const GLuint white_texture = s_texture_loader[white_filename];
+        const WorldData world_data {{1.f, 1.f, 1.f}, s_texture_loader[heightmap_filename]};
+        const LayerData layer_data {0.01f,
+                                    {{white_texture, .4f}, {white_texture, .3f}, {white_texture, .2f},
+                                     {white_texture, .1f}}};
+
+        const cpu::WorldData cpu_world_data {{1.f, 1.f, 1.f}, &heightmap_image};
+        const cpu::LayerData cpu_layer_data {0.01f,
+                                             {{&white_image, .4f}, {&white_image, .3f}, {&white_image, .2f},
+                                              {&white_image, .1f}}};
+
+        // a region that is not aligned to the work group grid.
+        const glm::vec2 lower_bound {0.13f, 0.07f};
+        const glm::vec2 upper_bound {0.91f, 0.78f};
+
+        const auto gpu_result = gpu_pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound, seed)
+                .readResult();
+        auto future_result = cpu_pipeline.computePlacement(cpu_world_data, cpu_layer_data, lower_bound, upper_bound,
+                                                           seed);
+        CHECK(future_result.wait(std::chrono::nanoseconds::max()));
+        const auto cpu_result = future_result.readResult();
+
+        REQUIRE(cpu_result.getIndexOffsets() == gpu_result.getIndexOffsets());
+        CHECK(cpu_result.getElementArrayLength() > 0);
+
+        // the GPU pipeline does not specify the order of the elements within a class.
+        auto gpu_elements = gpu_result.copyAllToHost();
+        auto cpu_elements = cpu_result.copyAllToHost();
+        std::sort(gpu_elements.begin(), gpu_elements.end(), elementCompare);
+        std::sort(cpu_elements.begin(), cpu_elements.end(), elementCompare);
+
+        for (std::size_t i = 0; i < cpu_elements.size(); i++)
+        {
+            CAPTURE(i);
+            CHECK(cpu_elements[i].class_index == gpu_elements[i].class_index);
+            CHECK(cpu_elements[i].position.x == gpu_elements[i].position.x);
+            CHECK(cpu_elements[i].position.y == gpu_elements[i].position.y);
+            CHECK(cpu_elements[i].position.z == Approx(gpu_elements[i].position.z).margin(1e-2));
+        }
+    }
+
+    SECTION("Same results as the GPU pipeline with a gradient")
+    {
+        constexpr auto black_filename = "assets/textures/grayscale/black.png";
+
+        const cpu::Image heightmap_image = loadCPUImage(black_filename);
+        cpu::Image gradient_image = loadCPUImage("assets/textures/grayscale/radial_gradient.png");
+        const glm::ivec2 size {gradient_image.getSize()};
+
+        // a texture with the values of the image, which repeats as well.
+        GLuint gradient_texture;
+        gl.CreateTextures(GL_TEXTURE_2D, 1, &gradient_texture);
+        gl.TextureStorage2D(gradient_texture, 1, GL_R32F, size.x, size.y);
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        gl.TextureSubImage2D(gradient_texture, 0, 0, 0, size.x, size.y, GL_RED, GL_FLOAT,
+                             gradient_image.getValues().data());
+
+        const WorldData world_data {{1.f, 1.f, 1.f}, s_texture_loader[black_filename]};
+        const LayerData layer_data {0.01f, {{gradient_texture, .6f}, {gradient_texture, .4f}}};
+        const cpu::WorldData cpu_world_data {{1.f, 1.f, 1.f}, &heightmap_image};
+        const cpu::LayerData cpu_layer_data {0.01f, {{&gradient_image, .6f}, {&gradient_image, .4f}}};
+
+        const glm::vec2 lower_bound {0.13f, 0.07f};
+        const glm::vec2 upper_bound {0.91f, 0.78f};
+
+        PlacementPipeline gpu_pipeline;
+        cpu::PlacementPipeline cpu_pipeline;
+
+        {
+            // texels are sampled on their own, so every candidate has the same density on both pipelines.
+            gl.TextureParameteri(gradient_texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            gl.TextureParameteri(gradient_texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            gradient_image.setFilter(cpu::Image::Filter::nearest);
+
+            const auto gpu_result = gpu_pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound)
+                    .readResult();
+            const auto cpu_result = cpu_pipeline.computePlacement(cpu_world_data, cpu_layer_data, lower_bound,
+                                                                  upper_bound).readResult();
+
+            REQUIRE(cpu_result.getIndexOffsets() == gpu_result.getIndexOffsets());
+            CHECK(cpu_result.getClassElementCount(0) > 0);
+            CHECK(cpu_result.getClassElementCount(1) > 0);
+
+            auto gpu_elements = gpu_result.copyAllToHost();
+            auto cpu_elements = cpu_result.copyAllToHost();
+            std::sort(gpu_elements.begin(), gpu_elements.end(), elementCompare);
+            std::sort(cpu_elements.begin(), cpu_elements.end(), elementCompare);
+
+            for (std::size_t i = 0; i < cpu_elements.size(); i++)
+            {
+                CAPTURE(i);
+                CHECK(cpu_elements[i].class_index == gpu_elements[i].class_index);
+                CHECK(cpu_elements[i].position.x == gpu_elements[i].position.x);
+                CHECK(cpu_elements[i].position.y == gpu_elements[i].position.y);
+                CHECK(cpu_elements[i].position.z == gpu_elements[i].position.z);
+            }
+        }
+
+        {
+            // densities between texels are filtered with weights of reduced precision on the GPU, which may change the
+            // class of candidates whose density is close to their threshold.
+            gl.TextureParameteri(gradient_texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            gl.TextureParameteri(gradient_texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gradient_image.setFilter(cpu::Image::Filter::linear);
+
+            auto gpu_elements = gpu_pipeline.computePlacement(world_data, layer_data, lower_bound, upper_bound)
+                    .readResult().copyAllToHost();
+            const auto cpu_elements = cpu_pipeline.computePlacement(cpu_world_data, cpu_layer_data, lower_bound,
+                                                                    upper_bound).readResult().copyAllToHost();
+            REQUIRE(!cpu_elements.empty());
+            CHECK(cpu_elements.size() == Approx(gpu_elements.size()).epsilon(0.01));
+
+            const auto compare_x = [](const Result::Element &element, float x) { return element.position.x < x; };
+            std::sort(gpu_elements.begin(), gpu_elements.end(),
+                      [](const Result::Element &l, const Result::Element &r) { return l.position.x < r.position.x; });
+
+            // elements at the same position, in the same class.
+            std::size_t matching_count = 0;
+            for (const auto &element : cpu_elements)
+                for (auto iter = std::lower_bound(gpu_elements.begin(), gpu_elements.end(),
+                                                  element.position.x - 1e-5f, compare_x);
+                     iter != gpu_elements.end() && iter->position.x <= element.position.x + 1e-5f; iter++)
+                    if (std::abs(iter->position.y - element.position.y) <= 1e-5f
+                        && iter->class_index == element.class_index)
+                    {
+                        matching_count++;
+                        break;
+                    }
+
+            CHECK(static_cast<float>(matching_count) >= 0.99f * static_cast<float>(cpu_elements.size()));
+        }
+
+        gl.DeleteTextures(1, &gradient_texture);
+    }
+
+    SECTION("Instruction sets")
+    {
+        const cpu::Image heightmap_image = loadCPUImage("assets/textures/grayscale/heightmap.png");
+        const cpu::Image gradient_image = loadCPUImage("assets/textures/grayscale/radial_gradient.png");
+
+        // nearest filtering and clamping for some classes, and densities between texels.
+        cpu::Image nearest_image = loadCPUImage("assets/textures/grayscale/radial_gradient.png");
+        nearest_image.setFilter(cpu::Image::Filter::nearest);
+        nearest_image.setWrap(cpu::Image::Wrap::clamp_to_edge);
+
+        const cpu::WorldData world_data {{10.f, 10.f, 2.f}, &heightmap_image};
+        const cpu::LayerData layer_data {0.05f, {{&gradient_image, .3f}, {&gradient_image, .5f, -.1f},
+                                                 {&nearest_image, .2f}, {&gradient_image, 1.f, -.5f, 0.f, .2f}}};
+
+        cpu::PlacementPipeline pipeline;
+        pipeline.setBlueNoiseThresholds(16);
+        CHECK(pipeline.getInstructionSet() == cpu::getSupportedInstructionSet());
+
+        pipeline.setInstructionSet(cpu::InstructionSet::scalar);
+        const auto expected = pipeline.computePlacement(world_data, layer_data, {.3f, .2f}, {9.7f, 8.9f})
+                .readResult();
+        REQUIRE(expected.getElementArrayLength() > 0);
+
+        // every kernel places the same elements, bit for bit.
+        for (const auto instruction_set : {cpu::InstructionSet::sse4_1, cpu::InstructionSet::avx2})
+        {
+            CAPTURE(static_cast<int>(instruction_set));
+            if (instruction_set > cpu::getSupportedInstructionSet())
+            {
+                CHECK_THROWS_AS(pipeline.setInstructionSet(instruction_set), std::logic_error);
+                continue;
+            }
+
+            pipeline.setInstructionSet(instruction_set);
+            const auto result = pipeline.computePlacement(world_data, layer_data, {.3f, .2f}, {9.7f, 8.9f})
+                    .readResult();
+
+            CHECK(result.getIndexOffsets() == expected.getIndexOffsets());
+            CHECK(result.getElements() == expected.getElements());
+        }
+    }
+
+    SECTION("Errors")
+    {
+        CHECK_THROWS_AS(cpu::PlacementPipeline({3, 3}), std::logic_error);
+
+        cpu::PlacementPipeline pipeline;
+        CHECK_THROWS_AS(pipeline.setPatternTileCount(0), std::logic_error);
+
+        const cpu::Image image {{1, 1}, {1.0f}};
+        CHECK_THROWS_AS(pipeline.computePlacement({{1.f, 1.f, 1.f}, nullptr}, {0.1f, {{&image}}}, {0, 0}, {1, 1}),
+                        std::logic_error);
+        CHECK_THROWS_AS(pipeline.computePlacement({{1.f, 1.f, 1.f}, &image}, {0.1f, {{nullptr}}}, {0, 0}, {1, 1}),
+                        std::logic_error);
+
+        // an empty region places nothing.
+        const auto result = pipeline.computePlacement({{1.f, 1.f, 1.f}, &image}, {0.1f, {{&image}}}, {1, 1}, {0, 0})
+                .readResult();
+        CHECK(result.getNumClasses() == 1);
+        CHECK(result.getElementArrayLength() == 0);
+    }
+}
+
+TEST_CASE("Kernel tuning", "[tuning]")
+{
+    const auto cache_file = std::filesystem::temp_directory_path() / "pplib_kernel_tuning_test.txt";
+    std::filesystem::remove(cache_file);
+
+    KernelConfiguration configuration;
+    configuration.pattern_size = {16, 16};
+    configuration.local_size = {32, 8};
+    configuration.indexation_local_size = 128;
+    configuration.copy_local_size = 256;
+
+    SECTION("Cache file")
+    {
+        CHECK_FALSE(loadKernelTuning(cache_file, configuration.pattern_size));
+
+        REQUIRE(saveKernelTuning(cache_file, configuration));
+        CHECK(loadKernelTuning(cache_file, configuration.pattern_size) == configuration);
+        CHECK_FALSE(loadKernelTuning(cache_file, KernelConfiguration::default_pattern_size));
+
+        // entries are replaced per device and pattern size.
+        KernelConfiguration default_configuration;
+        REQUIRE(saveKernelTuning(cache_file, default_configuration));
+        configuration.copy_local_size = 32;
+        REQUIRE(saveKernelTuning(cache_file, configuration));
+        CHECK(loadKernelTuning(cache_file, configuration.pattern_size) == configuration);
+        CHECK(loadKernelTuning(cache_file, default_configuration.pattern_size) == default_configuration);
+
+        // entries of other devices and malformed lines are ignored.
+        {
+            std::ofstream file {cache_file, std::ios::app};
+            file << "8 8 16 16 64 64 some other device\n";
+            file << "8 8 5 5 64 64 " << getKernelTuningKey() << "\n";
+            file << "not a configuration\n";
+        }
+        CHECK(loadKernelTuning(cache_file, default_configuration.pattern_size) == default_configuration);
+
+        PlacementPipeline pipeline {cache_file};
+        CHECK(pipeline.getKernelConfiguration() == default_configuration);
+    }
+
+    SECTION("Tuning")
+    {
+        const KernelConfiguration tuned = tuneKernelConfiguration({4, 4});
+        CHECK(tuned.isSupported());
+        CHECK(tuned.pattern_size == glm::uvec2(4, 4));
+
+        CHECK_THROWS_AS(tuneKernelConfiguration({5, 5}), std::logic_error);
+
+        CHECK(getTunedKernelConfiguration(cache_file, {4, 4}).isSupported());
+        CHECK(loadKernelTuning(cache_file, {4, 4}));
+    }
+
+    std::filesystem::remove(cache_file);
+}
+
+TEST_CASE("InstanceRingBuffer", "[ring]")
+{
+    constexpr glm::uvec2 window_size {3, 2};
+    constexpr GLuint slot_capacity = 256;
+
+    PlacementPipeline pipeline;
+    WorldData world_data{{10.f, 10.f, 1.f}, s_texture_loader["assets/textures/grayscale/black.png"]};
+    const GLuint white_texture = s_texture_loader["assets/textures/grayscale/white.png"];
+    LayerData layer_data{.5f, {{white_texture, .5f}, {white_texture, .5f}}};
+
+    InstanceRingBuffer ring {window_size, slot_capacity, static_cast<GLuint>(layer_data.densitymaps.size())};
+
+    SECTION("Toroidal addressing")
+    {
+        const auto initial_cells = ring.moveWindow({0, 0});
+        CHECK(initial_cells.size() == window_size.x * window_size.y);
+
+        std::vector<GLuint> slots;
+        for (auto cell: initial_cells)
+            slots.emplace_back(ring.getSlotIndex(cell));
+        std::sort(slots.begin(), slots.end());
+        CHECK(std::adjacent_find(slots.begin(), slots.end()) == slots.end());
+
+        for (auto cell: initial_cells)
+            ring.writeSlot(cell, pipeline.computePlacement(world_data, layer_data, glm::vec2(cell), glm::vec2(cell + 1))
+                                         .readResult());
+
+        const auto new_cells = ring.moveWindow({1, 0});
+        REQUIRE(new_cells.size() == window_size.y);
+
+        for (auto cell: new_cells)
+        {
+            CAPTURE(cell);
+            CHECK(cell.x == 3);
+            CHECK(ring.getSlotIndex(cell) == ring.getSlotIndex(cell - glm::ivec2(3, 0)));
+            CHECK(!ring.isWritten(cell));
+        }
+
+        CHECK(ring.isWritten({1, 0}));
+        CHECK(ring.isWritten({2, 1}));
+        CHECK(!ring.contains({0, 0}));
+        CHECK_THROWS(ring.writeSlot({0, 0}, pipeline.computePlacement(world_data, layer_data, {0, 0}, {1, 1})
+                                                    .readResult()));
+        CHECK_THROWS(ring.clearSlot({0, 0}));
+    }
+
+    SECTION("Slot contents")
+    {
+        ring.moveWindow({-1, -1});
+
+        const glm::ivec2 cell {0, -1};
+        const auto result = pipeline.computePlacement(world_data, layer_data, {0, 0}, {2, 2}).readResult();
+        REQUIRE(result.getElementArrayLength() > 0);
+        REQUIRE(result.getElementArrayLength() <= slot_capacity);
+
+        CHECK(ring.writeSlot(cell, result) == result.getElementArrayLength());
+        gl.MemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        std::vector<DrawElementsIndirectCommand> commands (ring.getSlotCount() * ring.getNumClasses());
+        ring.getCommandBuffer().read(0, static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand)),
+                                     commands.data());
+
+        const GLuint slot_index = ring.getSlotIndex(cell);
+        std::vector<Result::Element> slot_elements;
+
+        for (GLuint class_index = 0; class_index < ring.getNumClasses(); class_index++)
+        {
+            CAPTURE(class_index);
+            const auto &command = commands[slot_index * ring.getNumClasses() + class_index];
+            CHECK(command.instance_count == result.getClassElementCount(class_index));
+            CHECK(command.base_instance == slot_index * slot_capacity + result.getClassIndexOffset(class_index));
+        }
+
+        slot_elements.resize(result.getElementArrayLength());
+        ring.getElementBuffer().read(ring.getSlotBufferOffset(cell),
+                                     static_cast<GLsizeiptr>(slot_elements.size() * sizeof(Result::Element)),
+                                     slot_elements.data());
+
+        CHECK(slot_elements == result.copyAllToHost());
+    }
+}
+
+TEST_CASE("UniformRingBuffer", "[kernel]")
+{
+    constexpr GLsizeiptr size = 4096;
+    constexpr GLuint binding_index = 3;
+
+    GLint alignment = 1;
+    gl.GetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    REQUIRE(alignment <= size / static_cast<GLint>(UniformRingBuffer::segment_count));
+
+    UniformRingBuffer ring {size};
+
+    const auto get_bound_range = [&]
+    {
+        GLint64 offset = -1;
+        GLint64 range_size = -1;
+        gl.GetInteger64i_v(GL_UNIFORM_BUFFER_START, binding_index, &offset);
+        gl.GetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, binding_index, &range_size);
+        return std::pair{offset, range_size};
+    };
+
+    SECTION("Ranges are aligned, and wrap around")
+    {
+        GLint64 previous_offset = -1;
+        bool wrapped = false;
+
+        // more than enough blocks to go around the buffer twice.
+        for (int i = 0; i < 2 * size / alignment + 2; i++)
+        {
+            const glm::vec4 block {static_cast<float>(i)};
+            ring.bind(binding_index, block);
+
+            const auto [offset, range_size] = get_bound_range();
+            CAPTURE(i, offset);
+            CHECK(offset % alignment == 0);
+            CHECK(range_size == sizeof(block));
+            CHECK(offset + range_size <= size);
+
+            GLint buffer = 0;
+            gl.GetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, binding_index, &buffer);
+            glm::vec4 bound_block {-1.0f};
+            gl.GetNamedBufferSubData(static_cast<GLuint>(buffer), offset, sizeof(bound_block), &bound_block);
+            CHECK(bound_block == block);
+
+            if (offset <= previous_offset)
+            {
+                CHECK(offset == 0);
+                wrapped = true;
+            }
+            previous_offset = offset;
+        }
+
+        CHECK(wrapped);
+    }
+
+    SECTION("Blocks larger than a segment")
+    {
+        const std::vector<std::byte> block (size / UniformRingBuffer::segment_count + 1);
+        CHECK_THROWS_AS(ring.bindData(binding_index, block.data(), static_cast<GLsizeiptr>(block.size())),
+                        std::logic_error);
+    }
+}
+
+TEST_CASE("SSBO alignment")
+{
+    GL::Buffer buffer;
+
+    auto compile_compute_shader = [](const char *source_code)
+    {
+        GL::Program program;
+        GL::Shader shader{GL::Shader::Type::compute};
+        shader.setSource(source_code);
+        shader.compile();
+
+        if (shader.getParameter(GL::Shader::Parameter::compile_status) != GL_TRUE)
+            throw std::runtime_error(shader.getInfoLog());
+
+        program.attachShader(shader);
+        program.link();
+
+        if (program.getParameter(GL::Program::Parameter::link_status) != GL_TRUE)
+            throw std::runtime_error(program.getInfoLog());
+
+        program.detachShader(shader);
+
+        return program;
+    };
+
+    SECTION("struct {vec3; uint;}")
+    {
+        struct Candidate
         {
             glm::vec3 position;
             uint index;
@@ -1303,142 +2935,12 @@ TEST_CASE("SSBO alignment")
     }
 }
 
-using WorkGroupPattern =
-        std::array<std::array<glm::vec2, GenerationKernel::work_group_size.y>, GenerationKernel::work_group_size.x>;
-
-std::pair<glm::vec2, WorkGroupPattern> generateWorkGroupPattern(uint seed)
-{
-    constexpr auto wg_size = GenerationKernel::work_group_size;
-
-    DiskDistributionGenerator generator{1.0f, wg_size * 2u};
-    generator.setSeed(seed);
-    generator.setMaxAttempts(100);
-
-    std::array<std::array<glm::vec2, wg_size.y>, wg_size.x> positions;
-    for (auto &column: positions)
-        for (auto &cell: column)
-            cell = generator.generate();
-
-    return {generator.getGrid().getBounds(), positions};
-}
-
-struct GrayscaleImage
-{
-public:
-    explicit GrayscaleImage(const char *filename)
-            : m_data(stbi_load(filename, &m_size.x, &m_size.y, nullptr, 1), stbi_image_free)
-    {
-        if (!m_data)
-            throw std::runtime_error(stbi_failure_reason());
-    }
-
-    [[nodiscard]]
-    glm::ivec2 getSize() const
-    { return m_size; }
-
-    [[nodiscard]]
-    float sample(glm::vec2 tex_coord) const
-    {
-        const glm::ivec2 pixel_index = glm::clamp(tex_coord, {0, 0}, {1, 1}) * glm::vec2(m_size);
-        const stbi_uc value = m_data[pixel_index.y * m_size.x + pixel_index.x];
-        return static_cast<float>(value) / static_cast<float>(std::numeric_limits<stbi_uc>::max());
-    }
-
-private:
-    glm::ivec2 m_size{0};
-    std::unique_ptr<stbi_uc[], void (*)(void *)> m_data;
-};
-
-template<class ExecutionPolicy>
-[[nodiscard]]
-std::vector<Result::Element> computePlacement(const ExecutionPolicy &policy,
-                                              const WorldData &world_data, const LayerData &layer_data,
-                                              glm::vec2 lower_bound, glm::vec2 upper_bound,
-                                              glm::vec2 work_group_bounds, WorkGroupPattern work_group_pattern,
-                                              const GrayscaleImage &heightmap,
-                                              const std::vector<const GrayscaleImage*> &densitymaps)
-{
-    const glm::vec2 work_group_footprint{work_group_bounds * layer_data.footprint};
-    const glm::vec2 base_offset{lower_bound / work_group_footprint};
-    const glm::uvec2 num_work_groups{glm::uvec2((upper_bound - lower_bound) / work_group_footprint) + 1u};
-
-    const glm::uvec2 wg_size{work_group_pattern.size(), work_group_pattern.front().size()};
-
-    constexpr uint invalid_index = -1u;
-
-    std::vector<Result::Element> candidates;
-    candidates.resize(num_work_groups.x * num_work_groups.y * wg_size.x * wg_size.y, {{0, 0, 0}, invalid_index});
-
-    std::vector<float> acc_density;
-    acc_density.resize(candidates.size());
-
-    std::vector<glm::uvec2> work_group_indices;
-    for (uint i = 0; i < num_work_groups.x; i++)
-        for (uint j = 0; j < num_work_groups.y; j++)
-            work_group_indices.emplace_back(i, j);
-
-    std::vector<glm::uvec2> invocation_indices;
-    for (uint i = 0; i < work_group_pattern.size(); i++)
-        for (uint j = 0; j < work_group_pattern.front().size(); j++)
-            invocation_indices.emplace_back(i, j);
-
-    std::for_each(policy, work_group_indices.cbegin(), work_group_indices.cend(),
-                  [&, work_group_footprint, base_offset, num_work_groups, wg_size](glm::uvec2 wg_id)
-                  {
-                      const uint wg_array_index = (wg_id.x * num_work_groups.y + wg_id.y) * wg_size.x * wg_size.y;
-                      const glm::vec2 wg_offset = base_offset + glm::vec2(wg_id) * work_group_footprint;
-
-                      std::for_each(policy, invocation_indices.cbegin(), invocation_indices.cend(),
-                                    [&, wg_array_index, wg_offset](glm::uvec2 inv_id)
-                                    {
-                                        const uint inv_array_index = wg_array_index + inv_id.x * wg_size.y + inv_id.y;
-                                        const glm::vec2 inv_position =
-                                                wg_offset + work_group_pattern[inv_id.x][inv_id.y];
-
-                                        const glm::vec2 candidate_uv{inv_position / glm::vec2(world_data.scale)};
-
-                                        auto &candidate = candidates[inv_array_index];
-                                        candidate.position = {inv_position, heightmap.sample(candidate_uv)};
-
-                                        if (glm::any(glm::lessThan(glm::vec2(candidate.position), lower_bound)) ||
-                                            glm::any(glm::greaterThanEqual(glm::vec2(candidate.position), upper_bound)))
-                                            return;
-
-                                        for (uint i = 0; i < layer_data.densitymaps.size(); i++)
-                                        {
-                                            const auto &d_map = layer_data.densitymaps[i];
-
-                                            const float layer_density = glm::clamp(densitymaps[i]->sample(candidate_uv)
-                                                                                   * d_map.scale + d_map.offset,
-                                                                                   d_map.min_value, d_map.max_value);
-
-                                            const auto threshold =
-                                                    EvaluationKernel::default_dithering_matrix[inv_id.x][inv_id.y];
-
-                                            if ((acc_density[inv_array_index] += layer_density) > threshold)
-                                            {
-                                                candidate.class_index = i;
-                                                return;
-                                            }
-                                        }
-                                    });
-                  });
-
-    std::sort(policy, candidates.begin(), candidates.end(),
-              [](const Result::Element &l, const Result::Element &r)
-              { return l.class_index < r.class_index; });
-
-    return candidates;
-}
-
 TEST_CASE("Benchmark", "[.][benchmark]")
 {
     constexpr auto heightmap_filename = "assets/textures/grayscale/heightmap.png";
 
     placement::WorldData world_data{{10000, 10000, 1.f}, s_texture_loader[heightmap_filename]};
 
-    const GrayscaleImage heightmap_image {heightmap_filename};
-
     const auto layer_random = GENERATE(take(1, chunk(20, random(0.5f, 1.5f))));
 
     constexpr auto densitymap_filename = "assets/textures/grayscale/radial_gradient.png";
@@ -1452,46 +2954,78 @@ TEST_CASE("Benchmark", "[.][benchmark]")
         dm.texture = s_texture_loader[densitymap_filename];
     }
 
-    const GrayscaleImage densitymap_image {densitymap_filename};
-    std::vector<const GrayscaleImage*> densitymaps;
-    densitymaps.resize(layer_data.densitymaps.size(), &densitymap_image);
+    const cpu::Image heightmap_image = loadCPUImage(heightmap_filename);
+    const cpu::Image densitymap_image = loadCPUImage(densitymap_filename);
+
+    const cpu::WorldData cpu_world_data {world_data.scale, &heightmap_image};
+    cpu::LayerData cpu_layer_data {layer_data.footprint};
+    for (const auto &dm : layer_data.densitymaps)
+        cpu_layer_data.densitymaps.push_back({&densitymap_image, dm.scale, dm.offset, dm.min_value, dm.max_value});
 
     const uint seed = 0;
-    const auto work_group_pattern = generateWorkGroupPattern(seed);
 
-    SECTION("CPU single-thread")
+    SECTION("CPU pipeline")
     {
-        const auto single_thread_placement = [&](glm::vec2 upper_bound)
+        cpu::PlacementPipeline pipeline;
+        pipeline.setRandomSeed(seed);
+
+        // a single region on a single thread, with each kernel of the pipeline.
+        const auto cpu_pipeline_placement = [&](float bounds)
         {
-            auto result = computePlacement(std::execution::seq, world_data, layer_data, {0, 0}, upper_bound,
-                                           work_group_pattern.first, work_group_pattern.second,
-                                           heightmap_image, densitymaps);
-            CHECK(!result.empty());
+            auto result = pipeline.computePlacement(cpu_world_data, cpu_layer_data, {0, 0}, {bounds, bounds})
+                    .readResult();
+            CHECK(result.getElementArrayLength() > 0);
             return result;
         };
 
-        BENCHMARK("10x10 Single-thread CPU placement")
-                    { return single_thread_placement({10, 10}); };
-        BENCHMARK("100x100 Single-thread CPU placement")
-                    { return single_thread_placement({100, 100}); };
-        BENCHMARK("500x500 Single-thread CPU placement")
-                    { return single_thread_placement({500, 500}); };
-        BENCHMARK("1000x1000 Single-thread CPU placement")
-                    { return single_thread_placement({1000, 1000}); };
+        const std::pair<cpu::InstructionSet, std::string> instruction_sets[]
+                {{cpu::InstructionSet::scalar, "scalar"}, {cpu::InstructionSet::sse4_1, "SSE4.1"},
+                 {cpu::InstructionSet::avx2, "AVX2"}};
+
+        for (const auto &[instruction_set, name] : instruction_sets)
+        {
+            if (instruction_set > cpu::getSupportedInstructionSet())
+                continue;
+
+            pipeline.setInstructionSet(instruction_set);
+
+            for (const float bounds : {10.f, 100.f, 500.f, 1000.f})
+            {
+                const std::string benchmark_name = std::to_string(static_cast<int>(bounds)) + "x"
+                                                   + std::to_string(static_cast<int>(bounds))
+                                                   + " CPU pipeline placement (" + name + ")";
+                BENCHMARK(benchmark_name.c_str())
+                            { return cpu_pipeline_placement(bounds); };
+            }
+        }
 
-        SUCCEED("CPU single-thread benchmark finished");
+        SUCCEED("CPU pipeline benchmark finished");
     }
 
-#ifdef PLACEMENT_BENCHMARK_MULTITHREAD
     SECTION("CPU multi-thread")
     {
+        cpu::PlacementPipeline pipeline;
+        pipeline.setRandomSeed(seed);
+
+        // one part of the region per hardware thread, each of them placed on a thread of its own by the pipeline.
+        const uint split = std::max(1u, static_cast<uint>(std::sqrt(std::thread::hardware_concurrency())));
+
         const auto multi_thread_placement = [&](float bounds)
         {
-            auto result = computePlacement(std::execution::par_unseq, world_data, layer_data, {0, 0}, {bounds, bounds},
-                                           work_group_pattern.first, work_group_pattern.second,
-                                           heightmap_image, densitymaps);
-            CHECK(!result.empty());
-            return result;
+            const float part_size = bounds / static_cast<float>(split);
+
+            std::vector<cpu::FutureResult> future_results;
+            for (uint i = 0; i < split; i++)
+                for (uint j = 0; j < split; j++)
+                    future_results.push_back(pipeline.computePlacement(cpu_world_data, cpu_layer_data,
+                                                                       glm::vec2(i, j) * part_size,
+                                                                       glm::vec2(i + 1, j + 1) * part_size));
+
+            std::size_t element_count = 0;
+            for (auto &future_result : future_results)
+                element_count += future_result.readResult().getElementArrayLength();
+            CHECK(element_count > 0);
+            return element_count;
         };
 
         BENCHMARK("10x10 Multi-thread CPU placement")
@@ -1505,7 +3039,6 @@ TEST_CASE("Benchmark", "[.][benchmark]")
 
         SUCCEED("CPU multi-thread benchmark finished");
     }
-#endif
 
     SECTION("GPU")
     {
@@ -1541,11 +3074,92 @@ TEST_CASE("Benchmark", "[.][benchmark]")
         BENCHMARK("1000x1000 GPU placement")
                     { return gpu_placement(1000); };
 
+        // small regions that are not aligned to the work group grid, as used when streaming cells around a camera.
+        const auto gpu_tile_placement = [&](float tile_size)
+        {
+            std::size_t element_count = 0;
+            for (uint i = 0; i < 8; i++)
+                for (uint j = 0; j < 8; j++)
+                {
+                    const glm::vec2 lower_bound = glm::vec2(i, j) * tile_size * 1.37f + 3.3f;
+                    element_count += pipeline.computePlacement(world_data, layer_data, lower_bound,
+                                                               lower_bound + tile_size)
+                            .readResult().getElementArrayLength();
+                }
+            return element_count;
+        };
+
+        BENCHMARK("8x8 tiles of 4x4 GPU placement")
+                    { return gpu_tile_placement(4); };
+        BENCHMARK("8x8 tiles of 16x16 GPU placement")
+                    { return gpu_tile_placement(16); };
+        BENCHMARK("8x8 tiles of 64x64 GPU placement")
+                    { return gpu_tile_placement(64); };
+
         SUCCEED("PlacementPipeline benchmark finished");
     }
 
+    SECTION("GPU indexation")
+    {
+        constexpr GLuint candidate_count = 1u << 20;
+        constexpr GLuint class_count = 10;
+
+        // about half the candidates are rejected, the others are spread over all the classes.
+        std::default_random_engine generator {seed};
+        std::uniform_int_distribution<GLuint> class_distribution {0, 2 * class_count - 1};
+        std::vector<Result::Element> candidates (candidate_count);
+        for (auto &candidate : candidates)
+        {
+            const GLuint class_index = class_distribution(generator);
+            candidate = {glm::vec3(0.0f), class_index < class_count ? class_index : 0xFFffFFff};
+        }
+
+        constexpr GLsizeiptr candidate_size = candidate_count * sizeof(Result::Element);
+        constexpr GLsizeiptr index_size = candidate_count * sizeof(GLuint);
+        constexpr GLsizeiptr count_size = class_count * sizeof(GLuint);
+
+        // separate buffers, so that no range has to be aligned to GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+        GL::Buffer candidate_buffer;
+        GL::Buffer index_buffer;
+        GL::Buffer count_buffer;
+        candidate_buffer.allocateImmutable(candidate_size, GL::BufferHandle::StorageFlags::none, candidates.data());
+        index_buffer.allocateImmutable(index_size, GL::BufferHandle::StorageFlags::none);
+        count_buffer.allocateImmutable(count_size, GL::BufferHandle::StorageFlags::none);
+
+        candidate_buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, 0, {0, candidate_size});
+        index_buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, 1, {0, index_size});
+        count_buffer.bindRange(GL::BufferHandle::IndexedTarget::shader_storage, 2, {0, count_size});
+
+        const auto benchmark_indexation = [&](const char *name, bool subgroup_indexation)
+        {
+            KernelConfiguration configuration;
+            configuration.subgroup_indexation = subgroup_indexation;
+            IndexationKernel kernel {configuration};
+            REQUIRE(kernel.usesSubgroups() == subgroup_indexation);
+
+            BENCHMARK(name)
+            {
+                gl.ClearNamedBufferData(count_buffer.getName(), GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+                kernel(kernel.calculateNumWorkGroups(candidate_count), 0, 2, 1);
+                gl.Finish();
+            };
+        };
+
+        benchmark_indexation("1M candidates, 10 classes, shared memory scan indexation", false);
+
+        if (IndexationKernel::isSubgroupIndexationSupported())
+            benchmark_indexation("1M candidates, 10 classes, subgroup indexation", true);
+        else
+            WARN("GL_KHR_shader_subgroup is not supported, skipping the subgroup indexation benchmark");
+
+        SUCCEED("Indexation benchmark finished");
+    }
+
     SECTION("CPU Poisson")
     {
+        const WorkGroupPattern work_group_pattern = generateWorkGroupPattern(seed,
+                                                                             KernelConfiguration::default_pattern_size);
+
         const auto poisson_placement = [&](float bounds)
         {
             DiskDistributionGenerator disk_generator{layer_data.footprint,
@@ -1561,7 +3175,7 @@ TEST_CASE("Benchmark", "[.][benchmark]")
             std::vector<Result::Element> elements;
 
             const auto work_group_linear_density =
-                    glm::vec2(GenerationKernel::work_group_size) / work_group_pattern.first;
+                    glm::vec2(KernelConfiguration::default_pattern_size) / work_group_pattern.scale;
             const auto expected_elements_by_axis = work_group_linear_density * glm::vec2(world_data.scale);
             const std::size_t expected_elements = expected_elements_by_axis.x * expected_elements_by_axis.y;
 